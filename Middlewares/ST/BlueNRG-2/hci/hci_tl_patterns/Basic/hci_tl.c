@@ -19,6 +19,7 @@
 #include "hci_const.h"
 #include "hci.h"
 #include "hci_tl.h"
+#include "compiler.h"
 
 #define HCI_LOG_ON                      0
 #define HCI_PCK_TYPE_OFFSET             0
@@ -166,7 +167,28 @@ void hci_register_io_bus(tHciIO* fops)
   hciContext.io.Reset   = fops->Reset;
 }
 
+WEAK_FUNCTION(uint32_t hci_tl_timing_start(void))
+{
+  return 0;
+}
+
+WEAK_FUNCTION(void hci_tl_timing_stop(uint8_t Section, uint32_t Start))
+{
+}
+
+static int hci_send_req_untimed(struct hci_request* r, BOOL async);
+
 int hci_send_req(struct hci_request* r, BOOL async)
+{
+  int ret;
+  uint32_t Start = hci_tl_timing_start();
+
+  ret = hci_send_req_untimed(r, async);
+  hci_tl_timing_stop(HCI_TL_TIMING_SEND_REQ, Start);
+  return ret;
+}
+
+static int hci_send_req_untimed(struct hci_request* r, BOOL async)
 {
   uint8_t *ptr;
   uint16_t opcode = htobs(cmd_opcode_pack(r->ogf, r->ocf));
@@ -309,6 +331,7 @@ done:
 void hci_user_evt_proc(void)
 {
   tHciDataPacket * hciReadPacket = NULL;
+  uint32_t Start = hci_tl_timing_start();
      
   /* process any pending events read */
   while (list_is_empty(&hciReadPktRxQueue) == FALSE)
@@ -322,6 +345,7 @@ void hci_user_evt_proc(void)
 
     list_insert_tail(&hciReadPktPool, (tListNode *)hciReadPacket);
   }
+  hci_tl_timing_stop(HCI_TL_TIMING_USER_EVT_PROC, Start);
 }
 
 int32_t hci_notify_asynch_evt(void* pdata)
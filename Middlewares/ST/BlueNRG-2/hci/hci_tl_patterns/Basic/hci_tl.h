@@ -136,6 +136,29 @@ typedef struct
   */
 int hci_send_req(struct hci_request *r, BOOL async);
  
+/* Sections of the timing hooks */
+#define HCI_TL_TIMING_SEND_REQ       0
+#define HCI_TL_TIMING_USER_EVT_PROC  1
+
+/**
+  * @brief  Timing hook called at the beginning of hci_send_req and hci_user_evt_proc.
+  *         The default one is empty (weak): it can be redefined e.g. for profiling
+  *
+  * @param  None
+  * @retval uint32_t: timestamp given back to hci_tl_timing_stop
+  */
+uint32_t hci_tl_timing_start(void);
+
+/**
+  * @brief  Timing hook called at the end of hci_send_req and hci_user_evt_proc.
+  *         The default one is empty (weak): it can be redefined e.g. for profiling
+  *
+  * @param  Section: HCI_TL_TIMING_SEND_REQ or HCI_TL_TIMING_USER_EVT_PROC
+  * @param  Start: timestamp returned by hci_tl_timing_start
+  * @retval None
+  */
+void hci_tl_timing_stop(uint8_t Section, uint32_t Start);
+
 /**
  * @brief  Register IO bus services.
  *         The tHciIO structure is initialized here by assigning to each structure field a  
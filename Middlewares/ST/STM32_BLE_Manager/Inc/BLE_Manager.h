@@ -30,6 +30,11 @@
 #include <stdlib.h>
 
 #include "BLE_Manager_Conf.h"
+#include "BLE_ManagerProfiling.h"
+
+#ifdef BLE_MANAGER_RTOS
+  #include "cmsis_os.h"
+#endif /* BLE_MANAGER_RTOS */
    
 #ifndef BLE_MANAGER_NO_PARSON
   #include "parson.h"
@@ -73,11 +78,13 @@
   #include "ble_l2cap_aci.h"
 #else /* BLUENRG_1_2 */
   #include "hci.h"
+  #include "hci_tl.h"
   #include "bluenrg1_hal_aci.h"
   #include "bluenrg1_gatt_aci.h"
   #include "bluenrg1_gap_aci.h"
   #include "bluenrg1_hci_le.h"
   #include "bluenrg1_l2cap_aci.h"
+  #include "bluenrg1_events.h"
 #endif /* (BLUE_CORE == BLUENRG_MS) */
 
 /* Exported Defines ----------------------------------------------------------*/
@@ -178,6 +185,24 @@
 #ifndef MIN
 #define MIN(a,b)            ((a) < (b) )? (a) : (b)
 #endif
+
+#ifdef BLE_MANAGER_STATS
+#ifdef BLE_MANAGER_PROFILING
+  /* The updates latency is measured with the DWT cycle counter when it's available */
+  #define BLE_MANAGER_STATS_LATENCY() BLE_PROFILE_TIMESTAMP()
+  #define BLE_MANAGER_STATS_LATENCY_UNIT BLE_PROFILE_UNIT
+#else /* BLE_MANAGER_PROFILING */
+  /* Free running counter used for the updates latency (not measured if it's not defined) */
+  #ifndef BLE_MANAGER_STATS_TIMESTAMP
+    #define BLE_MANAGER_STATS_TIMESTAMP() 0U
+  #endif /* BLE_MANAGER_STATS_TIMESTAMP */
+  #ifndef BLE_MANAGER_STATS_TIMESTAMP_UNIT
+    #define BLE_MANAGER_STATS_TIMESTAMP_UNIT "ms, coarse"
+  #endif /* BLE_MANAGER_STATS_TIMESTAMP_UNIT */
+  #define BLE_MANAGER_STATS_LATENCY() BLE_MANAGER_STATS_TIMESTAMP()
+  #define BLE_MANAGER_STATS_LATENCY_UNIT BLE_MANAGER_STATS_TIMESTAMP_UNIT
+#endif /* BLE_MANAGER_PROFILING */
+#endif /* BLE_MANAGER_STATS */
    
 /* Exported Types ------------------------------------------------------------*/
    
@@ -246,6 +271,33 @@ typedef struct
   
 } BLE_StackTypeDef;
 
+#ifdef BLE_MANAGER_STATS
+/* Runtime counters of the updates of one characteristic */
+typedef struct
+{
+  uint32_t UpdatesAttempted;
+  uint32_t UpdatesSucceeded;
+  /* Updates rejected for BLE_STATUS_INSUFFICIENT_RESOURCES */
+  uint32_t InsufficientResources;
+  uint32_t BytesSent;
+  /* Consecutive rejected updates (current value and high-water mark) */
+  uint16_t PendingUpdates;
+  uint16_t PendingHighWater;
+  /* Duration of the last update sent to the controller (BLE_MANAGER_STATS_LATENCY_UNIT units) */
+  uint32_t LastUpdateLatency;
+} BLE_CharStats_t;
+
+/* Runtime counters of the HCI layer */
+typedef struct
+{
+  uint32_t HciEvents;
+  /* HCI read packets pool exhausted on event reception */
+  uint32_t HciRxPoolExhausted;
+  uint32_t TxPoolAvailableEvents;
+  uint32_t EventsLost;
+} BLE_HciStats_t;
+#endif /* BLE_MANAGER_STATS */
+
 typedef struct
 {
   // BLE Char Definition
@@ -284,6 +336,10 @@ typedef struct
 #endif /* (BLUE_CORE != BLUENRG_LP) */
   // Write Request
   void (*Write_Request_CB)(void *BleCharPointer,uint16_t attr_handle, uint16_t Offset, uint8_t data_length, uint8_t *att_data);
+#ifdef BLE_MANAGER_STATS
+  // Runtime counters
+  BLE_CharStats_t Stats;
+#endif /* BLE_MANAGER_STATS */
 } BleCharTypeDef;
 
 //Enum type for Service Notification Change
@@ -397,6 +453,614 @@ typedef struct
 }
 COM_Sensor_t;
 
+/* Sensor descriptor serialized at compile time, for keeping it in flash instead of filling a
+ * COM_SensorDescriptor_t (to use with create_JSON_SensorFromDescriptor). Example:
+ *   static const char LPS22HH_Descriptor[] = BLE_SENSOR_DESCRIPTOR_JSON(1,"lps22hh",
+ *     BLE_SUBSENSOR_DESCRIPTOR_JSON(0,PRESS,1,BLE_JSON_LIST("prs"),"hPa",float,
+ *                                   BLE_JSON_LIST(1260),BLE_JSON_LIST(1,10,25,50,75,100,200),0,1000),
+ *     BLE_SUBSENSOR_DESCRIPTOR_JSON(1,TEMP,1,BLE_JSON_LIST("tem"),"Celsius",float,
+ *                                   BLE_JSON_LIST(85),BLE_JSON_LIST(1,10,25,50,75,100,200),0,1000));
+ * Numbers must be written as JSON numbers (so without the f suffix) */
+#define BLE_JSON_LIST(...) #__VA_ARGS__
+
+#define BLE_SUBSENSOR_DESCRIPTOR_JSON(Id,SensorType,Dimensions,DimensionsLabel,Unit,DataType,FS,ODR,MinSamplesPerTs,MaxSamplesPerTs) \
+  "{\"id\":" #Id ",\"sensorType\":\"" #SensorType "\",\"dimensions\":" #Dimensions \
+  ",\"dimensionsLabel\":[" DimensionsLabel "],\"unit\":\"" Unit "\",\"dataType\":\"" #DataType \
+  "\",\"FS\":[" FS "],\"ODR\":[" ODR "],\"samplesPerTs\":{\"min\":" #MinSamplesPerTs \
+  ",\"max\":" #MaxSamplesPerTs ",\"dataType\":\"int16_t\"}}"
+
+/* From 1 up to N_MAX_SENSOR_COMBO sub sensors */
+#define BLE_SENSOR_DESCRIPTOR_JSON(Id,Name,...) \
+  "{\"id\":" #Id ",\"name\":\"" Name "\",\"sensorDescriptor\":{\"subSensorDescriptor\":[" \
+  BLE_JSON_JOIN(__VA_ARGS__) "]}"
+
+#define BLE_JSON_JOIN(...) BLE_JSON_JOIN_SELECT(__VA_ARGS__,BLE_JSON_JOIN_4,BLE_JSON_JOIN_3,BLE_JSON_JOIN_2,BLE_JSON_JOIN_1,)(__VA_ARGS__)
+#define BLE_JSON_JOIN_SELECT(_1,_2,_3,_4,Join,...) Join
+#define BLE_JSON_JOIN_1(a) a
+#define BLE_JSON_JOIN_2(a,b) a "," b
+#define BLE_JSON_JOIN_3(a,b,c) a "," b "," c
+#define BLE_JSON_JOIN_4(a,b,c,d) a "," b "," c "," d
+
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+/* Growable buffer used for CBOR encoding */
+typedef struct
+{
+  uint8_t *Buffer;
+  uint32_t Size;
+  uint32_t Length;
+  uint8_t Error;
+} BLE_CborWriter_t;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+
+#ifndef BLE_MANAGER_NO_PARSON
+/* Serialized ReadSensorsConfig answer built from the descriptors kept in flash */
+typedef struct
+{
+  JSON_Growable_Buffer Json;
+  uint8_t Error;
+} BLE_JsonWriter_t;
+#endif /* BLE_MANAGER_NO_PARSON */
+
+#ifdef BLE_MANAGER_STATIC_POOLS
+/* Default dimensions of the fixed-size blocks pools used instead of the heap
+ * (the block sizes must be multiple of 8 bytes) */
+#ifndef BLE_POOL_SMALL_BLOCK_SIZE
+  #define BLE_POOL_SMALL_BLOCK_SIZE 32U
+#endif /* BLE_POOL_SMALL_BLOCK_SIZE */
+#ifndef BLE_POOL_SMALL_BLOCKS
+  #define BLE_POOL_SMALL_BLOCKS 96U
+#endif /* BLE_POOL_SMALL_BLOCKS */
+#ifndef BLE_POOL_MEDIUM_BLOCK_SIZE
+  #define BLE_POOL_MEDIUM_BLOCK_SIZE 128U
+#endif /* BLE_POOL_MEDIUM_BLOCK_SIZE */
+#ifndef BLE_POOL_MEDIUM_BLOCKS
+  #define BLE_POOL_MEDIUM_BLOCKS 24U
+#endif /* BLE_POOL_MEDIUM_BLOCKS */
+#ifndef BLE_POOL_LARGE_BLOCK_SIZE
+  #define BLE_POOL_LARGE_BLOCK_SIZE 2048U
+#endif /* BLE_POOL_LARGE_BLOCK_SIZE */
+#ifndef BLE_POOL_LARGE_BLOCKS
+  #define BLE_POOL_LARGE_BLOCKS 4U
+#endif /* BLE_POOL_LARGE_BLOCKS */
+
+/* Number of pools (Small/Medium/Large) */
+#define BLE_POOL_NUMBER 3U
+
+/* Usage statistics of one blocks pool */
+typedef struct
+{
+  uint32_t BlockSize;
+  uint32_t Blocks;
+  uint32_t UsedBlocks;
+  uint32_t MaxUsedBlocks;
+  /* Requests served by this pool because the smaller one was exhausted */
+  uint32_t FallbackAllocs;
+  /* Requests of this pool size class that were not served */
+  uint32_t AllocFailures;
+} BLE_PoolStats_t;
+#endif /* BLE_MANAGER_STATIC_POOLS */
+
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+/* Value written in the free stack and heap words */
+#ifndef BLE_MEM_PAINT_PATTERN
+  #define BLE_MEM_PAINT_PATTERN 0xC5C5C5C5U
+#endif /* BLE_MEM_PAINT_PATTERN */
+
+/* Bytes below the current stack pointer that are never painted */
+#ifndef BLE_MEM_STACK_GUARD
+  #define BLE_MEM_STACK_GUARD 64U
+#endif /* BLE_MEM_STACK_GUARD */
+
+/* Phases with their own high-water marks */
+typedef enum
+{
+  /* Everything since BLE_MemPaint or the last BLE_MemReset */
+  BLE_MEM_PHASE_ALL = 0,
+  BLE_MEM_PHASE_INIT,
+  BLE_MEM_PHASE_CONNECTION,
+  BLE_MEM_PHASE_EXTCONFIG,
+
+  //Total Number of phases
+  BLE_MEM_PHASES_NUMBER
+} BLE_MemPhaseType;
+
+/* High-water marks of one phase (bytes) */
+typedef struct
+{
+  uint32_t StackSize;
+  uint32_t StackUsed;
+  uint32_t HeapSize;
+  uint32_t HeapUsed;
+  /* The lowest stack word was overwritten: the stack could have overflowed */
+  uint8_t StackOverflow;
+} BLE_MemWatermark_t;
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+#if (BLUE_CORE == BLUENRG_LP)
+  #error "BLE_MANAGER_ADAPTIVE_ADVERTISING is not supported on BlueNRG-LP"
+#endif /* (BLUE_CORE == BLUENRG_LP) */
+
+#if (defined(BLE_MANAGER_ADV_DIRECTED) && (BLUE_CORE == BLUENRG_MS))
+  #error "BLE_MANAGER_ADV_DIRECTED is not supported on BlueNRG-MS"
+#endif /* (defined(BLE_MANAGER_ADV_DIRECTED) && (BLUE_CORE == BLUENRG_MS)) */
+
+#ifndef BLE_MANAGER_ADV_TICK
+  #error "BLE_MANAGER_ADV_TICK() (milliseconds counter) must be defined for BLE_MANAGER_ADAPTIVE_ADVERTISING"
+#endif /* BLE_MANAGER_ADV_TICK */
+
+/* Duration (ms) of the fast advertising (BLE_StackValue.AdvIntervalMin/Max intervals) */
+#ifndef BLE_ADV_FAST_DURATION
+  #define BLE_ADV_FAST_DURATION 30000U
+#endif /* BLE_ADV_FAST_DURATION */
+
+/* Intervals (0.625 ms units) and duration (ms) of the medium advertising */
+#ifndef BLE_ADV_MEDIUM_INTERVAL_MIN
+  #define BLE_ADV_MEDIUM_INTERVAL_MIN 0x00A0U
+#endif /* BLE_ADV_MEDIUM_INTERVAL_MIN */
+#ifndef BLE_ADV_MEDIUM_INTERVAL_MAX
+  #define BLE_ADV_MEDIUM_INTERVAL_MAX 0x00F0U
+#endif /* BLE_ADV_MEDIUM_INTERVAL_MAX */
+#ifndef BLE_ADV_MEDIUM_DURATION
+  #define BLE_ADV_MEDIUM_DURATION 60000U
+#endif /* BLE_ADV_MEDIUM_DURATION */
+
+/* Intervals (0.625 ms units) of the slow advertising (used until the next connection) */
+#ifndef BLE_ADV_SLOW_INTERVAL_MIN
+  #define BLE_ADV_SLOW_INTERVAL_MIN 0x0640U
+#endif /* BLE_ADV_SLOW_INTERVAL_MIN */
+#ifndef BLE_ADV_SLOW_INTERVAL_MAX
+  #define BLE_ADV_SLOW_INTERVAL_MAX 0x0960U
+#endif /* BLE_ADV_SLOW_INTERVAL_MAX */
+
+/* Steps of the advertising schedule */
+typedef enum
+{
+  /* High duty cycle directed advertising toward the last bonded central (1.28 s) */
+  BLE_ADV_STEP_DIRECTED = 0,
+  /* White list filtered advertising toward the bonded centrals (BLE_MANAGER_FAST_RECONNECT) */
+  BLE_ADV_STEP_RECONNECT,
+  BLE_ADV_STEP_FAST,
+  BLE_ADV_STEP_MEDIUM,
+  BLE_ADV_STEP_SLOW,
+
+  //Total Number of steps
+  BLE_ADV_STEPS_NUMBER
+} BLE_AdvStepType;
+
+/* Advertising metrics */
+typedef struct
+{
+  uint32_t Connections;
+  /* Time (ms) from the start of the advertising to the connection */
+  uint32_t LastTimeToConnect;
+  uint32_t AvgTimeToConnect;
+  uint32_t MaxTimeToConnect;
+  /* Time (ms) spent advertising and observed since the last reset (duty cycle = AdvertisingTime/ObservedTime) */
+  uint32_t AdvertisingTime;
+  uint32_t ObservedTime;
+  /* Estimation of the advertising events sent */
+  uint32_t AdvertisingEvents;
+  BLE_AdvStepType Step;
+} BLE_AdvStats_t;
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+#ifdef BLE_MANAGER_FAST_RECONNECT
+#ifndef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  #error "BLE_MANAGER_FAST_RECONNECT needs BLE_MANAGER_ADAPTIVE_ADVERTISING"
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+#if (BLUE_CORE != BLUENRG_1_2)
+  #error "BLE_MANAGER_FAST_RECONNECT is supported only on BlueNRG-1/2"
+#endif /* (BLUE_CORE != BLUENRG_1_2) */
+
+/* Bonded centrals kept in the reconnect cache */
+#ifndef BLE_RECONNECT_CACHE_SIZE
+  #define BLE_RECONNECT_CACHE_SIZE 4U
+#endif /* BLE_RECONNECT_CACHE_SIZE */
+
+/* Intervals (0.625 ms units) and duration (ms) of the white list filtered advertising */
+#ifndef BLE_ADV_RECONNECT_INTERVAL_MIN
+  #define BLE_ADV_RECONNECT_INTERVAL_MIN 0x0020U
+#endif /* BLE_ADV_RECONNECT_INTERVAL_MIN */
+#ifndef BLE_ADV_RECONNECT_INTERVAL_MAX
+  #define BLE_ADV_RECONNECT_INTERVAL_MAX 0x0030U
+#endif /* BLE_ADV_RECONNECT_INTERVAL_MAX */
+#ifndef BLE_ADV_RECONNECT_DURATION
+  #define BLE_ADV_RECONNECT_DURATION 3000U
+#endif /* BLE_ADV_RECONNECT_DURATION */
+
+/* One bonded central (identity address) */
+typedef struct
+{
+  uint8_t AddressType;
+  uint8_t Address[6];
+} BLE_BondedPeer_t;
+
+/* Reconnect cache (it could be saved in flash with CustomReconnectCacheSave) */
+typedef struct
+{
+  /* The most recently connected central first */
+  BLE_BondedPeer_t Peers[BLE_RECONNECT_CACHE_SIZE];
+  uint8_t PeersNumber;
+} BLE_ReconnectCache_t;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+
+#ifdef BLE_MANAGER_CONN_TUNER
+#if (BLUE_CORE != BLUENRG_1_2)
+  #error "BLE_MANAGER_CONN_TUNER is supported only on BlueNRG-1/2"
+#endif /* (BLUE_CORE != BLUENRG_1_2) */
+
+#ifndef BLE_MANAGER_CONN_TUNER_TICK
+  #error "BLE_MANAGER_CONN_TUNER_TICK() (milliseconds counter) must be defined for BLE_MANAGER_CONN_TUNER"
+#endif /* BLE_MANAGER_CONN_TUNER_TICK */
+
+/* Window (ms) for measuring the notification bytes per second */
+#ifndef BLE_CONN_TUNER_WINDOW
+  #define BLE_CONN_TUNER_WINDOW 1000U
+#endif /* BLE_CONN_TUNER_WINDOW */
+
+/* Rate (bytes/s) for switching to the stream parameters */
+#ifndef BLE_CONN_TUNER_STREAM_RATE
+  #define BLE_CONN_TUNER_STREAM_RATE 2000U
+#endif /* BLE_CONN_TUNER_STREAM_RATE */
+
+/* Rate (bytes/s) under which the traffic is idle and windows of idle traffic for switching to the idle parameters */
+#ifndef BLE_CONN_TUNER_IDLE_RATE
+  #define BLE_CONN_TUNER_IDLE_RATE 200U
+#endif /* BLE_CONN_TUNER_IDLE_RATE */
+#ifndef BLE_CONN_TUNER_IDLE_WINDOWS
+  #define BLE_CONN_TUNER_IDLE_WINDOWS 5U
+#endif /* BLE_CONN_TUNER_IDLE_WINDOWS */
+
+/* Stream parameters: intervals (1.25 ms units), slave latency and supervision timeout (10 ms units) */
+#ifndef BLE_CONN_STREAM_INTERVAL_MIN
+  #define BLE_CONN_STREAM_INTERVAL_MIN 0x000CU
+#endif /* BLE_CONN_STREAM_INTERVAL_MIN */
+#ifndef BLE_CONN_STREAM_INTERVAL_MAX
+  #define BLE_CONN_STREAM_INTERVAL_MAX 0x0018U
+#endif /* BLE_CONN_STREAM_INTERVAL_MAX */
+#ifndef BLE_CONN_STREAM_LATENCY
+  #define BLE_CONN_STREAM_LATENCY 0U
+#endif /* BLE_CONN_STREAM_LATENCY */
+#ifndef BLE_CONN_STREAM_TIMEOUT
+  #define BLE_CONN_STREAM_TIMEOUT 400U
+#endif /* BLE_CONN_STREAM_TIMEOUT */
+
+/* Idle parameters: intervals (1.25 ms units), slave latency and supervision timeout (10 ms units) */
+#ifndef BLE_CONN_IDLE_INTERVAL_MIN
+  #define BLE_CONN_IDLE_INTERVAL_MIN 0x0050U
+#endif /* BLE_CONN_IDLE_INTERVAL_MIN */
+#ifndef BLE_CONN_IDLE_INTERVAL_MAX
+  #define BLE_CONN_IDLE_INTERVAL_MAX 0x0060U
+#endif /* BLE_CONN_IDLE_INTERVAL_MAX */
+#ifndef BLE_CONN_IDLE_LATENCY
+  #define BLE_CONN_IDLE_LATENCY 4U
+#endif /* BLE_CONN_IDLE_LATENCY */
+#ifndef BLE_CONN_IDLE_TIMEOUT
+  #define BLE_CONN_IDLE_TIMEOUT 600U
+#endif /* BLE_CONN_IDLE_TIMEOUT */
+
+/* First and max wait (ms) before repeating a request refused by the central (doubled at each refusal) */
+#ifndef BLE_CONN_TUNER_RETRY_MIN
+  #define BLE_CONN_TUNER_RETRY_MIN 2000U
+#endif /* BLE_CONN_TUNER_RETRY_MIN */
+#ifndef BLE_CONN_TUNER_RETRY_MAX
+  #define BLE_CONN_TUNER_RETRY_MAX 64000U
+#endif /* BLE_CONN_TUNER_RETRY_MAX */
+
+/* Connection parameters profiles */
+typedef enum
+{
+  /* Parameters chosen by the central */
+  BLE_CONN_PROFILE_CENTRAL = 0,
+  BLE_CONN_PROFILE_STREAM,
+  BLE_CONN_PROFILE_IDLE,
+
+  //Total Number of profiles
+  BLE_CONN_PROFILES_NUMBER
+} BLE_ConnProfileType;
+
+/* Connection parameters tuner metrics */
+typedef struct
+{
+  /* Current connection parameters (1.25 ms, connection events and 10 ms units) */
+  uint16_t ConnInterval;
+  uint16_t ConnLatency;
+  uint16_t SupervisionTimeout;
+  /* Last profile accepted by the central */
+  BLE_ConnProfileType Profile;
+  /* Notification bytes per second queued in the last window */
+  uint32_t Rate;
+  uint32_t Requests;
+  uint32_t Accepted;
+  uint32_t Rejected;
+  /* Requests without answer from the central within 30 s */
+  uint32_t Timeouts;
+} BLE_ConnTunerStats_t;
+#endif /* BLE_MANAGER_CONN_TUNER */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+#if (BLUE_CORE != BLUENRG_1_2)
+  #error "BLE_MANAGER_RADIO_SYNC is supported only on BlueNRG-1/2"
+#endif /* (BLUE_CORE != BLUENRG_1_2) */
+
+/* Max number of notifications queued between two connection events */
+#ifndef BLE_RADIO_SYNC_QUEUE_SIZE
+  #define BLE_RADIO_SYNC_QUEUE_SIZE 8U
+#endif /* BLE_RADIO_SYNC_QUEUE_SIZE */
+
+/* Bytes for the values of the queued notifications */
+#ifndef BLE_RADIO_SYNC_QUEUE_BYTES
+  #define BLE_RADIO_SYNC_QUEUE_BYTES 512U
+#endif /* BLE_RADIO_SYNC_QUEUE_BYTES */
+
+/* aci_hal_set_radio_activity_mask bit of the connection events as slave */
+#define BLE_RADIO_SYNC_ACTIVITY_MASK 0x0004U
+/* aci_hal_end_of_radio_activity_event state of the connection events as slave */
+#define BLE_RADIO_SYNC_CONNECTION_EVENT 0x02U
+
+/* Notifications queue metrics */
+typedef struct
+{
+  uint32_t ConnectionEvents;
+  uint32_t Queued;
+  /* Updates refused because the queue was full */
+  uint32_t QueueFull;
+  uint32_t Sent;
+  /* Flushes stopped by the controller buffer full (the remaining ones wait the next event) */
+  uint32_t Deferred;
+  /* Max notifications sent after one connection event */
+  uint32_t MaxBurst;
+  /* Max queued notifications */
+  uint32_t HighWater;
+} BLE_RadioSyncStats_t;
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
+#ifdef BLE_MANAGER_TX_CREDITS
+#if (BLUE_CORE != BLUENRG_1_2)
+  #error "BLE_MANAGER_TX_CREDITS is supported only on BlueNRG-1/2"
+#endif /* (BLUE_CORE != BLUENRG_1_2) */
+
+/* ATT notification header (3 bytes) and L2CAP header (4 bytes) */
+#define BLE_TX_CREDITS_HEADERS 7U
+
+/* Controller buffer accounting metrics */
+typedef struct
+{
+  /* From hci_le_read_buffer_size (0 if it failed: no accounting) */
+  uint16_t AclLength;
+  uint16_t Total;
+  uint16_t Available;
+  uint16_t MinAvailable;
+  /* Packets given to the controller and reported completed */
+  uint32_t Consumed;
+  uint32_t Completed;
+  /* Updates not sent because the controller buffer was full */
+  uint32_t Skipped;
+  /* Insufficient resources errors with free credits (the count is realigned) */
+  uint32_t Resyncs;
+} BLE_TxCreditsStats_t;
+#endif /* BLE_MANAGER_TX_CREDITS */
+
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+#ifndef BLE_MANAGER_DEFERRED_TICK
+  #error "BLE_MANAGER_DEFERRED_TICK() (milliseconds counter) must be defined for BLE_MANAGER_DEFERRED_WRITES"
+#endif /* BLE_MANAGER_DEFERRED_TICK */
+
+/* Max number of write requests waiting BLE_DeferredProcess (when it is full they are run immediately) */
+#ifndef BLE_DEFERRED_JOBS
+  #define BLE_DEFERRED_JOBS 4U
+#endif /* BLE_DEFERRED_JOBS */
+
+/* Max length of one write request */
+#ifndef BLE_DEFERRED_DATA_SIZE
+  #define BLE_DEFERRED_DATA_SIZE DEFAULT_MAX_CHAR_LEN
+#endif /* BLE_DEFERRED_DATA_SIZE */
+
+/* Default time budget (ms) of one BLE_DeferredProcess call */
+#ifndef BLE_DEFERRED_BUDGET
+  #define BLE_DEFERRED_BUDGET 10U
+#endif /* BLE_DEFERRED_BUDGET */
+
+/* Deferred writes metrics */
+typedef struct
+{
+  uint32_t Posted;
+  uint32_t Executed;
+  /* Run inside the HCI event because the queue was full */
+  uint32_t Inline;
+  /* Max queued write requests */
+  uint32_t HighWater;
+  /* Max time (ms) from the event to the execution and max execution time (ms) */
+  uint32_t MaxWait;
+  uint32_t MaxRun;
+  /* Discarded at the disconnection */
+  uint32_t Discarded;
+} BLE_DeferredStats_t;
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+
+#ifdef BLE_MANAGER_FAST_BOOT
+#if (BLUE_CORE != BLUENRG_1_2)
+  #error "BLE_MANAGER_FAST_BOOT is supported only on BlueNRG-1/2"
+#endif /* (BLUE_CORE != BLUENRG_1_2) */
+
+#ifndef BLE_MANAGER_BOOT_TICK
+  #error "BLE_MANAGER_BOOT_TICK() (milliseconds counter) must be defined for BLE_MANAGER_FAST_BOOT"
+#endif /* BLE_MANAGER_BOOT_TICK */
+
+/* Max wait (ms) of the BlueNRG initialized event after its reset (it was the fixed delay) */
+#ifndef BLE_BOOT_READY_TIMEOUT
+  #define BLE_BOOT_READY_TIMEOUT 2000U
+#endif /* BLE_BOOT_READY_TIMEOUT */
+
+/* Phases from InitBleManager to the first advertising */
+typedef enum
+{
+  /* HCI transport layer init and BlueNRG hardware reset */
+  BLE_BOOT_PHASE_HCI_INIT = 0,
+  /* Wait of the BlueNRG initialized event */
+  BLE_BOOT_PHASE_STACK_READY,
+  /* Address, GATT/GAP init, security and tx power */
+  BLE_BOOT_PHASE_STACK_CONFIG,
+  /* BLE Manager and custom services */
+  BLE_BOOT_PHASE_SERVICES,
+  /* From the end of InitBleManager to the first setConnectable */
+  BLE_BOOT_PHASE_MAIN_LOOP,
+  BLE_BOOT_PHASE_ADVERTISING,
+
+  //Total Number of phases
+  BLE_BOOT_PHASES_NUMBER
+} BLE_BootPhaseType;
+
+/* Boot report */
+typedef struct
+{
+  /* InitBleManager call (BLE_MANAGER_BOOT_TICK value) */
+  uint32_t StartTick;
+  /* End of each phase (ms from StartTick) */
+  uint32_t PhaseEnd[BLE_BOOT_PHASES_NUMBER];
+  /* Reason code of the BlueNRG initialized event */
+  uint8_t ReadyReason;
+  /* The BlueNRG initialized event was not received within BLE_BOOT_READY_TIMEOUT */
+  uint8_t ReadyTimeout;
+  /* Number of completed phases (BLE_BOOT_PHASES_NUMBER when the first advertising is started) */
+  uint8_t PhasesDone;
+} BLE_BootReport_t;
+#endif /* BLE_MANAGER_FAST_BOOT */
+
+#ifdef BLE_MANAGER_STACK_RECOVERY
+#ifndef BLE_MANAGER_FAST_BOOT
+  #error "BLE_MANAGER_STACK_RECOVERY needs BLE_MANAGER_FAST_BOOT"
+#endif /* BLE_MANAGER_FAST_BOOT */
+
+/* Disconnection reason given to the application for the connection lost by the recovery (Connection Timeout) */
+#define BLE_RECOVERY_DISCONNECT_REASON 0x08U
+
+/* BLE stack recovery metrics */
+typedef struct
+{
+  uint32_t HardwareErrors;
+  /* BlueNRG initialized events after the BLE Manager init (BlueNRG self reset) */
+  uint32_t ControllerResets;
+  uint32_t CrashInfos;
+  uint32_t Recoveries;
+  uint32_t Failures;
+  uint8_t LastHardwareCode;
+  uint8_t LastResetReason;
+  /* Duration (ms) of the last recovery */
+  uint32_t LastDuration;
+  /* Characteristics with a different handle after the last recovery (0 expected) */
+  uint32_t HandlesChanged;
+} BLE_RecoveryStats_t;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+
+#ifdef BLE_MANAGER_RTOS
+/* Characteristic updates that could be posted to the BLE task without waiting */
+#ifndef BLE_RTOS_QUEUE_SIZE
+  #define BLE_RTOS_QUEUE_SIZE 8U
+#endif /* BLE_RTOS_QUEUE_SIZE */
+
+/* Max length of one posted characteristic update */
+#ifndef BLE_RTOS_DATA_SIZE
+  #define BLE_RTOS_DATA_SIZE DEFAULT_MAX_CHAR_LEN
+#endif /* BLE_RTOS_DATA_SIZE */
+
+/* Stack of the BLE task in bytes: the Extended Configuration write requests run in this task
+ * (2 KB buffer for the ReadCommand answer, plus parson and printf) */
+#ifndef BLE_RTOS_STACK_SIZE
+  #define BLE_RTOS_STACK_SIZE 4096U
+#endif /* BLE_RTOS_STACK_SIZE */
+
+#ifndef BLE_RTOS_PRIORITY
+  #define BLE_RTOS_PRIORITY osPriorityAboveNormal
+#endif /* BLE_RTOS_PRIORITY */
+
+/* Max time (ms) without running the BLE task (for the BLE Manager timers) */
+#ifndef BLE_RTOS_POLL_TIME
+  #define BLE_RTOS_POLL_TIME 10U
+#endif /* BLE_RTOS_POLL_TIME */
+
+/* Characteristic update posted to the BLE task */
+typedef struct
+{
+  BleCharTypeDef *BleCharPointer;
+  uint8_t charValOffset;
+  uint8_t charValueLen;
+  uint8_t Data[BLE_RTOS_DATA_SIZE];
+} BLE_RtosBuffer_t;
+
+/* BLE task metrics */
+typedef struct
+{
+  /* Updates posted by the other threads */
+  uint32_t Posted;
+  /* Updates lost for buffers or queue full */
+  uint32_t Dropped;
+  /* Posted updates refused by the BlueNRG */
+  uint32_t SendErrors;
+  /* Max number of buffers in use */
+  uint32_t MaxUsed;
+  uint32_t HciNotifications;
+} BLE_RtosStats_t;
+#endif /* BLE_MANAGER_RTOS */
+
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+#ifndef BLE_MANAGER_SAMPLE_TICK
+  #error "BLE_MANAGER_SAMPLE_TICK() (milliseconds counter) must be defined for BLE_MANAGER_SAMPLE_QUEUE"
+#endif /* BLE_MANAGER_SAMPLE_TICK */
+
+#if defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_8M_BASE__)
+  #error "BLE_MANAGER_SAMPLE_QUEUE needs LDREX/STREX (Cortex-M3 or higher)"
+#endif /* defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_8M_BASE__) */
+
+/* Number of samples in the queue (power of 2) */
+#ifndef BLE_SAMPLE_QUEUE_SIZE
+  #define BLE_SAMPLE_QUEUE_SIZE 32U
+#endif /* BLE_SAMPLE_QUEUE_SIZE */
+
+#if ((BLE_SAMPLE_QUEUE_SIZE & (BLE_SAMPLE_QUEUE_SIZE-1U)) != 0U)
+  #error "BLE_SAMPLE_QUEUE_SIZE must be a power of 2"
+#endif /* ((BLE_SAMPLE_QUEUE_SIZE & (BLE_SAMPLE_QUEUE_SIZE-1U)) != 0U) */
+
+/* Bytes of one sample (default: Acc+Gyro+Mag 3 axes int16_t) */
+#ifndef BLE_SAMPLE_SIZE
+  #define BLE_SAMPLE_SIZE 18U
+#endif /* BLE_SAMPLE_SIZE */
+
+/* Max samples given to one CustomSampleBatch call */
+#ifndef BLE_SAMPLE_BATCH
+  #define BLE_SAMPLE_BATCH 8U
+#endif /* BLE_SAMPLE_BATCH */
+
+/* Samples handled by one BLE_SampleProcess call */
+#ifndef BLE_SAMPLE_BUDGET
+  #define BLE_SAMPLE_BUDGET BLE_SAMPLE_QUEUE_SIZE
+#endif /* BLE_SAMPLE_BUDGET */
+
+/* One sample pushed by an interrupt */
+typedef struct
+{
+  uint32_t Timestamp;
+  /* Source of the sample (defined by the application) */
+  uint8_t Channel;
+  uint8_t Data[BLE_SAMPLE_SIZE];
+} BLE_Sample_t;
+
+/* Sample queue metrics */
+typedef struct
+{
+  uint32_t Pushed;
+  /* Samples lost for queue full */
+  uint32_t Dropped;
+  /* Push retried for another interrupt pushing at the same time */
+  uint32_t Retries;
+  uint32_t Batches;
+  /* Max number of queued samples seen by BLE_SampleProcess */
+  uint32_t MaxUsed;
+} BLE_SampleStats_t;
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+
 
 /* Exported Variables ------------------------------------------------------- */
 
@@ -417,6 +1081,10 @@ extern uint8_t manuf_data[BLE_MANAGER_ADVERTISE_DATA_LENGHT];
 extern uint8_t MaxBleCharStdOutLen;
 extern uint8_t MaxBleCharStdErrLen;
 
+#ifdef BLE_MANAGER_STATS
+extern BLE_HciStats_t BLE_HciStats;
+#endif /* BLE_MANAGER_STATS */
+
 extern BLE_ExtCustomCommand_t *ExtConfigCustomCommands;
 extern BLE_ExtCustomCommand_t *ExtConfigLastCustomCommand;
 
@@ -450,6 +1118,42 @@ extern CustomAciGattTxPoolAvailableEvent_t CustomAciGattTxPoolAvailableEvent;
 typedef void (*CustomHardwareErrorEventHandler_t)(uint8_t Hardware_Code);
 extern CustomHardwareErrorEventHandler_t CustomHardwareErrorEventHandler;
 
+#ifdef BLE_MANAGER_FAST_RECONNECT
+/* For saving the reconnect cache in flash when it changes */
+typedef void (*CustomReconnectCacheSave_t)(BLE_ReconnectCache_t *Cache);
+extern CustomReconnectCacheSave_t CustomReconnectCacheSave;
+
+/* For reading the reconnect cache saved in flash (it returns 1 if the saved cache is valid) */
+typedef uint8_t (*CustomReconnectCacheLoad_t)(BLE_ReconnectCache_t *Cache);
+extern CustomReconnectCacheLoad_t CustomReconnectCacheLoad;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+
+#ifdef BLE_MANAGER_STACK_RECOVERY
+/* Called at the end of one BLE stack recovery (for the GATT elements not added by the BLE Manager).
+ * Without this callback a failed recovery resets the MCU */
+typedef void (*CustomStackRecovered_t)(tBleStatus Status);
+extern CustomStackRecovered_t CustomStackRecovered;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+
+#ifdef BLE_MANAGER_RTOS
+/* Called by the BLE task at every loop (the application HCI commands, like setConnectable, must be sent from here) */
+typedef void (*CustomRtosTaskLoop_t)(void);
+extern CustomRtosTaskLoop_t CustomRtosTaskLoop;
+#endif /* BLE_MANAGER_RTOS */
+
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+/* Called by BLE_SampleProcess with consecutive queued samples of the same channel (for sending them with one notification) */
+typedef void (*CustomSampleBatch_t)(uint8_t Channel, BLE_Sample_t *Samples, uint32_t Number);
+extern CustomSampleBatch_t CustomSampleBatch;
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+/* For scheduling the sensors sampling between the connection events
+ * (NextEventSysTime is the start of the next radio activity in BlueNRG system time units) */
+typedef void (*CustomEndOfConnectionEvent_t)(uint32_t NextEventSysTime);
+extern CustomEndOfConnectionEvent_t CustomEndOfConnectionEvent;
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
 /**************** Debug Console *************************/
 typedef uint32_t (*CustomDebugConsoleParsing_t)(uint8_t * att_data, uint8_t data_length);
 extern CustomDebugConsoleParsing_t CustomDebugConsoleParsingCallback;
@@ -544,6 +1248,17 @@ extern CustomExtConfigReadSensorsConfigCommands_t CustomExtConfigReadSensorsConf
 
 typedef void (*CustomExtConfigSetSensorsConfigCommands_t)(uint8_t *Answer);
 extern CustomExtConfigSetSensorsConfigCommands_t CustomExtConfigSetSensorsConfigCommandsCallback;
+
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+//For Sensor Configuration with CBOR encoding (optional, each sensor is added with create_CBOR_Sensor)
+typedef void (*CustomExtConfigReadSensorsConfigCborCommands_t)(BLE_CborWriter_t *Cbor);
+extern CustomExtConfigReadSensorsConfigCborCommands_t CustomExtConfigReadSensorsConfigCborCommandsCallback;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+
+//For Sensor Configuration with the descriptors serialized at compile time (optional, each sensor is added with create_JSON_SensorFromDescriptor,
+//the answer is encoded again with CBOR for a CBOR connection)
+typedef void (*CustomExtConfigReadSensorsConfigStaticCommands_t)(BLE_JsonWriter_t *Json);
+extern CustomExtConfigReadSensorsConfigStaticCommands_t CustomExtConfigReadSensorsConfigStaticCommandsCallback;
 #endif /* BLE_MANAGER_NO_PARSON */
 
 /* Exported functions ------------------------------------------------------- */
@@ -577,6 +1292,7 @@ extern void aci_gatt_indication_event(uint16_t Connection_Handle,
 
 extern tBleStatus Stderr_Update(uint8_t *data,uint8_t length);
 extern tBleStatus Term_Update(uint8_t *data,uint8_t length);
+extern uint8_t    Term_IsCommand(const char *Command, uint8_t data_length, uint8_t *att_data);
 extern tBleStatus Config_Update(uint32_t Feature,uint8_t Command,uint8_t data);
 extern tBleStatus Config_Update_32(uint32_t Feature,uint8_t Command,uint32_t data);
 extern void       setConnectable(void);
@@ -610,14 +1326,366 @@ extern void GenericClearCustomCommandsList(BLE_ExtCustomCommand_t **CustomComman
 #define ClearCustomCommandsList() GenericClearCustomCommandsList(&ExtConfigCustomCommands, &ExtConfigLastCustomCommand)
 
 extern void create_JSON_Sensor(COM_Sensor_t *sensor, JSON_Value *tempJSON);
+extern void create_JSON_SensorFromDescriptor(const char *SensorDescriptor, COM_SensorStatus_t *sensor_status, uint32_t nSubSensors, BLE_JsonWriter_t *Json);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+extern void create_CBOR_Sensor(COM_Sensor_t *sensor, BLE_CborWriter_t *Cbor);
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
 
 extern void SendNewCustomCommandList(void);
 extern void SendError(char *message);
 extern void SendInfo(char *message);
+
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+//Invalidate the cached ReadCommand/ReadCustomCommand/ReadSensorsConfig answers (to call when the sensors configuration changes)
+extern void BLE_ExtConfigInvalidateCachedAnswers(void);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+#define BLE_ExtConfigInvalidateCachedAnswers()
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
 #endif /* BLE_MANAGER_NO_PARSON */
 
 extern uint8_t getBlueNRGVersion(uint8_t *hwVersion, uint16_t *fwVersion);
 
+#ifdef BLE_MANAGER_STATS
+/**
+ * @brief  Reset the HCI counters and the counters of all the characteristics
+ * @param  None
+ * @retval None
+ */
+extern void BLE_StatsReset(void);
+
+/**
+ * @brief  Count one event not received because the HCI read packets pool was exhausted
+ *         (to call from the HCI transport layer interrupt)
+ * @param  None
+ * @retval None
+ */
+extern void BLE_StatsHciRxPoolExhausted(void);
+#endif /* BLE_MANAGER_STATS */
+
+#ifdef BLE_MANAGER_STATIC_POOLS
+/**
+ * @brief  Allocate one block from the smallest pool with free blocks that could contain Size bytes
+ * @param  size_t Size Number of bytes requested
+ * @retval void *Pointer to the block or NULL if there are not free blocks
+ */
+extern void *BLE_PoolMalloc(size_t Size);
+
+/**
+ * @brief  Give back one block allocated with BLE_PoolMalloc (NULL is ignored)
+ * @param  void *Pointer Pointer to the block
+ * @retval None
+ */
+extern void BLE_PoolFree(void *Pointer);
+
+/**
+ * @brief  Read the usage statistics of one blocks pool
+ * @param  uint32_t Pool Pool number (0 Small, 1 Medium, 2 Large)
+ * @param  BLE_PoolStats_t *Stats Pointer to the structure filled with the statistics
+ * @retval uint8_t 1 for valid Pool number, 0 otherwise
+ */
+extern uint8_t BLE_PoolGetStats(uint32_t Pool, BLE_PoolStats_t *Stats);
+#endif /* BLE_MANAGER_STATIC_POOLS */
+
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+/**
+ * @brief  Paint the free stack and the heap for the high-water marks tracking
+ *         (to call at the beginning of main, before any dynamic allocation)
+ * @param  void *HeapStart Lowest address of the heap
+ * @param  void *HeapEnd First address after the heap
+ * @param  void *StackLimit Lowest address of the stack
+ * @param  void *StackTop First address after the stack (initial stack pointer)
+ * @retval None
+ */
+extern void BLE_MemPaint(void *HeapStart, void *HeapEnd, void *StackLimit, void *StackTop);
+
+/**
+ * @brief  Start one phase (the current usage is accounted to the phases already running)
+ * @param  BLE_MemPhaseType Phase phase to start
+ * @retval None
+ */
+extern void BLE_MemPhaseEnter(BLE_MemPhaseType Phase);
+
+/**
+ * @brief  End one phase updating its high-water marks
+ * @param  BLE_MemPhaseType Phase phase to end
+ * @retval None
+ */
+extern void BLE_MemPhaseExit(BLE_MemPhaseType Phase);
+
+/**
+ * @brief  Reset the high-water marks of all the phases and paint again the free stack
+ * @param  None
+ * @retval None
+ */
+extern void BLE_MemReset(void);
+
+/**
+ * @brief  Read the high-water marks of one phase
+ * @param  BLE_MemPhaseType Phase phase to read
+ * @param  BLE_MemWatermark_t *Watermark filled with the high-water marks
+ * @retval uint8_t 1 for valid Phase after BLE_MemPaint, 0 otherwise
+ */
+extern uint8_t BLE_MemGetWatermark(BLE_MemPhaseType Phase, BLE_MemWatermark_t *Watermark);
+
+/**
+ * @brief  Print the high-water marks of all the phases with BLE_MANAGER_PRINTF
+ * @param  None
+ * @retval None
+ */
+extern void BLE_MemPrint(void);
+#define BLE_MEM_PHASE_ENTER(Phase) BLE_MemPhaseEnter(Phase)
+#define BLE_MEM_PHASE_EXIT(Phase)  BLE_MemPhaseExit(Phase)
+#else /* BLE_MANAGER_MEMORY_WATERMARK */
+#define BLE_MEM_PHASE_ENTER(Phase)
+#define BLE_MEM_PHASE_EXIT(Phase)
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+/**
+ * @brief  Move to the next step of the advertising schedule when the current one is expired
+ *         (to call periodically from the main loop)
+ * @param  None
+ * @retval None
+ */
+extern void BLE_AdvertisingProcess(void);
+
+/**
+ * @brief  Restart the advertising schedule from the fast advertising (e.g. on button press).
+ *         It could be called from interrupt: the restart is done by BLE_AdvertisingProcess
+ * @param  None
+ * @retval None
+ */
+extern void BLE_AdvertisingRestartFast(void);
+
+/**
+ * @brief  Read the end of the current step of the advertising schedule
+ *         (for waking up from low power modes in time)
+ * @param  uint32_t *Deadline filled with the end of the step (BLE_MANAGER_ADV_TICK units)
+ * @retval uint8_t 1 if the current step has a deadline, 0 otherwise
+ */
+extern uint8_t BLE_AdvertisingGetDeadline(uint32_t *Deadline);
+
+/**
+ * @brief  Read the advertising metrics
+ * @param  BLE_AdvStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_AdvertisingGetStats(BLE_AdvStats_t *Stats);
+
+/**
+ * @brief  Reset the advertising metrics
+ * @param  None
+ * @retval None
+ */
+extern void BLE_AdvertisingResetStats(void);
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+#ifdef BLE_MANAGER_FAST_RECONNECT
+/**
+ * @brief  Read the reconnect cache
+ * @param  BLE_ReconnectCache_t *Cache filled with the cache
+ * @retval None
+ */
+extern void BLE_ReconnectGetCache(BLE_ReconnectCache_t *Cache);
+
+/**
+ * @brief  Empty the reconnect cache and the controller white and resolving lists
+ *         (after the clear of the security database, called also for the ClearDB command)
+ * @param  None
+ * @retval None
+ */
+extern void BLE_ReconnectClearCache(void);
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+
+#ifdef BLE_MANAGER_CONN_TUNER
+/**
+ * @brief  Measure the notification traffic and request the connection parameters
+ *         that fit it (to call periodically from the main loop)
+ * @param  None
+ * @retval None
+ */
+extern void BLE_ConnTunerProcess(void);
+
+/**
+ * @brief  Read the next time BLE_ConnTunerProcess has something to do
+ *         (for waking up from low power modes in time)
+ * @param  uint32_t *Deadline filled with the deadline (BLE_MANAGER_CONN_TUNER_TICK units)
+ * @retval uint8_t 1 if there is a deadline (only while connected), 0 otherwise
+ */
+extern uint8_t BLE_ConnTunerGetDeadline(uint32_t *Deadline);
+
+/**
+ * @brief  Read the connection parameters tuner metrics
+ * @param  BLE_ConnTunerStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_ConnTunerGetStats(BLE_ConnTunerStats_t *Stats);
+#endif /* BLE_MANAGER_CONN_TUNER */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+/**
+ * @brief  Send now the queued notifications (without waiting the end of the next connection event)
+ * @param  None
+ * @retval uint32_t number of notifications still queued (controller buffer full)
+ */
+extern uint32_t BLE_RadioSyncFlush(void);
+
+/**
+ * @brief  Read the notifications queue metrics
+ * @param  BLE_RadioSyncStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_RadioSyncGetStats(BLE_RadioSyncStats_t *Stats);
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
+#ifdef BLE_MANAGER_TX_CREDITS
+/**
+ * @brief  Compute how many notifications the controller buffer can take now
+ * @param  uint8_t charValueLen length of the notifications
+ * @retval uint32_t number of notifications
+ */
+extern uint32_t BLE_TxCreditsGetNotifications(uint8_t charValueLen);
+
+/**
+ * @brief  Read the controller buffer accounting metrics
+ * @param  BLE_TxCreditsStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_TxCreditsGetStats(BLE_TxCreditsStats_t *Stats);
+#endif /* BLE_MANAGER_TX_CREDITS */
+
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+/**
+ * @brief  Run the write requests posted by the HCI events
+ *         (to call from the main loop after hci_user_evt_proc)
+ * @param  uint32_t Budget time budget in ms (at least one write request is run)
+ * @retval uint32_t number of write requests still queued
+ */
+extern uint32_t BLE_DeferredProcess(uint32_t Budget);
+
+/**
+ * @brief  Read the number of write requests waiting BLE_DeferredProcess
+ * @param  None
+ * @retval uint32_t number of write requests
+ */
+extern uint32_t BLE_DeferredPending(void);
+
+/**
+ * @brief  Read the deferred writes metrics
+ * @param  BLE_DeferredStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_DeferredGetStats(BLE_DeferredStats_t *Stats);
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+
+#ifdef BLE_MANAGER_FAST_BOOT
+/**
+ * @brief  Read the boot report
+ * @param  BLE_BootReport_t *Report filled with the report
+ * @retval None
+ */
+extern void BLE_BootGetReport(BLE_BootReport_t *Report);
+
+/**
+ * @brief  Print the boot report with BLE_MANAGER_PRINTF
+ * @param  None
+ * @retval None
+ */
+extern void BLE_BootPrint(void);
+#endif /* BLE_MANAGER_FAST_BOOT */
+
+#ifdef BLE_MANAGER_STACK_RECOVERY
+/**
+ * @brief  Reset the BlueNRG and rebuild the same GATT database after one hardware error
+ *         or BlueNRG self reset (to call from the main loop, it does nothing otherwise)
+ * @param  None
+ * @retval None
+ */
+extern void BLE_StackRecoveryProcess(void);
+
+/**
+ * @brief  Read the BLE stack recovery metrics
+ * @param  BLE_RecoveryStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_StackRecoveryGetStats(BLE_RecoveryStats_t *Stats);
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+
+#ifdef BLE_MANAGER_RTOS
+/**
+ * @brief  Create the BLE task that owns the HCI transport (after InitBleManager, before osKernelStart).
+ *         From now the characteristic updates of the other threads are copied and posted to the BLE task,
+ *         and all the BLE Manager callbacks run in the BLE task.
+ *         BufferToWrite/BytesToWrite must be used only by the BLE task
+ * @param  None
+ * @retval uint8_t 1 for success, 0 otherwise
+ */
+extern uint8_t BLE_RtosStart(void);
+
+/**
+ * @brief  Signal the HCI events to the BLE task (to call from hci_tl_lowlevel_isr)
+ * @param  None
+ * @retval None
+ */
+extern void BLE_RtosHciNotify(void);
+
+/**
+ * @brief  Take one buffer for a zero-copy characteristic update (filled by the caller and sent with BLE_RtosPostBuffer)
+ * @param  None
+ * @retval BLE_RtosBuffer_t* buffer or NULL if all the buffers are in use
+ */
+extern BLE_RtosBuffer_t *BLE_RtosGetBuffer(void);
+
+/**
+ * @brief  Check if the caller is a thread different from the BLE task
+ *         (its characteristic updates and Term/Stderr messages are posted to the BLE task)
+ * @param  None
+ * @retval uint8_t 1 for one thread different from the BLE task (0 before BLE_RtosStart)
+ */
+extern uint8_t BLE_RtosIsOtherThread(void);
+
+/**
+ * @brief  Post one buffer taken with BLE_RtosGetBuffer to the BLE task (the buffer is released by the BLE task)
+ * @param  BLE_RtosBuffer_t *Buffer buffer with the characteristic value in Data
+ * @param  BleCharTypeDef *BleCharPointer characteristic to update
+ * @param  uint8_t charValueLen length of the characteristic value
+ * @retval tBleStatus Status
+ */
+extern tBleStatus BLE_RtosPostBuffer(BLE_RtosBuffer_t *Buffer, BleCharTypeDef *BleCharPointer, uint8_t charValueLen);
+
+/**
+ * @brief  Read the BLE task metrics
+ * @param  BLE_RtosStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_RtosGetStats(BLE_RtosStats_t *Stats);
+#endif /* BLE_MANAGER_RTOS */
+
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+/**
+ * @brief  Queue one sample with its timestamp (lock-free, callable from any interrupt priority)
+ * @param  uint8_t Channel source of the sample
+ * @param  const uint8_t *Data BLE_SAMPLE_SIZE bytes of the sample
+ * @retval uint8_t 1 for success, 0 if the queue is full (sample dropped)
+ */
+extern uint8_t BLE_SamplePush(uint8_t Channel, const uint8_t *Data);
+
+/**
+ * @brief  Give the queued samples in batches to CustomSampleBatch
+ *         (to call from the main loop, single consumer: with BLE_MANAGER_RTOS it is called only by the BLE task)
+ * @param  uint32_t Budget max number of samples handled
+ * @retval uint32_t number of samples still queued
+ */
+extern uint32_t BLE_SampleProcess(uint32_t Budget);
+
+/**
+ * @brief  Read the sample queue metrics
+ * @param  BLE_SampleStats_t *Stats filled with the metrics
+ * @retval None
+ */
+extern void BLE_SampleGetStats(BLE_SampleStats_t *Stats);
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+
 /**
  * @brief  
  * @param  uint8_t* buffer
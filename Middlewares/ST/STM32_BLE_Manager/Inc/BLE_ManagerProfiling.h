@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * @file    BLE_ManagerProfiling.h
+  * @author  System Research & Applications Team - Agrate/Catania Lab.
+  * @version 1.6.0
+  * @date    15-September-2022
+  * @brief   Cycle-count profiling hooks of the BLE Manager hot paths
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2022 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BLE_MANAGER_PROFILING_H_
+#define _BLE_MANAGER_PROFILING_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "BLE_Manager_Conf.h"
+
+#ifdef BLE_MANAGER_PROFILING
+
+/* Exported Defines ----------------------------------------------------------*/
+
+/* Values below 2^(BLE_PROFILE_MAX_LOG2+1) have their own histogram bucket (bigger values fall in the last one) */
+#ifndef BLE_PROFILE_MAX_LOG2
+  #define BLE_PROFILE_MAX_LOG2 23U
+#endif /* BLE_PROFILE_MAX_LOG2 */
+
+/* Values below 8 have one bucket each, then every power of two is split in 4 buckets (max error 25%) */
+#define BLE_PROFILE_BUCKETS (8U + ((BLE_PROFILE_MAX_LOG2 - 2U) * 4U))
+
+/* The DWT cycle counter is not present on Cortex-M0/M0+/M23 */
+#if !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__))
+  #error "BLE_MANAGER_PROFILING needs the DWT cycle counter (Cortex-M3/M4/M7/M33)"
+#endif /* !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)) */
+
+/* Cortex-M DWT cycle counter */
+#define BLE_PROFILE_DWT_CTRL   (*(volatile uint32_t *)0xE0001000U)
+#define BLE_PROFILE_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004U)
+#define BLE_PROFILE_DEMCR      (*(volatile uint32_t *)0xE000EDFCU)
+#define BLE_PROFILE_TIMESTAMP() BLE_PROFILE_DWT_CYCCNT
+#define BLE_PROFILE_UNIT "cycles"
+
+/* Exported Types ------------------------------------------------------------*/
+
+/* Profiled code sections */
+typedef enum
+{
+  BLE_PROFILE_HCI_SEND_REQ = 0,
+  BLE_PROFILE_HCI_SPI_RECEIVE,
+  BLE_PROFILE_HCI_USER_EVT_PROC,
+  BLE_PROFILE_ATTR_MODIFIED,
+  BLE_PROFILE_CHAR_UPDATE,
+
+  //Total Number of profiled sections
+  BLE_PROFILE_PROBES_NUMBER
+} BLE_ProfileProbeType;
+
+/* Summary of one profiled section (BLE_PROFILE_UNIT units) */
+typedef struct
+{
+  uint32_t Count;
+  uint32_t Min;
+  uint32_t Avg;
+  uint32_t Max;
+  /* Upper bound of the histogram bucket that contains the 99th percentile */
+  uint32_t P99;
+} BLE_ProfileReport_t;
+
+/* Exported Macros -----------------------------------------------------------*/
+
+/* Take the start timestamp (declares the variable Start) */
+#define BLE_PROFILE_START(Start) uint32_t Start = BLE_PROFILE_TIMESTAMP()
+/* Add the time elapsed from Start to the Probe histogram */
+#define BLE_PROFILE_STOP(Probe,Start) BLE_ProfileAdd((Probe),BLE_PROFILE_TIMESTAMP()-(Start))
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief  Enable the cycle counter and reset all the histograms
+ * @param  None
+ * @retval None
+ */
+extern void BLE_ProfileInit(void);
+
+/**
+ * @brief  Reset all the histograms
+ * @param  None
+ * @retval None
+ */
+extern void BLE_ProfileReset(void);
+
+/**
+ * @brief  Add one measure to the histogram of one profiled section
+ * @param  BLE_ProfileProbeType Probe profiled section
+ * @param  uint32_t Elapsed measure (BLE_PROFILE_UNIT units)
+ * @retval None
+ */
+extern void BLE_ProfileAdd(BLE_ProfileProbeType Probe, uint32_t Elapsed);
+
+/**
+ * @brief  Compute min/avg/max/p99 of one profiled section
+ * @param  BLE_ProfileProbeType Probe profiled section
+ * @param  BLE_ProfileReport_t *Report filled with the summary
+ * @retval uint8_t 1 for valid Probe, 0 otherwise
+ */
+extern uint8_t BLE_ProfileGetReport(BLE_ProfileProbeType Probe, BLE_ProfileReport_t *Report);
+
+/**
+ * @brief  Format the summary of one profiled section in one text line
+ * @param  BLE_ProfileProbeType Probe profiled section
+ * @param  char *Buffer output buffer (at least 96 bytes)
+ * @retval uint32_t length of the line
+ */
+extern uint32_t BLE_ProfileFormat(BLE_ProfileProbeType Probe, char *Buffer);
+
+/**
+ * @brief  Print the summary of all the profiled sections with BLE_MANAGER_PRINTF
+ * @param  None
+ * @retval None
+ */
+extern void BLE_ProfilePrint(void);
+
+#else /* BLE_MANAGER_PROFILING */
+
+#define BLE_PROFILE_START(Start)
+#define BLE_PROFILE_STOP(Probe,Start)
+
+#endif /* BLE_MANAGER_PROFILING */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLE_MANAGER_PROFILING_H_ */
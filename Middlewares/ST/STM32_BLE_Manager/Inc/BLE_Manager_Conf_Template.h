@@ -77,12 +77,105 @@ extern "C" {
 /* For enabling the capability to handle BLE Congestion */
 //#define ACC_BLE_CONGESTION
 
+/* For keeping the ReadCommand/ReadCustomCommand/ReadSensorsConfig answers of the
+ * Extended Configuration already serialized between two requests */
+//#define BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+
+/* For enabling the CBOR encoding (chosen by the first command of each connection) for the Extended Configuration */
+//#define BLE_MANAGER_EXTCONFIG_CBOR
+
 /* Define the Delay function to use inside the BLE Manager */
 #define BLE_MANAGER_DELAY HAL_Delay
 
+/* For keeping runtime counters of the characteristics updates and of the HCI layer
+ * (readable with the "stats" Term command and the ReadStats Extended Configuration command) */
+//#define BLE_MANAGER_STATS
+/* Free running counter used for measuring the latency of the characteristics updates and its unit
+ * (the DWT cycle counter is used instead when BLE_MANAGER_PROFILING is enabled) */
+//#define BLE_MANAGER_STATS_TIMESTAMP() HAL_GetTick()
+//#define BLE_MANAGER_STATS_TIMESTAMP_UNIT "ms, coarse"
+
+/* For profiling the HCI and characteristics update hot paths with the DWT cycle counter (Cortex-M3/M4/M7/M33 only)
+ * (min/avg/max/p99 readable with the "prof" Term command or BLE_ProfilePrint) */
+//#define BLE_MANAGER_PROFILING
+
+/* For using fixed-size blocks pools instead of the heap for all the BLE Manager allocations */
+//#define BLE_MANAGER_STATIC_POOLS
+
+/* Blocks pools dimensions (the block sizes must be multiple of 8 bytes) */
+//#define BLE_POOL_SMALL_BLOCK_SIZE  32U
+//#define BLE_POOL_SMALL_BLOCKS      96U
+//#define BLE_POOL_MEDIUM_BLOCK_SIZE 128U
+//#define BLE_POOL_MEDIUM_BLOCKS     24U
+//#define BLE_POOL_LARGE_BLOCK_SIZE  2048U
+//#define BLE_POOL_LARGE_BLOCKS      4U
+
+/* For painting stack and heap at boot and tracking their high-water marks during the init,
+ * connection and Extended Configuration phases (readable with the "mem" Term command) */
+//#define BLE_MANAGER_MEMORY_WATERMARK
+
+/* For advertising fast after boot/disconnection/BLE_AdvertisingRestartFast and then backing off to
+ * slower intervals (BLE_AdvertisingProcess must be called from the main loop, metrics with the "adv" Term command) */
+//#define BLE_MANAGER_ADAPTIVE_ADVERTISING
+/* Milliseconds counter used by the advertising schedule */
+//#define BLE_MANAGER_ADV_TICK() HAL_GetTick()
+/* For starting the fast advertising with 1.28s of directed advertising toward the last bonded central */
+//#define BLE_MANAGER_ADV_DIRECTED
+/* For keeping a cache of the bonded centrals and starting the advertising schedule with
+ * fast white list filtered advertising toward them (it needs BLE_MANAGER_ADAPTIVE_ADVERTISING) */
+//#define BLE_MANAGER_FAST_RECONNECT
+
+/* For requesting short connection intervals while the notifications traffic is high and
+ * long intervals with slave latency while it is idle (BLE_ConnTunerProcess must be called from the main loop) */
+//#define BLE_MANAGER_CONN_TUNER
+/* Milliseconds counter used by the connection parameters tuner */
+//#define BLE_MANAGER_CONN_TUNER_TICK() HAL_GetTick()
+
+/* For queuing the notifications and sending them just after the end of each connection event,
+ * filling the controller buffer for the next anchor point (BlueNRG-1/2 only).
+ * The Term and the Extended Configuration answers are not queued */
+//#define BLE_MANAGER_RADIO_SYNC
+
+/* For counting the free controller buffers (hci_le_read_buffer_size and hci_number_of_completed_packets_event)
+ * and not sending the updates that would fail for insufficient resources (BlueNRG-1/2 only) */
+//#define BLE_MANAGER_TX_CREDITS
+
+/* For running the characteristic write requests (Term, Config, Extended Configuration and custom ones)
+ * outside the HCI event processing (BLE_DeferredProcess must be called from the main loop) */
+//#define BLE_MANAGER_DEFERRED_WRITES
+/* Milliseconds counter used for the time budget of the deferred writes */
+//#define BLE_MANAGER_DEFERRED_TICK() HAL_GetTick()
+
+/* For waiting the BlueNRG initialized event instead of fixed delays after its reset and for
+ * timestamping the phases up to the first advertising (boot report with the "boot" Term command) */
+//#define BLE_MANAGER_FAST_BOOT
+/* Milliseconds counter used by the boot report */
+//#define BLE_MANAGER_BOOT_TICK() HAL_GetTick()
+
+/* For recovering from a BlueNRG hardware error or self reset without resetting the MCU: only the BlueNRG is
+ * reset and the same GATT database is rebuilt (it needs BLE_MANAGER_FAST_BOOT and BLE_StackRecoveryProcess
+ * called from the main loop) */
+//#define BLE_MANAGER_STACK_RECOVERY
+
+/* For running the BLE Manager in one dedicated CMSIS-RTOS task (BLE_RtosStart after InitBleManager):
+ * the characteristic updates from the other threads are posted to this task and all the HCI commands
+ * and events are handled by it (BLE_MANAGER_DELAY must be osDelay) */
+//#define BLE_MANAGER_RTOS
+
+/* For a lock-free sample queue filled by the sensor interrupts (BLE_SamplePush) and emptied in batches
+ * by the main loop (BLE_SampleProcess and CustomSampleBatch callback). It needs LDREX/STREX (Cortex-M3 or higher) */
+//#define BLE_MANAGER_SAMPLE_QUEUE
+/* Milliseconds counter used for the samples timestamp (it must be callable from interrupts) */
+//#define BLE_MANAGER_SAMPLE_TICK() HAL_GetTick()
+
 /****************** Memory managment functions **************************/
-#define BLE_MallocFunction malloc
-#define BLE_FreeFunction   free
+#ifdef BLE_MANAGER_STATIC_POOLS
+  #define BLE_MallocFunction BLE_PoolMalloc
+  #define BLE_FreeFunction   BLE_PoolFree
+#else /* BLE_MANAGER_STATIC_POOLS */
+  #define BLE_MallocFunction malloc
+  #define BLE_FreeFunction   free
+#endif /* BLE_MANAGER_STATIC_POOLS */
 #define BLE_MemCpy         memcpy
 
 /*---------- Print messages from BLE Manager files at middleware level -------*/
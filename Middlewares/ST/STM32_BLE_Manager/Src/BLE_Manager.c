@@ -29,7 +29,13 @@
 /* Private define ---------------------------------------------------------------*/
 
 /* Max Number of Bonded Devices */
-#define BLE_MANAGER_MAX_BONDED_DEVICES 3
+#ifndef BLE_MANAGER_MAX_BONDED_DEVICES
+  #define BLE_MANAGER_MAX_BONDED_DEVICES 3
+#endif /* BLE_MANAGER_MAX_BONDED_DEVICES */
+
+/* Max length of one Extended Configuration command name extracted without parsing the whole command
+ * (longer names are not standard commands) */
+#define EXT_CONFIG_MAX_COMMAND_NAME_LEN 32U
 
 /* Hardware & Software Characteristics Service */
 #define COPY_FEATURES_SERVICE_UUID(uuid_struct) COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x00,0x00,0x01,0x11,0xe1,0x9a,0xb4,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
@@ -40,6 +46,26 @@
 #define COPY_TERM_CHAR_UUID(uuid_struct)        COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x01,0x00,0x0E,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
 #define COPY_STDERR_CHAR_UUID(uuid_struct)      COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x02,0x00,0x0E,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
 
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+/* Initial size of the buffer used for encoding one CBOR answer */
+#define BLE_CBOR_WRITER_INITIAL_SIZE 256U
+/* Max nesting level accepted when a CBOR item is skipped */
+#define BLE_CBOR_MAX_NESTING 8U
+/* Value used for indefinite length CBOR maps */
+#define BLE_CBOR_INDEFINITE_LENGTH 0xFFFFFFFFU
+
+#define CBOR_KEY_IS(Key,KeyLen,Name) (((KeyLen)==(sizeof(Name)-1U)) && (memcmp((Key),(Name),(KeyLen))==0))
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+
+#ifdef BLE_MANAGER_STATIC_POOLS
+#if (((BLE_POOL_SMALL_BLOCK_SIZE % 8U) != 0U) || ((BLE_POOL_MEDIUM_BLOCK_SIZE % 8U) != 0U) || ((BLE_POOL_LARGE_BLOCK_SIZE % 8U) != 0U))
+#error "BLE Manager pools block sizes must be multiple of 8 bytes"
+#endif
+#if ((BLE_POOL_SMALL_BLOCK_SIZE > BLE_POOL_MEDIUM_BLOCK_SIZE) || (BLE_POOL_MEDIUM_BLOCK_SIZE > BLE_POOL_LARGE_BLOCK_SIZE))
+#error "BLE Manager pools must be ordered by increasing block size"
+#endif
+#endif /* BLE_MANAGER_STATIC_POOLS */
+
 /* Configuration Service */
 #define COPY_CONFIG_SERVICE_UUID(uuid_struct)   COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x00,0x00,0x0F,0x11,0xe1,0x9a,0xb4,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
 #define COPY_CONFIG_CHAR_UUID(uuid_struct)      COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x02,0x00,0x0F,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
@@ -80,6 +106,10 @@ typedef enum
   EXT_CONFIG_COM_READ_SENSOR_CONFIG,
   EXT_CONFIG_COM_READ_BANKS_FW_ID,
   EXT_CONFIG_COM_BANKS_SWAP,
+#ifdef BLE_MANAGER_STATS
+  EXT_CONFIG_COM_READ_STATS,
+  EXT_CONFIG_COM_RESET_STATS,
+#endif /* BLE_MANAGER_STATS */
   
   //Commands With Argument
   EXT_CONFIG_COM_SET_WIFI,
@@ -100,6 +130,169 @@ typedef struct {
   char *CommandString;
 } BLE_ExtConfigCommand_t;
 
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+//Typedef for the Extended Configuration answers that could be cached
+typedef enum 
+{
+  EXT_CONFIG_CACHE_READ_COMMAND = 0,
+  EXT_CONFIG_CACHE_READ_CUSTOM_COMMAND,
+  EXT_CONFIG_CACHE_READ_SENSOR_CONFIG,
+  
+  //Total Number of cached answers
+  EXT_CONFIG_CACHE_ANSWERS_NUMBER
+} BLE_ExtConfigCachedAnswerType;
+
+//Structure used for keeping one answer already serialized and encapsulated with BLE_COMM_TP
+typedef struct {
+  uint8_t *Buffer;
+  uint32_t Length;
+  uint32_t Version;
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+  uint8_t  CborEncoding;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+} BLE_ExtConfigCachedAnswer_t;
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+//Structure used for reading one CBOR encoded buffer
+typedef struct {
+  uint8_t *Buffer;
+  uint32_t Length;
+  uint32_t Pos;
+} BLE_CborReader_t;
+
+//Structure used for keeping one CBOR encoded command (the strings point inside the received buffer)
+typedef struct {
+  char    *Command;
+  char    *ArgString;
+  double   ArgNumber;
+  uint8_t  HasArgNumber;
+  //argJsonElement fields used by SetWiFi command
+  char    *Ssid;
+  char    *Password;
+  char    *SecurityType;
+} BLE_ExtConfigCborCommand_t;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+
+#ifdef BLE_MANAGER_STATIC_POOLS
+//Structure used for one pool of fixed-size blocks (the free blocks are linked using their first word)
+typedef struct {
+  uint8_t *Memory;
+  void *FreeList;
+  BLE_PoolStats_t Stats;
+} BLE_Pool_t;
+#endif /* BLE_MANAGER_STATIC_POOLS */
+
+#ifdef BLE_MANAGER_PROFILING
+//Histogram of one profiled section
+typedef struct {
+  uint32_t Count;
+  uint32_t Min;
+  uint32_t Max;
+  uint64_t Sum;
+  uint32_t Histogram[BLE_PROFILE_BUCKETS];
+} BLE_ProfileProbe_t;
+#endif /* BLE_MANAGER_PROFILING */
+
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+//Painted memory regions (word aligned) and high-water marks of the phases
+typedef struct {
+  uint32_t *HeapStart;
+  uint32_t *HeapEnd;
+  uint32_t *StackLimit;
+  uint32_t *StackTop;
+  /* Bit mask of the running phases */
+  uint32_t ActivePhases;
+  BLE_MemWatermark_t Phases[BLE_MEM_PHASES_NUMBER];
+} BLE_MemTracker_t;
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+//State of the advertising schedule
+typedef struct {
+  /* 1 while the device is advertising */
+  uint8_t Advertising;
+  /* 1 from the start of the advertising to the connection */
+  uint8_t WaitingConnection;
+  BLE_AdvStepType Step;
+  uint32_t StepStartTick;
+  uint32_t WaitingStartTick;
+  volatile uint8_t RestartFastRequest;
+  /* Last bonded central (target of the directed advertising) */
+  uint8_t BondedPeerValid;
+  uint8_t PeerAddressType;
+  uint8_t PeerAddress[6];
+  /* Central of the current connection */
+  uint8_t ConnectedPeerAddressType;
+  uint8_t ConnectedPeerAddress[6];
+  uint64_t SumTimeToConnect;
+  uint32_t LastAccountTick;
+  BLE_AdvStats_t Stats;
+} BLE_AdvSchedule_t;
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+#ifdef BLE_MANAGER_CONN_TUNER
+//State of the connection parameters tuner
+typedef struct {
+  uint8_t Connected;
+  /* 1 from the request to the answer of the central */
+  uint8_t RequestPending;
+  BLE_ConnProfileType RequestedProfile;
+  /* Profile that fits the measured traffic */
+  BLE_ConnProfileType TargetProfile;
+  uint32_t WindowStartTick;
+  uint32_t WindowBytes;
+  /* Consecutive windows with idle traffic */
+  uint32_t IdleWindows;
+  /* No request before this tick (back-off after a refusal) */
+  uint32_t RetryTick;
+  uint32_t RetryDelay;
+  BLE_ConnTunerStats_t Stats;
+} BLE_ConnTuner_t;
+#endif /* BLE_MANAGER_CONN_TUNER */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+//One queued notification
+typedef struct {
+  BleCharTypeDef *BleCharPointer;
+  /* Position of the value in the queue bytes */
+  uint16_t DataOffset;
+  uint8_t charValOffset;
+  uint8_t charValueLen;
+} BLE_RadioSyncEntry_t;
+
+//Notifications queued until the end of the next connection event
+typedef struct {
+  BLE_RadioSyncEntry_t Entries[BLE_RADIO_SYNC_QUEUE_SIZE];
+  uint8_t Data[BLE_RADIO_SYNC_QUEUE_BYTES];
+  uint32_t EntriesNumber;
+  uint32_t DataLength;
+  /* 1 while the queue is sent (the updates go directly to the controller) */
+  uint8_t Flushing;
+  BLE_RadioSyncStats_t Stats;
+} BLE_RadioSync_t;
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+//One write request waiting BLE_DeferredProcess
+typedef struct {
+  BleCharTypeDef *BleCharPointer;
+  uint16_t attr_handle;
+  uint16_t Offset;
+  uint8_t data_length;
+  uint8_t Data[BLE_DEFERRED_DATA_SIZE];
+  uint32_t PostTick;
+} BLE_DeferredJob_t;
+
+//Ring of the write requests
+typedef struct {
+  BLE_DeferredJob_t Jobs[BLE_DEFERRED_JOBS];
+  uint32_t Head;
+  uint32_t Number;
+  BLE_DeferredStats_t Stats;
+} BLE_DeferredQueue_t;
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+
 /* Exported variables -----------------------------------------------------------*/
 /* Identifies if the configuration service are enabled or not */
 BLE_ServEnab_t BLE_Conf_Service;
@@ -127,6 +320,11 @@ BLE_StackTypeDef BLE_StackValue;
 /* Manufacter Advertise data */
 uint8_t manuf_data[BLE_MANAGER_ADVERTISE_DATA_LENGHT];
 
+#ifdef BLE_MANAGER_STATS
+/* Runtime counters of the HCI layer */
+BLE_HciStats_t BLE_HciStats;
+#endif /* BLE_MANAGER_STATS */
+
 /**************** Bluetooth Comunication *************************/
 CustomPairingCompleted_t                CustomPairingCompleted;
 CustomSetConnectable_t                  CustomSetConnectable;
@@ -134,6 +332,22 @@ CustomConnectionCompleted_t             CustomConnectionCompleted;
 CustomDisconnectionCompleted_t          CustomDisconnectionCompleted;
 CustomAciGattTxPoolAvailableEvent_t     CustomAciGattTxPoolAvailableEvent;
 CustomHardwareErrorEventHandler_t       CustomHardwareErrorEventHandler;
+#ifdef BLE_MANAGER_FAST_RECONNECT
+CustomReconnectCacheSave_t              CustomReconnectCacheSave;
+CustomReconnectCacheLoad_t              CustomReconnectCacheLoad;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+#ifdef BLE_MANAGER_STACK_RECOVERY
+CustomStackRecovered_t                  CustomStackRecovered;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+#ifdef BLE_MANAGER_RTOS
+CustomRtosTaskLoop_t                    CustomRtosTaskLoop;
+#endif /* BLE_MANAGER_RTOS */
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+CustomSampleBatch_t                     CustomSampleBatch;
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+#ifdef BLE_MANAGER_RADIO_SYNC
+CustomEndOfConnectionEvent_t            CustomEndOfConnectionEvent;
+#endif /* BLE_MANAGER_RADIO_SYNC */
 
 /**************** Debug Console *************************/
 CustomDebugConsoleParsing_t CustomDebugConsoleParsingCallback;
@@ -184,6 +398,10 @@ CustomExtConfigSetCertCommand_t CustomExtConfigSetCertCommandCallback;
 // Sensor Configuration
 CustomExtConfigReadSensorsConfigCommands_t CustomExtConfigReadSensorsConfigCommandsCallback;
 CustomExtConfigSetSensorsConfigCommands_t CustomExtConfigSetSensorsConfigCommandsCallback;
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+CustomExtConfigReadSensorsConfigCborCommands_t CustomExtConfigReadSensorsConfigCborCommandsCallback;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+CustomExtConfigReadSensorsConfigStaticCommands_t CustomExtConfigReadSensorsConfigStaticCommandsCallback;
 
 /* Private variables ------------------------------------------------------------*/
 
@@ -204,6 +422,10 @@ static BLE_ExtConfigCommand_t StandardExtConfigCommands[EXT_CONFIG_COMMAND_NUMBE
   {EXT_CONFIG_COM_READ_SENSOR_CONFIG,"ReadSensorsConfig"},
   {EXT_CONFIG_COM_READ_BANKS_FW_ID,"ReadBanksFwId"},
   {EXT_CONFIG_COM_BANKS_SWAP,"BanksSwap"},
+#ifdef BLE_MANAGER_STATS
+  {EXT_CONFIG_COM_READ_STATS,"ReadStats"},
+  {EXT_CONFIG_COM_RESET_STATS,"ResetStats"},
+#endif /* BLE_MANAGER_STATS */
   {EXT_CONFIG_COM_SET_WIFI,"SetWiFi"},
   {EXT_CONFIG_COM_SET_DATE,"SetDate"},
   {EXT_CONFIG_COM_SET_TIME,"SetTime"},
@@ -234,12 +456,194 @@ static BleCharTypeDef BleCharStdErr;
 static BleCharTypeDef BleCharExtConfig;
 
 static uint8_t *hs_command_buffer;
+
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+static BLE_ExtConfigCachedAnswer_t ExtConfigCachedAnswers[EXT_CONFIG_CACHE_ANSWERS_NUMBER];
+/* Current version of the Extended Configuration answers (starting from 1 for marking all the empty slots as not valid) */
+static uint32_t ExtConfigAnswersVersion=1U;
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+
+/* Precompiled paths of the Extended Configuration commands fields */
+static JSON_Path ExtConfigPathCommand;
+static JSON_Path ExtConfigPathArgString;
+static JSON_Path ExtConfigPathArgNumber;
+
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+/* 1 if the Extended Configuration of the current connection is CBOR encoded: the encoding is set by the
+ * first command after the connection and it's used by all the answers, also by asynchronous SendError/SendInfo */
+static uint8_t ExtConfigCborEncoding=0U;
+/* 1 if the encoding of the current connection is already set */
+static uint8_t ExtConfigEncodingSet=0U;
+static BLE_ExtConfigCborCommand_t ExtConfigCborCommand;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
 #endif /* BLE_MANAGER_NO_PARSON */
 
 static BleCharTypeDef *BleCharsArray[BLE_MANAGER_MAX_ALLOCABLE_CHARS];
 static uint8_t UsedBleChars;
 static uint8_t UsedStandardBleChars;
 
+#ifdef BLE_MANAGER_PROFILING
+/* Histograms of the profiled sections */
+static BLE_ProfileProbe_t BleProfileProbes[BLE_PROFILE_PROBES_NUMBER];
+
+static const char *BleProfileProbeNames[BLE_PROFILE_PROBES_NUMBER] = {
+  "hci_send_req",
+  "HCI_TL_SPI_Receive",
+  "hci_user_evt_proc",
+  "attr_modified",
+  "char_update"
+};
+#endif /* BLE_MANAGER_PROFILING */
+
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+/* Painted regions and high-water marks (StackTop==NULL until BLE_MemPaint) */
+static BLE_MemTracker_t BleMemTracker;
+
+static const char *BleMemPhaseNames[BLE_MEM_PHASES_NUMBER] = {
+  "all",
+  "init",
+  "connection",
+  "extconfig"
+};
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+static BLE_AdvSchedule_t BleAdvSchedule;
+
+static const char *BleAdvStepNames[BLE_ADV_STEPS_NUMBER] = {
+  "directed",
+  "reconnect",
+  "fast",
+  "medium",
+  "slow"
+};
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+#ifdef BLE_MANAGER_FAST_BOOT
+static BLE_BootReport_t BleBootReport;
+/* Set by the BlueNRG initialized event */
+static volatile uint8_t BleBootReady;
+
+static const char *BleBootPhaseNames[BLE_BOOT_PHASES_NUMBER] = {
+  "hci init",
+  "stack ready",
+  "stack config",
+  "services",
+  "main loop",
+  "advertising"
+};
+#endif /* BLE_MANAGER_FAST_BOOT */
+
+#ifdef BLE_MANAGER_FAST_RECONNECT
+static BLE_ReconnectCache_t BleReconnectCache;
+/* Bonded devices written in the controller white and resolving lists */
+static Bonded_Device_Entry_t BleReconnectListed[BLE_MANAGER_MAX_BONDED_DEVICES];
+static uint8_t BleReconnectListedNumber;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+
+#ifdef BLE_MANAGER_CONN_TUNER
+static BLE_ConnTuner_t BleConnTuner;
+
+static const char *BleConnProfileNames[BLE_CONN_PROFILES_NUMBER] = {
+  "central",
+  "stream",
+  "idle"
+};
+#endif /* BLE_MANAGER_CONN_TUNER */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+static BLE_RadioSync_t BleRadioSync;
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
+#ifdef BLE_MANAGER_TX_CREDITS
+static BLE_TxCreditsStats_t BleTxCredits;
+/* 1 after the first hci_number_of_completed_packets_event of the connection */
+static uint8_t BleTxCreditsTracking;
+#endif /* BLE_MANAGER_TX_CREDITS */
+
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+static BLE_DeferredQueue_t BleDeferred;
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+
+#ifdef BLE_MANAGER_STACK_RECOVERY
+static BLE_RecoveryStats_t BleRecovery;
+/* Set by the HCI events, served by BLE_StackRecoveryProcess */
+static volatile uint8_t BleRecoveryRequested;
+/* 1 when the BLE Manager is initialized (the BlueNRG errors must be recovered) */
+static uint8_t BleRecoveryArmed;
+/* 1 during the recovery (the same secure PIN is kept) */
+static uint8_t BleRecoveryRunning;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+
+#ifdef BLE_MANAGER_RTOS
+/* BLE task state */
+typedef struct
+{
+  osThreadId TaskId;
+  osPoolId PoolId;
+  /* Buffers posted (the task is woken up with BLE_RTOS_SIGNAL_WAKEUP) */
+  osMessageQId QueueId;
+  /* Buffers in use (taken by the other threads, released by the BLE task) */
+  volatile uint32_t Used;
+  BLE_RtosStats_t Stats;
+} BLE_Rtos_t;
+
+static BLE_Rtos_t BleRtos;
+
+/* Signal of the BLE task for the posted updates and the HCI events */
+#define BLE_RTOS_SIGNAL_WAKEUP 0x0001
+
+static void BLE_RtosTask(void const *argument);
+static void BLE_RtosWakeUp(void);
+
+osThreadDef(BLE_RtosTask, BLE_RTOS_PRIORITY, 1, BLE_RTOS_STACK_SIZE);
+osPoolDef(BleRtosPool, BLE_RTOS_QUEUE_SIZE, BLE_RtosBuffer_t);
+/* Room for all the buffers */
+osMessageQDef(BleRtosQueue, BLE_RTOS_QUEUE_SIZE, uint32_t);
+#endif /* BLE_MANAGER_RTOS */
+
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+#define BLE_SAMPLE_BARRIER() __DMB()
+
+/* Queue slot: Sequence==Position when free, Position+1 when written (bounded MPSC queue) */
+typedef struct
+{
+  volatile uint32_t Sequence;
+  BLE_Sample_t Sample;
+} BLE_SampleSlot_t;
+
+typedef struct
+{
+  BLE_SampleSlot_t Slots[BLE_SAMPLE_QUEUE_SIZE];
+  /* Next position claimed by the producers (interrupts) */
+  volatile uint32_t Tail;
+  /* Next position read by the consumer (main loop) */
+  uint32_t Head;
+  volatile uint32_t Dropped;
+  volatile uint32_t Retries;
+  uint32_t Batches;
+  uint32_t MaxUsed;
+} BLE_SampleQueue_t;
+
+static BLE_SampleQueue_t BleSampleQueue;
+/* Batch given to CustomSampleBatch */
+static BLE_Sample_t BleSampleBatch[BLE_SAMPLE_BATCH];
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+
+#ifdef BLE_MANAGER_STATIC_POOLS
+/* Memory of the blocks pools (uint64_t for having all the blocks 8 bytes aligned) */
+static uint64_t BlePoolSmallMemory[(BLE_POOL_SMALL_BLOCK_SIZE * BLE_POOL_SMALL_BLOCKS) / 8U];
+static uint64_t BlePoolMediumMemory[(BLE_POOL_MEDIUM_BLOCK_SIZE * BLE_POOL_MEDIUM_BLOCKS) / 8U];
+static uint64_t BlePoolLargeMemory[(BLE_POOL_LARGE_BLOCK_SIZE * BLE_POOL_LARGE_BLOCKS) / 8U];
+
+static BLE_Pool_t BlePools[BLE_POOL_NUMBER] = {
+  {(uint8_t *)BlePoolSmallMemory, NULL, {BLE_POOL_SMALL_BLOCK_SIZE, BLE_POOL_SMALL_BLOCKS, 0U, 0U, 0U, 0U}},
+  {(uint8_t *)BlePoolMediumMemory, NULL, {BLE_POOL_MEDIUM_BLOCK_SIZE, BLE_POOL_MEDIUM_BLOCKS, 0U, 0U, 0U, 0U}},
+  {(uint8_t *)BlePoolLargeMemory, NULL, {BLE_POOL_LARGE_BLOCK_SIZE, BLE_POOL_LARGE_BLOCKS, 0U, 0U, 0U, 0U}}
+};
+static uint8_t BlePoolsInitialized=0U;
+#endif /* BLE_MANAGER_STATIC_POOLS */
+
 #if (BLUE_CORE == BLUENRG_MS)
 /* ***************** BlueNRG-MS Stack functions prototype ***********************/
 void hci_le_connection_complete_event(uint8_t Status,
@@ -284,7 +688,9 @@ static void HCI_Event_CB(void *pckt);
 #if (BLUE_CORE != BLUE_WB)
 static void APP_UserEvtRx(void *pData);
 #endif /* (BLUE_CORE != BLUE_WB) */
+#ifndef BLE_MANAGER_FAST_RECONNECT
 static void UpdateWhiteList(void);
+#endif /* BLE_MANAGER_FAST_RECONNECT */
 #endif /* (BLUE_CORE == BLUENRG_MS) */
 
 #if (BLUE_CORE != BLUE_WB)
@@ -295,6 +701,35 @@ static tBleStatus InitBleManagerServices(void);
 
 #ifndef BLE_MANAGER_NO_PARSON
 static tBleStatus BLE_UpdateExtConf(uint8_t *data,uint8_t length);
+static tBleStatus BLE_ExtConfig_SendTPBuffer(uint8_t *data,uint32_t tot_len);
+static uint8_t *ExtConfig_SerializeAnswer(const JSON_Value *tempJSON,uint32_t *length);
+static tBleStatus ExtConfig_SendAnswer(const JSON_Value *tempJSON);
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+static uint8_t ExtConfig_SendCachedAnswer(BLE_ExtConfigCachedAnswerType AnswerType);
+static tBleStatus ExtConfig_CacheAndSendAnswer(BLE_ExtConfigCachedAnswerType AnswerType,uint8_t *data,uint32_t length);
+static tBleStatus ExtConfig_CacheAndSendJsonAnswer(BLE_ExtConfigCachedAnswerType AnswerType,const JSON_Value *tempJSON);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+static void Cbor_InitWriter(BLE_CborWriter_t *Cbor);
+static uint8_t Cbor_Reserve(BLE_CborWriter_t *Cbor,uint32_t Size);
+static void Cbor_PutTextLen(BLE_CborWriter_t *Cbor,const char *String,uint32_t Len);
+static void Cbor_PutHead(BLE_CborWriter_t *Cbor,uint8_t Major,uint32_t Value);
+static void Cbor_PutByte(BLE_CborWriter_t *Cbor,uint8_t Value);
+static void Cbor_PutText(BLE_CborWriter_t *Cbor,const char *String);
+static void Cbor_PutInt(BLE_CborWriter_t *Cbor,int32_t Value);
+static void Cbor_PutFloat(BLE_CborWriter_t *Cbor,float Value);
+static void Cbor_PutNumber(BLE_CborWriter_t *Cbor,double Value);
+static void Cbor_PutJsonValue(BLE_CborWriter_t *Cbor,const JSON_Value *Value);
+static uint8_t Cbor_GetHead(BLE_CborReader_t *Reader,uint8_t *Major,uint8_t *AddInfo,uint64_t *Value);
+static uint8_t Cbor_SkipItem(BLE_CborReader_t *Reader,uint8_t Depth);
+static uint8_t Cbor_GetText(BLE_CborReader_t *Reader,char **String);
+static uint8_t Cbor_GetNumber(BLE_CborReader_t *Reader,double *Number);
+static uint8_t Cbor_EnterMap(BLE_CborReader_t *Reader,uint32_t *Pairs);
+static uint8_t Cbor_NextKey(BLE_CborReader_t *Reader,uint32_t *Pairs,const char **Key,uint32_t *KeyLen);
+static uint8_t ExtConfig_CborDecodeCommand(uint8_t *Buffer,uint32_t Length,BLE_ExtConfigCborCommand_t *Command);
+static void create_CBOR_SubSensorDescriptor(COM_SubSensorDescriptor_t *sub_sensor_descriptor, BLE_CborWriter_t *Cbor);
+static void create_CBOR_SubSensorStatus(COM_SubSensorStatus_t *sub_sensor_status, BLE_CborWriter_t *Cbor);
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
 #endif /* BLE_MANAGER_NO_PARSON */
 
 static tBleStatus BLE_Manager_AddFeaturesService(void);
@@ -303,6 +738,90 @@ static tBleStatus BLE_Manager_AddConfigService(void);
 
 static tBleStatus UpdateTermStdOut(uint8_t *data,uint8_t length);
 static tBleStatus UpdateTermStdErr(uint8_t *data,uint8_t length);
+static uint8_t BLE_UpdateCharPreSend(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue, tBleStatus *ret);
+static tBleStatus BLE_UpdateCharSend(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue);
+
+#ifdef BLE_MANAGER_STATS
+static void BLE_StatsCharUpdate(BleCharTypeDef *BleCharPointer,tBleStatus ret,uint8_t charValueLen);
+static void Term_SendStats(void);
+#endif /* BLE_MANAGER_STATS */
+#ifdef BLE_MANAGER_PROFILING
+static uint32_t BLE_ProfileBucket(uint32_t Elapsed);
+static uint32_t BLE_ProfileBucketUpperBound(uint32_t Bucket);
+static void Term_SendProfiling(void);
+#endif /* BLE_MANAGER_PROFILING */
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+static void BLE_MemSample(uint8_t WithHeap);
+static void BLE_MemPaintStack(void);
+static uint32_t BLE_MemFormat(BLE_MemPhaseType Phase, char *Buffer);
+static void Term_SendMemWatermark(void);
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+static void BLE_AdvertisingIntervals(BLE_AdvStepType Step,uint16_t *AdvIntervalMin,uint16_t *AdvIntervalMax);
+static void BLE_AdvertisingSchedule(uint16_t *AdvIntervalMin,uint16_t *AdvIntervalMax);
+static void BLE_AdvertisingStop(void);
+static void BLE_AdvertisingAccount(void);
+static void BLE_AdvertisingReset(void);
+static void BLE_AdvertisingSetBondedPeer(void);
+static void Term_SendAdvertisingStats(void);
+static BLE_AdvStepType BLE_AdvertisingUndirectedStep(void);
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+#ifdef BLE_MANAGER_FAST_RECONNECT
+static void BLE_ReconnectInit(void);
+static void BLE_ReconnectRefresh(void);
+static void BLE_ReconnectCacheTouch(uint8_t AddressType, uint8_t Address[6]);
+static uint8_t BLE_ReconnectIdentityAddress(uint8_t *AddressType, uint8_t Address[6]);
+static void BLE_ReconnectCacheSave(void);
+static uint8_t BLE_ReconnectIsBonded(BLE_BondedPeer_t *Peer, Bonded_Device_Entry_t *BondedDeviceEntry, uint8_t NumOfAddresses);
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+#ifdef BLE_MANAGER_CONN_TUNER
+static void BLE_ConnTunerConnected(uint16_t Conn_Interval, uint16_t Conn_Latency, uint16_t Supervision_Timeout);
+static void BLE_ConnTunerRequest(BLE_ConnProfileType Profile);
+static void BLE_ConnTunerBackOff(void);
+static void Term_SendConnTuner(void);
+#endif /* BLE_MANAGER_CONN_TUNER */
+#ifdef BLE_MANAGER_RADIO_SYNC
+static uint8_t BLE_RadioSyncIsQueued(BleCharTypeDef *BleCharPointer);
+static tBleStatus BLE_RadioSyncQueue(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue);
+static void Term_SendRadioSync(void);
+#endif /* BLE_MANAGER_RADIO_SYNC */
+#ifdef BLE_MANAGER_TX_CREDITS
+static void BLE_TxCreditsInit(void);
+static void BLE_TxCreditsReset(void);
+static uint32_t BLE_TxCreditsCost(uint8_t charValueLen);
+static uint8_t BLE_TxCreditsCheck(uint8_t charValueLen);
+static void BLE_TxCreditsUpdate(uint8_t charValueLen, tBleStatus ret);
+static void Term_SendTxCredits(void);
+#endif /* BLE_MANAGER_TX_CREDITS */
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+static uint8_t BLE_DeferredPost(BleCharTypeDef *BleCharPointer, uint16_t attr_handle, uint16_t Offset, uint16_t data_length, uint8_t *att_data);
+static void BLE_DeferredFlush(void);
+static void Term_SendDeferred(void);
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+#ifdef BLE_MANAGER_STACK_RECOVERY
+static tBleStatus BLE_StackRecoveryServices(void);
+static void Term_SendRecovery(void);
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+#ifdef BLE_MANAGER_RTOS
+static tBleStatus BLE_RtosPostText(BleCharTypeDef *BleCharPointer, uint8_t *data, uint8_t length);
+static tBleStatus BLE_RtosPost(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue);
+static void BLE_RtosSend(BLE_RtosBuffer_t *Buffer);
+static void BLE_RtosFlush(void);
+static void Term_SendRtos(void);
+#endif /* BLE_MANAGER_RTOS */
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+static void BLE_SampleQueueInit(void);
+static uint8_t BLE_SampleCompareAndSwap(volatile uint32_t *Value, uint32_t Expected, uint32_t New);
+static void BLE_SampleAtomicIncrement(volatile uint32_t *Value);
+static uint8_t BLE_SamplePop(BLE_Sample_t *Sample);
+static void BLE_SampleDeliver(uint32_t Number);
+static void Term_SendSamples(void);
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+#ifdef BLE_MANAGER_FAST_BOOT
+static void BLE_BootMark(BLE_BootPhaseType Phase);
+static uint8_t BLE_BootWaitReady(void);
+static void Term_SendBootReport(void);
+#endif /* BLE_MANAGER_FAST_BOOT */
 
 #if (BLUE_CORE != BLUENRG_LP)
   static void Read_Request_StdErr(void *VoidCharPointer,uint16_t handle);
@@ -326,13 +845,24 @@ static tBleStatus UpdateTermStdErr(uint8_t *data,uint8_t length);
 
 #ifndef BLE_MANAGER_NO_PARSON
 static BLE_ExtConfigCommandType BLE_ExtConfig_ExtractCommandType(uint8_t *hs_command_buffer);
+static uint8_t ExtConfig_ScanCommandName(uint8_t *hs_command_buffer,char *CommandName);
+static BLE_ExtConfigCommandType ExtConfig_CommandTypeFromName(const char *CommandName);
+static BLE_CustomCommadResult_t *BuildCustomCommandResult(BLE_ExtCustomCommand_t *LocCustomCommands,const char *CommandName,
+                                                          const char *ArgString,uint8_t HasArgNumber,double ArgNumber);
+static BLE_CustomCommadResult_t *ParseCustomCommandInsitu(BLE_ExtCustomCommand_t *LocCustomCommands,uint8_t *hs_command_buffer);
+static BLE_CustomCommadResult_t *CustomCommandResultFromJson(BLE_ExtCustomCommand_t *LocCustomCommands,JSON_Value *tempJSON);
+static const char *ExtConfig_SensorTypeString(uint8_t SensorType);
+static const char *ExtConfig_DataTypeString(uint8_t DataType);
 
 static void AttrMod_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle, uint16_t Offset, uint8_t data_length, uint8_t *att_data);
 static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle, uint16_t Offset, uint8_t data_length, uint8_t *att_data);
 static void ClearSingleCommand(BLE_ExtCustomCommand_t *Command);
+#ifdef BLE_MANAGER_STATS
+static void ExtConfig_SendStats(void);
+#endif /* BLE_MANAGER_STATS */
 
 static void create_JSON_SensorDescriptor(COM_SensorDescriptor_t *sensor_descriptor, JSON_Value *tempJSON);
-static void create_JSON_SensorStatus(COM_Sensor_t *sensor, JSON_Value *tempJSON);
+static void create_JSON_SensorStatus(COM_SensorStatus_t *sensor_status, uint32_t nSubSensors, JSON_Value *tempJSON);
 static void create_JSON_SubSensorDescriptor(COM_SubSensorDescriptor_t *sub_sensor_descriptor, JSON_Value *tempJSON);
 static void create_JSON_SubSensorStatus(COM_SubSensorStatus_t *sub_sensor_status, JSON_Value *tempJSON);
 #endif /* BLE_MANAGER_NO_PARSON */
@@ -796,11 +1326,9 @@ static void create_JSON_SensorDescriptor(COM_SensorDescriptor_t *sensor_descript
   }
 }
 
-static void create_JSON_SensorStatus(COM_Sensor_t *sensor, JSON_Value *tempJSON)
+static void create_JSON_SensorStatus(COM_SensorStatus_t *sensor_status, uint32_t nSubSensors, JSON_Value *tempJSON)
 {  
   uint32_t ii = 0;
-  COM_SensorStatus_t sensor_status = sensor->sensorStatus;
-  COM_SensorDescriptor_t pSensorDescriptor = sensor->sensorDescriptor;
   
   JSON_Object *JSON_SensorStatus = json_value_get_object(tempJSON);
   JSON_Array *JSON_SensorArray2;
@@ -808,10 +1336,10 @@ static void create_JSON_SensorStatus(COM_Sensor_t *sensor, JSON_Value *tempJSON)
   
   json_object_dotset_value(JSON_SensorStatus, "subSensorStatus", json_value_init_array());
   JSON_SensorArray2= json_object_dotget_array(JSON_SensorStatus, "subSensorStatus");
-  for (ii = 0; ii < pSensorDescriptor.nSubSensors; ii++)
+  for (ii = 0; ii < nSubSensors; ii++)
   {
     tempJSON2 = json_value_init_object();
-    create_JSON_SubSensorStatus(&sensor_status.subSensorStatus[ii], tempJSON2);
+    create_JSON_SubSensorStatus(&sensor_status->subSensorStatus[ii], tempJSON2);
     json_array_append_value(JSON_SensorArray2,tempJSON2);
   }
 }
@@ -836,46 +1364,75 @@ static void create_JSON_SubSensorStatus(COM_SubSensorStatus_t *sub_sensor_status
 #undef PRECISION6
 }
 
-static void create_JSON_SubSensorDescriptor(COM_SubSensorDescriptor_t *sub_sensor_descriptor, JSON_Value *tempJSON)
+/**
+* @brief  Name of one sensor type
+* @param  uint8_t SensorType COM_TYPE_xxx
+* @retval const char * Sensor type name
+*/
+static const char *ExtConfig_SensorTypeString(uint8_t SensorType)
 {
-  uint32_t ii = 0;
-  
-  JSON_Value *tempJSONarray = json_value_init_object();
-  JSON_Array *JSON_SensorArray = json_value_get_array(tempJSONarray);
-  JSON_Object *JSON_SubSensorDescriptor= json_value_get_object(tempJSON);
-
-  json_object_dotset_number(JSON_SubSensorDescriptor, "id", (double)(sub_sensor_descriptor->id));
-
-  switch (sub_sensor_descriptor->sensorType)
+  switch (SensorType)
   {
   case COM_TYPE_ACC:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "ACC");
-    break;
+    return "ACC";
   case COM_TYPE_MAG:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "MAG");
-    break;
+    return "MAG";
   case COM_TYPE_GYRO:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "GYRO");
-    break;
+    return "GYRO";
   case COM_TYPE_TEMP:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "TEMP");
-    break;
+    return "TEMP";
   case COM_TYPE_PRESS:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "PRESS");
-    break;
+    return "PRESS";
   case COM_TYPE_HUM:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "HUM");
-    break;
+    return "HUM";
   case COM_TYPE_MIC:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "MIC");
-    break;
+    return "MIC";
   case COM_TYPE_MLC:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "MLC");
-    break;
+    return "MLC";
   default:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", "NA");
-    break;
+    return "NA";
+  }
+}
+
+/**
+* @brief  Name of one data type
+* @param  uint8_t DataType DATA_TYPE_xxx
+* @retval const char * Data type name
+*/
+static const char *ExtConfig_DataTypeString(uint8_t DataType)
+{
+  switch (DataType)
+  {
+  case DATA_TYPE_UINT8:
+    return "uint8_t";
+  case DATA_TYPE_INT8:
+    return "int8_t";
+  case DATA_TYPE_UINT16:
+    return "uint16_t";
+  case DATA_TYPE_INT16:
+    return "int16_t";
+  case DATA_TYPE_UINT32:
+    return "uint32_t";
+  case DATA_TYPE_INT32:
+    return "int32_t";
+  case DATA_TYPE_FLOAT:
+    return "float";
+  default:
+    return "NA";
   }
+}
+
+static void create_JSON_SubSensorDescriptor(COM_SubSensorDescriptor_t *sub_sensor_descriptor, JSON_Value *tempJSON)
+{
+  uint32_t ii = 0;
+  
+  JSON_Value *tempJSONarray = json_value_init_object();
+  JSON_Array *JSON_SensorArray = json_value_get_array(tempJSONarray);
+  JSON_Object *JSON_SubSensorDescriptor= json_value_get_object(tempJSON);
+
+  json_object_dotset_number(JSON_SubSensorDescriptor, "id", (double)(sub_sensor_descriptor->id));
+
+  json_object_dotset_string(JSON_SubSensorDescriptor, "sensorType", ExtConfig_SensorTypeString(sub_sensor_descriptor->sensorType));
 
   json_object_dotset_number(JSON_SubSensorDescriptor, "dimensions", (double)sub_sensor_descriptor->dimensions);
 
@@ -889,33 +1446,7 @@ static void create_JSON_SubSensorDescriptor(COM_SubSensorDescriptor_t *sub_senso
 
   json_object_dotset_string(JSON_SubSensorDescriptor, "unit", sub_sensor_descriptor->unit);
 
-  switch (sub_sensor_descriptor->dataType)
-  {
-  case DATA_TYPE_UINT8:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "uint8_t");
-    break;
-  case DATA_TYPE_INT8:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "int8_t");
-    break;
-  case DATA_TYPE_UINT16:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "uint16_t");
-    break;
-  case DATA_TYPE_INT16:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "int16_t");
-    break;
-  case DATA_TYPE_UINT32:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "uint32_t");
-    break;
-  case DATA_TYPE_INT32:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "int32_t");
-    break;
-  case DATA_TYPE_FLOAT:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "float");
-    break;
-  default:
-    json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", "NA");
-    break;
-  }
+  json_object_dotset_string(JSON_SubSensorDescriptor, "dataType", ExtConfig_DataTypeString(sub_sensor_descriptor->dataType));
   ii=0;
 
   json_object_dotset_value(JSON_SubSensorDescriptor, "FS", json_value_init_array());
@@ -967,16 +1498,51 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     BLE_ExtConfigCommandType CommandType;
     uint8_t LocalBufferToWrite[2048];
     
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+    {
+      /* A CBOR command starts with a map (major type 5) instead of '{' */
+      uint8_t CommandCborEncoding = ((hs_command_buffer[0] & 0xE0U) == 0xA0U) ? 1U : 0U;
+      
+      if(ExtConfigEncodingSet==0U) {
+        /* The first command sets the encoding for the whole connection */
+        ExtConfigCborEncoding = CommandCborEncoding;
+        ExtConfigEncodingSet = 1U;
+      } else if(CommandCborEncoding!=ExtConfigCborEncoding) {
+        BLE_MANAGER_PRINTF("Error: Command encoding different from the connection one\r\n");
+        SendError("Only one encoding (JSON or CBOR) is allowed for each connection");
+        BLE_FreeFunction(hs_command_buffer);
+        return;
+      }
+    }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+    
+    BLE_MEM_PHASE_ENTER(BLE_MEM_PHASE_EXTCONFIG);
+    
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+    if(ExtConfigCborEncoding) {
+      CommandType = EXT_CONFIG_COM_NOT_VALID;
+      if(ExtConfig_CborDecodeCommand(hs_command_buffer,CommandBufLen,&ExtConfigCborCommand)) {
+        CommandType = ExtConfig_CommandTypeFromName(ExtConfigCborCommand.Command);
+      }
+    } else {
+      CommandType = BLE_ExtConfig_ExtractCommandType(hs_command_buffer);
+    }
+#else /* BLE_MANAGER_EXTCONFIG_CBOR */
     CommandType = BLE_ExtConfig_ExtractCommandType(hs_command_buffer);
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
     
     switch(CommandType)
     {
     case EXT_CONFIG_COM_READ_COMMAND:
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+      if(ExtConfig_SendCachedAnswer(EXT_CONFIG_CACHE_READ_COMMAND)) {
+        BLE_MANAGER_PRINTF("Command ReadCommand (cached)\r\n");
+        break;
+      }
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
       {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         int32_t WritingPointer=0;
         if(CustomExtConfigReadCustomCommandsCallback!=NULL) {
           WritingPointer+=sprintf((char *)LocalBufferToWrite+WritingPointer,"%s,",StandardExtConfigCommands[EXT_CONFIG_COM_READ_CUSTOM_COMMAND].CommandString);
@@ -1035,6 +1601,10 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         if(CustomExtConfigVersionFwCommandCallback!=NULL) {
           WritingPointer+=sprintf((char *)LocalBufferToWrite+WritingPointer,"%s,",StandardExtConfigCommands[EXT_CONFIG_COM_READ_VER_FW].CommandString);
         }
+#ifdef BLE_MANAGER_STATS
+        WritingPointer+=sprintf((char *)LocalBufferToWrite+WritingPointer,"%s,",StandardExtConfigCommands[EXT_CONFIG_COM_READ_STATS].CommandString);
+        WritingPointer+=sprintf((char *)LocalBufferToWrite+WritingPointer,"%s,",StandardExtConfigCommands[EXT_CONFIG_COM_RESET_STATS].CommandString);
+#endif /* BLE_MANAGER_STATS */
         
         if(WritingPointer!=0) {
           //Replace  the Latest ',' with the String Termination
@@ -1044,13 +1614,17 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         BLE_MANAGER_PRINTF("Command ReadCommand\r\n");
 
         json_object_dotset_string(tempJSON_Obj, "Commands", (char *)LocalBufferToWrite);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        /* Capability flag: the commands could be sent also with CBOR encoding */
+        json_object_dotset_string(tempJSON_Obj, "Encodings", "json,cbor");
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+        ExtConfig_CacheAndSendJsonAnswer(EXT_CONFIG_CACHE_READ_COMMAND,tempJSON);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+        ExtConfig_SendAnswer(tempJSON);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
         json_value_free(tempJSON);
         
         break;
@@ -1061,8 +1635,6 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigUidCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         uint8_t *uid;
         
         BLE_MANAGER_PRINTF("Command UID\r\n");
@@ -1075,23 +1647,101 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
                 uid[11],uid[ 10],uid[9],uid[8]);
         json_object_dotset_string(tempJSON_Obj, "UID", (char *)LocalBufferToWrite);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
         json_value_free(tempJSON);
       }
       break;
       
     case EXT_CONFIG_COM_READ_SENSOR_CONFIG:
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+      if(ExtConfig_SendCachedAnswer(EXT_CONFIG_CACHE_READ_SENSOR_CONFIG)) {
+        BLE_MANAGER_PRINTF("Command ReadSensorsConfigCommand (cached)\r\n");
+        break;
+      }
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+      if((ExtConfigCborEncoding) && (CustomExtConfigReadSensorsConfigCborCommandsCallback!=NULL)) {
+        /* Encode directly the COM_Sensor_t structures without building the JSON tree */
+        BLE_CborWriter_t Cbor;
+        
+        BLE_MANAGER_PRINTF("Command ReadSensorsConfigCommand (CBOR)\r\n");
+        
+        Cbor_InitWriter(&Cbor);
+        Cbor_PutHead(&Cbor,5U,1U);
+        Cbor_PutText(&Cbor,"sensor");
+        /* Indefinite length array */
+        Cbor_PutByte(&Cbor,0x9FU);
+        
+        //Filling the array
+        CustomExtConfigReadSensorsConfigCborCommandsCallback(&Cbor);
+        
+        /* Break for the indefinite length array */
+        Cbor_PutByte(&Cbor,0xFFU);
+        
+        if(Cbor.Error==0U) {
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+          ExtConfig_CacheAndSendAnswer(EXT_CONFIG_CACHE_READ_SENSOR_CONFIG,Cbor.Buffer,Cbor.Length);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+          BLE_ExtConfiguration_Update(Cbor.Buffer,Cbor.Length);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+        }
+        if(Cbor.Buffer!=NULL) {
+          BLE_FreeFunction(Cbor.Buffer);
+        }
+        break;
+      }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+      if(CustomExtConfigReadSensorsConfigStaticCommandsCallback!=NULL) {
+        /* The sensors descriptors are already serialized with JSON: only their status is serialized here */
+        BLE_JsonWriter_t Json = { { NULL, 0, 0 }, 0U };
+        
+        BLE_MANAGER_PRINTF("Command ReadSensorsConfigCommand (static descriptors)\r\n");
+        
+        Json.Error = (json_growable_buffer_append(&Json.Json,"{\"sensor\":[",11U)!=JSONSuccess);
+        
+        //Filling the array
+        CustomExtConfigReadSensorsConfigStaticCommandsCallback(&Json);
+        
+        if(Json.Error==0U) {
+          Json.Error = (json_growable_buffer_append(&Json.Json,"]}",2U)!=JSONSuccess);
+        }
+        
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if((Json.Error==0U) && (ExtConfigCborEncoding)) {
+          /* The answer goes through the same encoder of the other answers */
+          JSON_Value *tempJSON = json_parse_string(Json.Json.data);
+          
+          if(tempJSON!=NULL) {
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+            ExtConfig_CacheAndSendJsonAnswer(EXT_CONFIG_CACHE_READ_SENSOR_CONFIG,tempJSON);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+            ExtConfig_SendAnswer(tempJSON);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+            json_value_free(tempJSON);
+          } else {
+            BLE_MANAGER_PRINTF("Error: json_parse_string() failed\r\n");
+          }
+          json_free_serialized_string(Json.Json.data);
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        
+        if(Json.Error==0U) {
+          /* The answer length includes the null character */
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+          ExtConfig_CacheAndSendAnswer(EXT_CONFIG_CACHE_READ_SENSOR_CONFIG,(uint8_t *)Json.Json.data,Json.Json.length+1U);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+          BLE_ExtConfiguration_Update((uint8_t *)Json.Json.data,Json.Json.length+1U);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+        }
+        json_free_serialized_string(Json.Json.data);
+        break;
+      }
       if(CustomExtConfigReadSensorsConfigCommandsCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
         JSON_Array *JSON_SensorArray;
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         
         BLE_MANAGER_PRINTF("Command ReadSensorsConfigCommand\r\n");
 
@@ -1101,12 +1751,12 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         //Filling the array
         CustomExtConfigReadSensorsConfigCommandsCallback(JSON_SensorArray);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+        ExtConfig_CacheAndSendJsonAnswer(EXT_CONFIG_CACHE_READ_SENSOR_CONFIG,tempJSON);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+        ExtConfig_SendAnswer(tempJSON);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
         json_value_free(tempJSON);
       }
       break;
@@ -1115,8 +1765,6 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigVersionFwCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         
         BLE_MANAGER_PRINTF("Command VersionFw\r\n");
 
@@ -1124,12 +1772,9 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         
         json_object_dotset_string(tempJSON_Obj, "VersionFw", (char *)LocalBufferToWrite);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
+        json_value_free(tempJSON);
       }
       break;
       
@@ -1137,8 +1782,6 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigInfoCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         
         BLE_MANAGER_PRINTF("Command Info\r\n");
         
@@ -1147,12 +1790,9 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         
         json_object_dotset_string(tempJSON_Obj, "Info", (char *)LocalBufferToWrite);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
+        json_value_free(tempJSON);
       }
       break;
       
@@ -1160,8 +1800,6 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigHelpCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         
         BLE_MANAGER_PRINTF("Command Help\r\n");
            
@@ -1169,12 +1807,9 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         
         json_object_dotset_string(tempJSON_Obj, "Help", (char *)LocalBufferToWrite);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
+        json_value_free(tempJSON);
       }
       break;
       
@@ -1182,25 +1817,26 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
        if(CustomExtConfigPowerStatusCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         BLE_MANAGER_PRINTF("Command PowerStatus\r\n");
         
         CustomExtConfigPowerStatusCommandCallback(LocalBufferToWrite);
         
         json_object_dotset_string(tempJSON_Obj, "PowerStatus", (char *)LocalBufferToWrite);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-        BLE_FreeFunction(JSON_string_command);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
+        json_value_free(tempJSON);
       }
       break;
       
     case EXT_CONFIG_COM_READ_CUSTOM_COMMAND:
       if(CustomExtConfigReadCustomCommandsCallback!=NULL) {
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+        if(ExtConfig_SendCachedAnswer(EXT_CONFIG_CACHE_READ_CUSTOM_COMMAND)) {
+          BLE_MANAGER_PRINTF("Command ReadCustomCommand (cached)\r\n");
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
         SendNewCustomCommandList();
       }
       break;
@@ -1209,8 +1845,6 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigReadCertCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         
         BLE_MANAGER_PRINTF("Command PowerStatus\r\n");
         
@@ -1218,11 +1852,9 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         
         json_object_dotset_string(tempJSON_Obj, "Certificate", (char *)LocalBufferToWrite);
         
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-        
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
+        json_value_free(tempJSON);
         
       }
       break;
@@ -1245,6 +1877,10 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigClearDBCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command ClearDB\r\n");
         CustomExtConfigClearDBCommandCallback();
+#ifdef BLE_MANAGER_FAST_RECONNECT
+        /* The cleared centrals are not targets of the reconnect advertising anymore */
+        BLE_ReconnectClearCache();
+#endif /* BLE_MANAGER_FAST_RECONNECT */
       }
       break;
       
@@ -1252,8 +1888,6 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigReadBanksFwIdCommandCallback!=NULL) {
         JSON_Value *tempJSON = json_value_init_object();
         JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-        char* JSON_string_command = NULL;
-        uint32_t JSON_size =0;
         uint8_t CurBank;
         uint16_t FwId1,FwId2;
 
@@ -1266,11 +1900,8 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
         sprintf((char *)LocalBufferToWrite,"0x%02X",FwId2);
         json_object_dotset_string(tempJSON_Obj, "BankStatus.fwId2", (char *)LocalBufferToWrite);
 
-        /* convert to a json string and write as string */
-        JSON_string_command = json_serialize_to_string(tempJSON);
-        JSON_size = json_serialization_size(tempJSON);
-
-        BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
+        /* serialize it and write it */
+        ExtConfig_SendAnswer(tempJSON);
         json_value_free(tempJSON);
       }
       break;
@@ -1282,16 +1913,37 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       }
       break;
       
+#ifdef BLE_MANAGER_STATS
+    case EXT_CONFIG_COM_READ_STATS:
+      BLE_MANAGER_PRINTF("Command ReadStats\r\n");
+      ExtConfig_SendStats();
+      break;
+      
+    case EXT_CONFIG_COM_RESET_STATS:
+      BLE_MANAGER_PRINTF("Command ResetStats\r\n");
+      BLE_StatsReset();
+      SendInfo("Stats reset");
+      break;
+#endif /* BLE_MANAGER_STATS */
+      
       // Command with argument
     case EXT_CONFIG_COM_SET_DATE:
       if(CustomExtConfigSetDateCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command SetDate\r\n");
-      
-        JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          if(ExtConfigCborCommand.ArgString!=NULL) {
+            CustomExtConfigSetDateCommandCallback((uint8_t *)ExtConfigCborCommand.ArgString);
+          }
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        /* The command buffer is not used anymore: parse it in place */
+        JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
         JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-        if (strcmp(json_object_dotget_string(JSON_ParseHandler,"command"),"SetDate") == 0) {
-          if(json_object_dothas_value(JSON_ParseHandler,"argString")) {
-            uint8_t *NewDate = (uint8_t *)json_object_dotget_string(JSON_ParseHandler,"argString");
+        if (strcmp(json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),"SetDate") == 0) {
+          if(json_object_pathhas_value(JSON_ParseHandler,&ExtConfigPathArgString)) {
+            uint8_t *NewDate = (uint8_t *)json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathArgString);
             CustomExtConfigSetDateCommandCallback(NewDate);
           }
         }
@@ -1302,12 +1954,19 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     case EXT_CONFIG_COM_SET_TIME:
        if(CustomExtConfigSetTimeCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command SetTime\r\n");
-     
-        JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          if(ExtConfigCborCommand.ArgString!=NULL) {
+            CustomExtConfigSetTimeCommandCallback((uint8_t *)ExtConfigCborCommand.ArgString);
+          }
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
         JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-        if (strcmp(json_object_dotget_string(JSON_ParseHandler,"command"),"SetTime") == 0) {
-          if(json_object_dothas_value(JSON_ParseHandler,"argString")) {
-            uint8_t *NewTime = (uint8_t *)json_object_dotget_string(JSON_ParseHandler,"argString");
+        if (strcmp(json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),"SetTime") == 0) {
+          if(json_object_pathhas_value(JSON_ParseHandler,&ExtConfigPathArgString)) {
+            uint8_t *NewTime = (uint8_t *)json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathArgString);
             CustomExtConfigSetTimeCommandCallback(NewTime);
           }
         }
@@ -1318,11 +1977,19 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     case EXT_CONFIG_COM_SET_NAME:
        if(CustomExtConfigSetNameCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command SetName\r\n");
-        JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          if(ExtConfigCborCommand.ArgString!=NULL) {
+            CustomExtConfigSetNameCommandCallback((uint8_t *)ExtConfigCborCommand.ArgString);
+          }
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
         JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-        if (strcmp(json_object_dotget_string(JSON_ParseHandler,"command"),"SetName") == 0) {
-          if(json_object_dothas_value(JSON_ParseHandler,"argString")) {
-            uint8_t *NewBoardName = (uint8_t *)json_object_dotget_string(JSON_ParseHandler,"argString");
+        if (strcmp(json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),"SetName") == 0) {
+          if(json_object_pathhas_value(JSON_ParseHandler,&ExtConfigPathArgString)) {
+            uint8_t *NewBoardName = (uint8_t *)json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathArgString);
             CustomExtConfigSetNameCommandCallback(NewBoardName);
           }
         }
@@ -1333,9 +2000,21 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     case EXT_CONFIG_COM_SET_WIFI:
       if(CustomExtConfigSetWiFiCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command SetWiFi\r\n");
-        JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          if((ExtConfigCborCommand.Ssid!=NULL) && (ExtConfigCborCommand.Password!=NULL) && (ExtConfigCborCommand.SecurityType!=NULL)) {
+            BLE_WiFi_CredAcc_t NewWiFiCred;
+            NewWiFiCred.SSID     = (uint8_t *)ExtConfigCborCommand.Ssid;
+            NewWiFiCred.PassWd   = (uint8_t *)ExtConfigCborCommand.Password;
+            NewWiFiCred.Security = (uint8_t *)ExtConfigCborCommand.SecurityType;
+            CustomExtConfigSetWiFiCommandCallback(NewWiFiCred);
+          }
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
         JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-        if (strcmp(json_object_dotget_string(JSON_ParseHandler,"command"),"SetWiFi") == 0) {
+        if (strcmp(json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),"SetWiFi") == 0) {
           JSON_Object *JSON_Wifi = json_object_dotget_object(JSON_ParseHandler,"argJsonElement");
           if(json_object_dothas_value(JSON_Wifi,"ssid")) {
             BLE_WiFi_CredAcc_t NewWiFiCred;
@@ -1356,12 +2035,20 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     case EXT_CONFIG_COM_CHANGE_PIN:
        if(CustomExtConfigChangePinCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command ChangePIN\r\n");
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          if(ExtConfigCborCommand.HasArgNumber) {
+            CustomExtConfigChangePinCommandCallback((uint32_t)ExtConfigCborCommand.ArgNumber);
+          }
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
      
-        JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+        JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
         JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-        if (strcmp(json_object_dotget_string(JSON_ParseHandler,"command"),"ChangePIN") == 0) {
-          if(json_object_dothas_value(JSON_ParseHandler,"argNumber")) {
-            uint32_t NewBoardPin = (uint32_t)json_object_dotget_number(JSON_ParseHandler,"argNumber");
+        if (strcmp(json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),"ChangePIN") == 0) {
+          if(json_object_pathhas_value(JSON_ParseHandler,&ExtConfigPathArgNumber)) {
+            uint32_t NewBoardPin = (uint32_t)json_object_pathget_number(JSON_ParseHandler,&ExtConfigPathArgNumber);
             CustomExtConfigChangePinCommandCallback(NewBoardPin);
           }
         }
@@ -1372,12 +2059,19 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     case EXT_CONFIG_COM_SET_CERT:
       if(CustomExtConfigSetCertCommandCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command SetCert\r\n");
-        
-        JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          if(ExtConfigCborCommand.ArgString!=NULL) {
+            CustomExtConfigSetCertCommandCallback((uint8_t *)ExtConfigCborCommand.ArgString);
+          }
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
         JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-        if (strcmp(json_object_dotget_string(JSON_ParseHandler,"command"),"SetCert") == 0) {
-          if(json_object_dothas_value(JSON_ParseHandler,"argString")) {
-            uint8_t *NewCertificate = (uint8_t *)json_object_dotget_string(JSON_ParseHandler,"argString");
+        if (strcmp(json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),"SetCert") == 0) {
+          if(json_object_pathhas_value(JSON_ParseHandler,&ExtConfigPathArgString)) {
+            uint8_t *NewCertificate = (uint8_t *)json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathArgString);
             CustomExtConfigSetCertCommandCallback(NewCertificate);
           }
         }
@@ -1388,6 +2082,15 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
     case EXT_CONFIG_COM_SET_SENSOR_CONFIG:
       if(CustomExtConfigSetSensorsConfigCommandsCallback!=NULL) {
         BLE_MANAGER_PRINTF("Command SetSensorsConfigCommand\r\n");
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+        if(ExtConfigCborEncoding) {
+          /* The application parses by itself the sensors configuration */
+          SendError("SetSensorsConfig needs JSON encoding");
+          break;
+        }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+        /* The answer for ReadSensorsConfig is no more valid */
+        BLE_ExtConfigInvalidateCachedAnswers();
         CustomExtConfigSetSensorsConfigCommandsCallback(hs_command_buffer);
       }
       break;
@@ -1397,7 +2100,17 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       if(CustomExtConfigCustomCommandCallback!=NULL) {
         /* we need at least one Custom Command */
         if(ExtConfigCustomCommands!=NULL) {
-          BLE_CustomCommadResult_t *CommandResult = ParseCustomCommand(ExtConfigCustomCommands,hs_command_buffer);
+          BLE_CustomCommadResult_t *CommandResult;
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+          if(ExtConfigCborEncoding) {
+            CommandResult = BuildCustomCommandResult(ExtConfigCustomCommands,ExtConfigCborCommand.Command,
+                                                     ExtConfigCborCommand.ArgString,ExtConfigCborCommand.HasArgNumber,ExtConfigCborCommand.ArgNumber);
+          } else {
+            CommandResult = ParseCustomCommandInsitu(ExtConfigCustomCommands,hs_command_buffer);
+          }
+#else /* BLE_MANAGER_EXTCONFIG_CBOR */
+          CommandResult = ParseCustomCommandInsitu(ExtConfigCustomCommands,hs_command_buffer);
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
           if(CommandResult!=NULL) {
             CustomExtConfigCustomCommandCallback(CommandResult);
             if(CommandResult->CommandName!=NULL) {
@@ -1417,6 +2130,8 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
       break;
     }
     BLE_FreeFunction(hs_command_buffer);
+    
+    BLE_MEM_PHASE_EXIT(BLE_MEM_PHASE_EXTCONFIG);
   }
 }
 
@@ -1428,17 +2143,77 @@ static void Write_Request_ExtConfig(void *VoidCharPointer,uint16_t attr_handle,
 */
 BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCommands,uint8_t *hs_command_buffer)                        
 {
-  BLE_CustomCommadResult_t *CommandResult=NULL;
-  uint8_t ValidCustomCommand=0;
+  BLE_CustomCommadResult_t *CommandResult;
   JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
+  
+  CommandResult = CustomCommandResultFromJson(LocCustomCommands,tempJSON);
+  json_value_free(tempJSON);
+  
+  return CommandResult;
+}
+
+/**
+* @brief  Like ParseCustomCommand but the json formatted string is parsed in place,
+*         so the buffer can not be used anymore after this call
+* @param  BLE_ExtCustomCommand_t *LocCustomCommands Pointer to the Custom Commands List
+* @param  uint8_t *hs_command_buffer pointer to json formatted string
+* @retval BLE_CustomCommadResult_t *CommandResult
+*/
+static BLE_CustomCommadResult_t *ParseCustomCommandInsitu(BLE_ExtCustomCommand_t *LocCustomCommands,uint8_t *hs_command_buffer)
+{
+  BLE_CustomCommadResult_t *CommandResult;
+  JSON_Value *tempJSON = json_parse_string_insitu( (char *) hs_command_buffer);
+  
+  CommandResult = CustomCommandResultFromJson(LocCustomCommands,tempJSON);
+  json_value_free(tempJSON);
+  
+  return CommandResult;
+}
+
+/**
+* @brief  This function Try to search if there is a valid Custom Command inside one parsed json command
+* @param  BLE_ExtCustomCommand_t *LocCustomCommands Pointer to the Custom Commands List
+* @param  JSON_Value *tempJSON parsed json command
+* @retval BLE_CustomCommadResult_t *CommandResult
+*/
+static BLE_CustomCommadResult_t *CustomCommandResultFromJson(BLE_ExtCustomCommand_t *LocCustomCommands,JSON_Value *tempJSON)
+{
   JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
+  uint8_t HasArgNumber = (uint8_t)json_object_pathhas_value(JSON_ParseHandler,&ExtConfigPathArgNumber);
+  
+  return BuildCustomCommandResult(LocCustomCommands,
+                                  json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathCommand),
+                                  json_object_pathget_string(JSON_ParseHandler,&ExtConfigPathArgString),
+                                  HasArgNumber,
+                                  json_object_pathget_number(JSON_ParseHandler,&ExtConfigPathArgNumber));
+}
+
+/**
+* @brief  This function Try to search if there is a valid Custom Command with the already extracted arguments
+* @param  BLE_ExtCustomCommand_t *LocCustomCommands Pointer to the Custom Commands List
+* @param  const char *CommandName command name
+* @param  const char *ArgString argString value (NULL if not present)
+* @param  uint8_t HasArgNumber 1 if argNumber is present
+* @param  double ArgNumber argNumber value
+* @retval BLE_CustomCommadResult_t *CommandResult
+*/
+static BLE_CustomCommadResult_t *BuildCustomCommandResult(BLE_ExtCustomCommand_t *LocCustomCommands,const char *CommandName,
+                                                          const char *ArgString,uint8_t HasArgNumber,double ArgNumber)
+{
+  BLE_CustomCommadResult_t *CommandResult=NULL;
+  uint8_t ValidCustomCommand=0;
   /* Start from beginning of Custom Commands list*/
   BLE_ExtCustomCommand_t *LocLastCustomCommand = LocCustomCommands;
   
+  if(CommandName==NULL) {
+    BLE_MANAGER_PRINTF("Error: Custom Command without name\r\n");
+    return NULL;
+  }
+  
   /* Search if it's a custom Command defined by user */
   while((ValidCustomCommand==0U) && (LocLastCustomCommand!=NULL)){
     /* Check the command name */
-    if (strncmp(json_object_dotget_string(JSON_ParseHandler,"command"),LocLastCustomCommand->CommandName,strlen(json_object_dotget_string(JSON_ParseHandler,"command"))) == 0) {
+    if (strncmp(CommandName,LocLastCustomCommand->CommandName,strlen(CommandName)) == 0) {
       ValidCustomCommand=1;
     }
     /* Move to the Next Command if we didn't find nothing*/
@@ -1451,16 +2226,20 @@ BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCo
     CommandResult = (BLE_CustomCommadResult_t *) BLE_MallocFunction(sizeof(BLE_CustomCommadResult_t));
     if(CommandResult == NULL) {
       BLE_MANAGER_PRINTF("Error: Mem alloc error: %d@%s\r\n", __LINE__, __FILE__);
+      return NULL;
     }
     
     CommandResult->CommandName = (uint8_t*)BLE_MallocFunction(strlen((char*)LocLastCustomCommand->CommandName)+1U);
     if(CommandResult->CommandName==NULL) {
       BLE_MANAGER_PRINTF("Error: Mem alloc error: %d@%s\r\n", __LINE__, __FILE__);
       BLE_FreeFunction(CommandResult);
-    } else {
-      sprintf((char *)CommandResult->CommandName,"%s",(char *)LocLastCustomCommand->CommandName);
-      CommandResult->CommandType= LocLastCustomCommand->CommandType;
+      return NULL;
     }
+    sprintf((char *)CommandResult->CommandName,"%s",(char *)LocLastCustomCommand->CommandName);
+    CommandResult->CommandType= LocLastCustomCommand->CommandType;
+    /* Default values for missing arguments */
+    CommandResult->IntValue= 0;
+    CommandResult->StringValue= NULL;
     
     switch(LocLastCustomCommand->CommandType) { 
     case BLE_CUSTOM_COMMAND_VOID:
@@ -1472,8 +2251,8 @@ BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCo
       }
     case BLE_CUSTOM_COMMAND_INTEGER:
     case BLE_CUSTOM_COMMAND_ENUM_INTEGER:
-      if(json_object_dothas_value(JSON_ParseHandler,"argNumber")) {
-        int32_t NewValue = (int32_t)json_object_dotget_number(JSON_ParseHandler,"argNumber");
+      if(HasArgNumber) {
+        int32_t NewValue = (int32_t)ArgNumber;
         CommandResult->IntValue= NewValue;
         CommandResult->StringValue= NULL;
         BLE_MANAGER_PRINTF("Called Custom Integer Command <%s>\r\n",LocLastCustomCommand->CommandName);
@@ -1481,8 +2260,8 @@ BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCo
       }
       break;
     case BLE_CUSTOM_COMMAND_BOOLEAN:
-      if(json_object_dothas_value(JSON_ParseHandler,"argString")) {
-        uint8_t *NewString = (uint8_t *)json_object_dotget_string(JSON_ParseHandler,"argString");
+      if(ArgString!=NULL) {
+        uint8_t *NewString = (uint8_t *)ArgString;
         
         if(strncmp((char*)NewString,"true",4)==0)
           CommandResult->IntValue= 1;
@@ -1497,13 +2276,15 @@ BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCo
       break;
     case BLE_CUSTOM_COMMAND_STRING:
     case BLE_CUSTOM_COMMAND_ENUM_STRING:
-      if(json_object_dothas_value(JSON_ParseHandler,"argString")) {
-        uint8_t *NewString = (uint8_t *)json_object_dotget_string(JSON_ParseHandler,"argString");
+      if(ArgString!=NULL) {
+        uint8_t *NewString = (uint8_t *)ArgString;
         CommandResult->IntValue= 0;
         CommandResult->StringValue = (uint8_t*)BLE_MallocFunction(strlen((char*)NewString)+1U);
         if(CommandResult->StringValue==NULL) {
           BLE_MANAGER_PRINTF("Error: Mem alloc error: %d@%s\r\n", __LINE__, __FILE__);
+          BLE_FreeFunction(CommandResult->CommandName);
           BLE_FreeFunction(CommandResult);
+          CommandResult = NULL;
         } else {
           sprintf((char *)CommandResult->StringValue,"%s",(char *)NewString);
           BLE_MANAGER_PRINTF("Called Custom String Command <%s>\r\n",LocLastCustomCommand->CommandName);
@@ -1515,7 +2296,6 @@ BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCo
       break;
     }
   }
-  json_value_free(tempJSON);
   
   if(ValidCustomCommand==0U) {
     BLE_MANAGER_PRINTF("Error: Custom Command Not Valid\r\n");
@@ -1531,6 +2311,9 @@ BLE_CustomCommadResult_t *ParseCustomCommand(BLE_ExtCustomCommand_t *LocCustomCo
 * @retval None
 */
 void GenericClearCustomCommandsList(BLE_ExtCustomCommand_t **LocCustomCommands, BLE_ExtCustomCommand_t **LocLastCustomCommand) {
+  /* The cached list of Custom Commands is no more valid */
+  BLE_ExtConfigInvalidateCachedAnswers();
+  
   if((*LocCustomCommands)!=NULL) {
     if((*LocCustomCommands)->NextCommand!=NULL) {
       ClearSingleCommand((BLE_ExtCustomCommand_t *)(*LocCustomCommands)->NextCommand);
@@ -1589,7 +2372,12 @@ uint8_t GenericAddCustomCommand(BLE_ExtCustomCommand_t **LocCustomCommands, BLE_
   //If the Command Name is different from one Standard Command Name
   if(Valid) {
     JSON_Value *tempJSON1;
+    BLE_ExtCustomCommand_t *NewCustomCommand;
     JSON_Object *tempJSON1_Obj;
+    
+    /* The cached list of Custom Commands is no more valid */
+    BLE_ExtConfigInvalidateCachedAnswers();
+    
     tempJSON1 = json_value_init_object();
     tempJSON1_Obj = json_value_get_object(tempJSON1);
     
@@ -1677,35 +2465,31 @@ uint8_t GenericAddCustomCommand(BLE_ExtCustomCommand_t **LocCustomCommands, BLE_
     
     json_array_append_value(JSON_SensorArray,tempJSON1);
     
-    //Allocate a New Custom Command entry
-    if((*LocCustomCommands)==NULL) {
-      (*LocCustomCommands)=(BLE_ExtCustomCommand_t*)BLE_MallocFunction(sizeof(BLE_ExtCustomCommand_t));
-      
-      if((*LocCustomCommands)==NULL) {
-        BLE_MANAGER_PRINTF("Errror: Mem calloc error: %d@%s\r\n",__LINE__,__FILE__);
-        return 0;
-      }
-      
-      (*LocLastCustomCommand) = (*LocCustomCommands);
-    } else {
-      (*LocLastCustomCommand)->NextCommand = (void *) BLE_MallocFunction( sizeof(BLE_ExtCustomCommand_t));
-      if((*LocCustomCommands)==NULL) {
-        BLE_MANAGER_PRINTF("Error: Mem calloc error %d@%s\r\n",__LINE__,__FILE__);
-        return 0;
-      }
-      (*LocLastCustomCommand) = (BLE_ExtCustomCommand_t*) (*LocLastCustomCommand)->NextCommand;
+    //Allocate a New Custom Command entry (complete before linking it to the list)
+    NewCustomCommand = (BLE_ExtCustomCommand_t*)BLE_MallocFunction(sizeof(BLE_ExtCustomCommand_t));
+    if(NewCustomCommand==NULL) {
+      BLE_MANAGER_PRINTF("Error: Mem calloc error: %d@%s\r\n",__LINE__,__FILE__);
+      return 0;
     }
-    //Fill the Custom Command
-    (*LocLastCustomCommand)->CommandType = CommandType;
     
     //Alloc the size for commandName
-    (*LocLastCustomCommand)->CommandName = BLE_MallocFunction(strlen(CommandName)+1U);
-     if(((*LocLastCustomCommand)->CommandName)==NULL) {
-       BLE_MANAGER_PRINTF("Error: Mem calloc error %d@%s\r\n",__LINE__,__FILE__);
-       return 0;
-     }
-    sprintf((*LocLastCustomCommand)->CommandName,"%s",CommandName);
-    (*LocLastCustomCommand)->NextCommand = NULL;
+    NewCustomCommand->CommandName = BLE_MallocFunction(strlen(CommandName)+1U);
+    if((NewCustomCommand->CommandName)==NULL) {
+      BLE_MANAGER_PRINTF("Error: Mem calloc error %d@%s\r\n",__LINE__,__FILE__);
+      BLE_FreeFunction(NewCustomCommand);
+      return 0;
+    }
+    sprintf(NewCustomCommand->CommandName,"%s",CommandName);
+    //Fill the Custom Command
+    NewCustomCommand->CommandType = CommandType;
+    NewCustomCommand->NextCommand = NULL;
+    
+    if((*LocCustomCommands)==NULL) {
+      (*LocCustomCommands) = NewCustomCommand;
+    } else {
+      (*LocLastCustomCommand)->NextCommand = (void *) NewCustomCommand;
+    }
+    (*LocLastCustomCommand) = NewCustomCommand;
 #if (BLE_DEBUG_LEVEL>1)
     BLE_MANAGER_PRINTF("Adding Custom Command<%s>\r\n",(*LocLastCustomCommand)->CommandName);
 #endif
@@ -1723,8 +2507,6 @@ void SendNewCustomCommandList(void) {
   JSON_Value *tempJSON = json_value_init_object();
   JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
   JSON_Array *JSON_SensorArray;
-  char* JSON_string_command = NULL;
-  uint32_t JSON_size =0;
   
   BLE_MANAGER_PRINTF("Command SendNewCustomCommandList\r\n");
 
@@ -1734,12 +2516,13 @@ void SendNewCustomCommandList(void) {
   //Filling the array
   CustomExtConfigReadCustomCommandsCallback(JSON_SensorArray);
   
-  /* convert to a json string and write as string */
-  JSON_string_command = json_serialize_to_string(tempJSON);
-  JSON_size = json_serialization_size(tempJSON);
-  
-  BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-  BLE_FreeFunction(JSON_string_command);
+  /* serialize it and write it */
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+  /* The list is stamped with the version reached after the callback (that usually clears and adds again the Custom Commands) */
+  ExtConfig_CacheAndSendJsonAnswer(EXT_CONFIG_CACHE_READ_CUSTOM_COMMAND,tempJSON);
+#else /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+  ExtConfig_SendAnswer(tempJSON);
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
   json_value_free(tempJSON);
 }
 
@@ -1752,20 +2535,14 @@ extern void SendError(char *message)
 {
   JSON_Value *tempJSON = json_value_init_object();
   JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-  char* JSON_string_command = NULL;
-  uint32_t JSON_size =0;
   
   BLE_MANAGER_PRINTF("Command SendError\r\n");
   
   json_object_dotset_string(tempJSON_Obj, "Error", message);
   
-  /* convert to a json string and write as string */
-  JSON_string_command = json_serialize_to_string(tempJSON);
-  JSON_size = json_serialization_size(tempJSON);
-  
-  BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-  BLE_FreeFunction(JSON_string_command);
-  
+  /* serialize it and write it */
+  ExtConfig_SendAnswer(tempJSON);
+  json_value_free(tempJSON);
 }
 
 /**
@@ -1777,19 +2554,14 @@ void SendInfo(char *message)
 {
   JSON_Value *tempJSON = json_value_init_object();
   JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
-  char* JSON_string_command = NULL;
-  uint32_t JSON_size =0;
   
   BLE_MANAGER_PRINTF("Command SendInfo\r\n");
   
   json_object_dotset_string(tempJSON_Obj, "Info", message);
   
-  /* convert to a json string and write as string */
-  JSON_string_command = json_serialize_to_string(tempJSON);
-  JSON_size = json_serialization_size(tempJSON);
-  
-  BLE_ExtConfiguration_Update((uint8_t*) JSON_string_command,JSON_size);
-  BLE_FreeFunction(JSON_string_command);
+  /* serialize it and write it */
+  ExtConfig_SendAnswer(tempJSON);
+  json_value_free(tempJSON);
 }
 
 void create_JSON_Sensor(COM_Sensor_t *sensor, JSON_Value *tempJSON)
@@ -1807,10 +2579,193 @@ void create_JSON_Sensor(COM_Sensor_t *sensor, JSON_Value *tempJSON)
   
   JSON_Value *statusJSON = json_value_init_object();
   json_object_set_value(JSON_Sensor, "sensorStatus", statusJSON);
-  create_JSON_SensorStatus(sensor, statusJSON);
+  create_JSON_SensorStatus(&sensor->sensorStatus, sensor->sensorDescriptor.nSubSensors, statusJSON);
+}
+
+/**
+* @brief  Add one sensor to the ReadSensorsConfig answer, starting from its descriptor serialized
+*         at compile time with BLE_SENSOR_DESCRIPTOR_JSON. Only the status is serialized at runtime.
+*         With a CBOR connection the whole answer is encoded again with CBOR before sending it
+* @param  const char *SensorDescriptor serialized sensor descriptor
+* @param  COM_SensorStatus_t *sensor_status sensor status
+* @param  uint32_t nSubSensors number of sub sensors
+* @param  BLE_JsonWriter_t *Json ReadSensorsConfig answer
+* @retval None
+*/
+void create_JSON_SensorFromDescriptor(const char *SensorDescriptor, COM_SensorStatus_t *sensor_status, uint32_t nSubSensors, BLE_JsonWriter_t *Json)
+{
+  JSON_Value *statusJSON;
+  
+  if(Json->Error) {
+    return;
+  }
+  
+  /* Separator from the previous sensor */
+  if((Json->Json.length>0U) && (Json->Json.data[Json->Json.length-1U]!='[')) {
+    Json->Error |= (json_growable_buffer_append(&Json->Json,",",1U)!=JSONSuccess);
+  }
+  Json->Error |= (json_growable_buffer_append(&Json->Json,SensorDescriptor,strlen(SensorDescriptor))!=JSONSuccess);
+  Json->Error |= (json_growable_buffer_append(&Json->Json,",\"sensorStatus\":",16U)!=JSONSuccess);
+  
+  statusJSON = json_value_init_object();
+  create_JSON_SensorStatus(sensor_status, MIN(nSubSensors,N_MAX_SENSOR_COMBO), statusJSON);
+  Json->Error |= (json_serialize_to_growable_buffer(statusJSON,&Json->Json)!=JSONSuccess);
+  json_value_free(statusJSON);
+  
+  Json->Error |= (json_growable_buffer_append(&Json->Json,"}",1U)!=JSONSuccess);
+}
+
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+/**
+* @brief  Encode one sensor with CBOR, with the same structure of create_JSON_Sensor
+* @param  COM_Sensor_t *sensor sensor to encode
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @retval None
+*/
+void create_CBOR_Sensor(COM_Sensor_t *sensor, BLE_CborWriter_t *Cbor)
+{
+  uint32_t ii;
+  uint32_t nSubSensors = MIN(sensor->sensorDescriptor.nSubSensors,N_MAX_SENSOR_COMBO);
+  
+  Cbor_PutHead(Cbor,5U,4U);
+  Cbor_PutText(Cbor,"id");
+  Cbor_PutInt(Cbor,(int32_t)sensor->sensorDescriptor.id);
+  Cbor_PutText(Cbor,"name");
+  Cbor_PutText(Cbor,sensor->sensorDescriptor.name);
+  
+  Cbor_PutText(Cbor,"sensorDescriptor");
+  Cbor_PutHead(Cbor,5U,1U);
+  Cbor_PutText(Cbor,"subSensorDescriptor");
+  Cbor_PutHead(Cbor,4U,nSubSensors);
+  for (ii = 0; ii < nSubSensors; ii++)
+  {
+    create_CBOR_SubSensorDescriptor(&sensor->sensorDescriptor.subSensorDescriptor[ii], Cbor);
+  }
+  
+  Cbor_PutText(Cbor,"sensorStatus");
+  Cbor_PutHead(Cbor,5U,1U);
+  Cbor_PutText(Cbor,"subSensorStatus");
+  Cbor_PutHead(Cbor,4U,nSubSensors);
+  for (ii = 0; ii < nSubSensors; ii++)
+  {
+    create_CBOR_SubSensorStatus(&sensor->sensorStatus.subSensorStatus[ii], Cbor);
+  }
+}
+
+static void create_CBOR_SubSensorDescriptor(COM_SubSensorDescriptor_t *sub_sensor_descriptor, BLE_CborWriter_t *Cbor)
+{
+  uint32_t ii;
+  uint32_t nValues;
+  uint32_t nDimensions = MIN(sub_sensor_descriptor->dimensions,N_MAX_DIM_LABELS);
+  
+  Cbor_PutHead(Cbor,5U,9U);
+  
+  Cbor_PutText(Cbor,"id");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_descriptor->id);
+  Cbor_PutText(Cbor,"sensorType");
+  Cbor_PutText(Cbor,ExtConfig_SensorTypeString(sub_sensor_descriptor->sensorType));
+  Cbor_PutText(Cbor,"dimensions");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_descriptor->dimensions);
+  
+  Cbor_PutText(Cbor,"dimensionsLabel");
+  Cbor_PutHead(Cbor,4U,nDimensions);
+  for (ii=0; ii < nDimensions; ii++)
+  {
+    Cbor_PutText(Cbor,sub_sensor_descriptor->dimensionsLabel[ii]);
+  }
+  
+  Cbor_PutText(Cbor,"unit");
+  Cbor_PutText(Cbor,sub_sensor_descriptor->unit);
+  Cbor_PutText(Cbor,"dataType");
+  Cbor_PutText(Cbor,ExtConfig_DataTypeString(sub_sensor_descriptor->dataType));
+  
+  /* The lists are terminated by a not positive value */
+  for(nValues=0; (nValues<N_MAX_SUPPORTED_FS) && (sub_sensor_descriptor->FS[nValues] > 0.0f); nValues++) {
+  }
+  Cbor_PutText(Cbor,"FS");
+  Cbor_PutHead(Cbor,4U,nValues);
+  for (ii=0; ii < nValues; ii++)
+  {
+    Cbor_PutFloat(Cbor,sub_sensor_descriptor->FS[ii]);
+  }
+  
+  for(nValues=0; (nValues<N_MAX_SUPPORTED_ODR) && (sub_sensor_descriptor->ODR[nValues] > 0.0f); nValues++) {
+  }
+  Cbor_PutText(Cbor,"ODR");
+  Cbor_PutHead(Cbor,4U,nValues);
+  for (ii=0; ii < nValues; ii++)
+  {
+    Cbor_PutFloat(Cbor,sub_sensor_descriptor->ODR[ii]);
+  }
+  
+  Cbor_PutText(Cbor,"samplesPerTs");
+  Cbor_PutHead(Cbor,5U,3U);
+  Cbor_PutText(Cbor,"min");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_descriptor->samplesPerTimestamp[0]);
+  Cbor_PutText(Cbor,"max");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_descriptor->samplesPerTimestamp[1]);
+  Cbor_PutText(Cbor,"dataType");
+  Cbor_PutText(Cbor,"int16_t");
 }
+
+static void create_CBOR_SubSensorStatus(COM_SubSensorStatus_t *sub_sensor_status, BLE_CborWriter_t *Cbor)
+{
+  Cbor_PutHead(Cbor,5U,12U);
+  
+  Cbor_PutText(Cbor,"ODR");
+  Cbor_PutFloat(Cbor,sub_sensor_status->ODR);
+  Cbor_PutText(Cbor,"ODRMeasured");
+  Cbor_PutFloat(Cbor,sub_sensor_status->measuredODR);
+  Cbor_PutText(Cbor,"initialOffset");
+  Cbor_PutFloat(Cbor,sub_sensor_status->initialOffset);
+  Cbor_PutText(Cbor,"FS");
+  Cbor_PutFloat(Cbor,sub_sensor_status->FS);
+  Cbor_PutText(Cbor,"sensitivity");
+  Cbor_PutFloat(Cbor,sub_sensor_status->sensitivity);
+  Cbor_PutText(Cbor,"isActive");
+  Cbor_PutByte(Cbor,(sub_sensor_status->isActive!=0U) ? 0xF5U : 0xF4U);
+  Cbor_PutText(Cbor,"samplesPerTs");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_status->samplesPerTimestamp);
+  Cbor_PutText(Cbor,"usbDataPacketSize");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_status->usbDataPacketSize);
+  Cbor_PutText(Cbor,"sdWriteBufferSize");
+  Cbor_PutHead(Cbor,0U,sub_sensor_status->sdWriteBufferSize);
+  Cbor_PutText(Cbor,"wifiDataPacketSize");
+  Cbor_PutHead(Cbor,0U,sub_sensor_status->wifiDataPacketSize);
+  Cbor_PutText(Cbor,"comChannelNumber");
+  Cbor_PutInt(Cbor,(int32_t)sub_sensor_status->comChannelNumber);
+  Cbor_PutText(Cbor,"ucfLoaded");
+  Cbor_PutByte(Cbor,(sub_sensor_status->ucfLoaded!=0U) ? 0xF5U : 0xF4U);
+}
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
 #endif /* BLE_MANAGER_NO_PARSON */
 
+/**
+* @brief  Check if the data written on the Term is one command (followed only by blanks or line terminators)
+* @param  const char *Command command name
+* @param  uint8_t data_length length of the data
+* @param  uint8_t *att_data attribute data
+* @retval uint8_t 1 if the data is the command, 0 otherwise
+*/
+uint8_t Term_IsCommand(const char *Command, uint8_t data_length, uint8_t *att_data)
+{
+  uint32_t Length = strlen(Command);
+  uint32_t Pos;
+  
+  if((data_length < Length) || (strncmp(Command,(char *)(att_data),Length)!=0)) {
+    return 0;
+  }
+  
+  /* "memory" is not "mem" */
+  for(Pos=Length; Pos<data_length; Pos++) {
+    if((att_data[Pos]!=(uint8_t)' ') && (att_data[Pos]!=(uint8_t)'\r') &&
+       (att_data[Pos]!=(uint8_t)'\n') && (att_data[Pos]!=0U)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 /**
 * @brief  This function is called when there is a change on the gatt attribute as consequence of write request for the Term service
 * @param  void *VoidCharPointer
@@ -1828,6 +2783,126 @@ static void Write_Request_Term(void *VoidCharPointer,uint16_t attr_handle, uint1
   /* By default Answer with the same message received */
   uint32_t SendBackData =1; 
   
+#ifdef BLE_MANAGER_STATS
+  /* "stats" and "stats reset" are handled directly by the BLE Manager */
+  if(Term_IsCommand("stats reset",data_length,att_data)) {
+    BLE_StatsReset();
+    BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Stats reset\r\n");
+    Term_Update(BufferToWrite,BytesToWrite);
+    return;
+  }
+  if(Term_IsCommand("stats",data_length,att_data)) {
+    Term_SendStats();
+    return;
+  }
+#endif /* BLE_MANAGER_STATS */
+  
+#ifdef BLE_MANAGER_PROFILING
+  /* "prof" and "prof reset" are handled directly by the BLE Manager */
+  if(Term_IsCommand("prof reset",data_length,att_data)) {
+    BLE_ProfileReset();
+    BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Profiling reset\r\n");
+    Term_Update(BufferToWrite,BytesToWrite);
+    return;
+  }
+  if(Term_IsCommand("prof",data_length,att_data)) {
+    Term_SendProfiling();
+    return;
+  }
+#endif /* BLE_MANAGER_PROFILING */
+  
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+  /* "mem" and "mem reset" are handled directly by the BLE Manager */
+  if(Term_IsCommand("mem reset",data_length,att_data)) {
+    BLE_MemReset();
+    BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Memory high-water marks reset\r\n");
+    Term_Update(BufferToWrite,BytesToWrite);
+    return;
+  }
+  if(Term_IsCommand("mem",data_length,att_data)) {
+    Term_SendMemWatermark();
+    return;
+  }
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+  
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  /* "adv" and "adv reset" are handled directly by the BLE Manager */
+  if(Term_IsCommand("adv reset",data_length,att_data)) {
+    BLE_AdvertisingResetStats();
+    BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Advertising metrics reset\r\n");
+    Term_Update(BufferToWrite,BytesToWrite);
+    return;
+  }
+  if(Term_IsCommand("adv",data_length,att_data)) {
+    Term_SendAdvertisingStats();
+    return;
+  }
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+  
+#ifdef BLE_MANAGER_CONN_TUNER
+  /* "conn" is handled directly by the BLE Manager */
+  if(Term_IsCommand("conn",data_length,att_data)) {
+    Term_SendConnTuner();
+    return;
+  }
+#endif /* BLE_MANAGER_CONN_TUNER */
+  
+#ifdef BLE_MANAGER_RADIO_SYNC
+  /* "radio" is handled directly by the BLE Manager */
+  if(Term_IsCommand("radio",data_length,att_data)) {
+    Term_SendRadioSync();
+    return;
+  }
+#endif /* BLE_MANAGER_RADIO_SYNC */
+  
+#ifdef BLE_MANAGER_TX_CREDITS
+  /* "credits" is handled directly by the BLE Manager */
+  if(Term_IsCommand("credits",data_length,att_data)) {
+    Term_SendTxCredits();
+    return;
+  }
+#endif /* BLE_MANAGER_TX_CREDITS */
+  
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+  /* "jobs" is handled directly by the BLE Manager */
+  if(Term_IsCommand("jobs",data_length,att_data)) {
+    Term_SendDeferred();
+    return;
+  }
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+  
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  /* "recovery" is handled directly by the BLE Manager */
+  if(Term_IsCommand("recovery",data_length,att_data)) {
+    Term_SendRecovery();
+    return;
+  }
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+  
+#ifdef BLE_MANAGER_RTOS
+  /* "rtos" is handled directly by the BLE Manager */
+  if(Term_IsCommand("rtos",data_length,att_data)) {
+    Term_SendRtos();
+    return;
+  }
+#endif /* BLE_MANAGER_RTOS */
+  
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+  /* "samples" is handled directly by the BLE Manager */
+  if(Term_IsCommand("samples",data_length,att_data)) {
+    Term_SendSamples();
+    return;
+  }
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+  
+#ifdef BLE_MANAGER_FAST_BOOT
+  /* "boot" is handled directly by the BLE Manager */
+  if(Term_IsCommand("boot",data_length,att_data)) {
+    Term_SendBootReport();
+    return;
+  }
+#endif /* BLE_MANAGER_FAST_BOOT */
+  
   /* Received one write from Client on Terminal characteristc */
   if(CustomDebugConsoleParsingCallback!=NULL) {
     SendBackData = CustomDebugConsoleParsingCallback(att_data,data_length);
@@ -1908,6 +2983,92 @@ EndLabel:
   return ret;
 }
 
+/**
+* @brief  Hooks run before one characteristic update: the update could be posted to the BLE task,
+*         queued until the end of the next connection event or refused without any SPI transaction
+* @param  BleCharTypeDef *BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @param  uint8_t charValOffset The offset of the characteristic
+* @param  uint8_t charValueLen The length of the characteristic
+* @param  uint8_t *charValue The pointer to the characteristic
+* @param  tBleStatus *ret status of the update when it is not sent now
+* @retval uint8_t 1 if the update must be sent now, 0 otherwise
+*/
+static uint8_t BLE_UpdateCharPreSend(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue, tBleStatus *ret)
+{
+#ifdef BLE_MANAGER_RTOS
+  if(BLE_RtosIsOtherThread()) {
+    /* Copy-in: sent by the BLE task */
+    *ret = BLE_RtosPost(BleCharPointer,charValOffset,charValueLen,charValue);
+    return 0;
+  }
+#endif /* BLE_MANAGER_RTOS */
+#ifdef BLE_MANAGER_RADIO_SYNC
+  if((BleRadioSync.Flushing==0U) && (connection_handle!=0U) && BLE_RadioSyncIsQueued(BleCharPointer)) {
+    /* Sent at the end of the next connection event */
+    *ret = BLE_RadioSyncQueue(BleCharPointer,charValOffset,charValueLen,charValue);
+#ifdef BLE_MANAGER_STATS
+    if(*ret != (tBleStatus)BLE_STATUS_SUCCESS) {
+      BLE_StatsCharUpdate(BleCharPointer,*ret,charValueLen);
+    }
+#endif /* BLE_MANAGER_STATS */
+    return 0;
+  }
+#endif /* BLE_MANAGER_RADIO_SYNC */
+#ifdef BLE_MANAGER_CONN_TUNER
+  /* Traffic demand (also the updates refused for insufficient resources) */
+  BleConnTuner.WindowBytes += charValueLen;
+#endif /* BLE_MANAGER_CONN_TUNER */
+#ifdef BLE_MANAGER_TX_CREDITS
+  if(BLE_TxCreditsCheck(charValueLen)==0U) {
+    /* It would fail: no SPI transaction */
+    *ret = BLE_STATUS_INSUFFICIENT_RESOURCES;
+#ifdef BLE_MANAGER_STATS
+    BLE_StatsCharUpdate(BleCharPointer,*ret,charValueLen);
+#endif /* BLE_MANAGER_STATS */
+    return 0;
+  }
+#endif /* BLE_MANAGER_TX_CREDITS */
+  return 1;
+}
+
+/**
+* @brief  Send one characteristic update to the controller and account it (profiling, counters, credits)
+* @param  BleCharTypeDef *BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @param  uint8_t charValOffset The offset of the characteristic
+* @param  uint8_t charValueLen The length of the characteristic
+* @param  uint8_t *charValue The pointer to the characteristic
+* @retval tBleStatus Status
+*/
+static tBleStatus BLE_UpdateCharSend(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue)
+{
+  tBleStatus ret;
+#ifdef BLE_MANAGER_STATS
+  uint32_t StartTime = BLE_MANAGER_STATS_LATENCY();
+#endif /* BLE_MANAGER_STATS */
+  
+  BLE_PROFILE_START(ProfileStart);
+  #if (BLUE_CORE != BLUENRG_LP)
+    ret = aci_gatt_update_char_value(BleCharPointer->Service_Handle,BleCharPointer->attr_handle,charValOffset,charValueLen,charValue);
+  #else /* (BLUE_CORE != BLUENRG_LP) */
+    ret = aci_gatt_srv_notify(connection_handle, BleCharPointer->attr_handle+1, GATT_NOTIFICATION, charValueLen, charValue);
+  #endif /* (BLUE_CORE != BLUENRG_LP) */
+  BLE_PROFILE_STOP(BLE_PROFILE_CHAR_UPDATE,ProfileStart);
+#ifdef BLE_MANAGER_STATS
+  BleCharPointer->Stats.LastUpdateLatency = BLE_MANAGER_STATS_LATENCY() - StartTime;
+  BLE_StatsCharUpdate(BleCharPointer,ret,charValueLen);
+#endif /* BLE_MANAGER_STATS */
+#ifdef BLE_MANAGER_TX_CREDITS
+  BLE_TxCreditsUpdate(charValueLen,ret);
+#endif /* BLE_MANAGER_TX_CREDITS */
+  
+  if (ret != (tBleStatus)BLE_STATUS_SUCCESS){
+#if (BLE_DEBUG_LEVEL>2)
+    BLE_MANAGER_PRINTF("Error: Updating Char handle=%x ret=%x\r\n",BleCharPointer->attr_handle,ret);
+#endif
+  }
+  return ret;
+}
+
 #ifdef ACC_BLUENRG_CONGESTION
 static int32_t breath=0;
 
@@ -1926,24 +3087,23 @@ tBleStatus safe_aci_gatt_update_char_value(BleCharTypeDef *BleCharPointer,
                                            uint8_t *charValue)
 {
   tBleStatus ret = BLE_STATUS_INSUFFICIENT_RESOURCES;
+  
+  if(BLE_UpdateCharPreSend(BleCharPointer,charValOffset,charValueLen,charValue,&ret)==0U) {
+    return ret;
+  }
+  
   if (breath==0){
-    #if (BLUE_CORE != BLUENRG_LP)
-      ret = aci_gatt_update_char_value(BleCharPointer->Service_Handle,BleCharPointer->attr_handle,charValOffset,charValueLen,charValue);
-    #else /* (BLUE_CORE != BLUENRG_LP) */
-      ret = aci_gatt_srv_notify(connection_handle, BleCharPointer->attr_handle+1, GATT_NOTIFICATION, charValueLen, charValue);
-    #endif /* (BLUE_CORE != BLUENRG_LP) */
-    
-    if (ret != (tBleStatus)BLE_STATUS_SUCCESS){
+    ret = BLE_UpdateCharSend(BleCharPointer,charValOffset,charValueLen,charValue);
+    if(ret==(tBleStatus)BLE_STATUS_INSUFFICIENT_RESOURCES){
 #if (BLE_DEBUG_LEVEL>2)
-      BLE_MANAGER_PRINTF("Error: Updating Char handle=%x ret=%x\r\n",BleCharPointer->attr_handle,ret);
+      BLE_MANAGER_PRINTF("Char handle=%x insufficient resources\r\n",BleCharPointer->attr_handle);
 #endif
-      if(ret==(tBleStatus)BLE_STATUS_INSUFFICIENT_RESOURCES){
-#if (BLE_DEBUG_LEVEL>2)
-        BLE_MANAGER_PRINTF("Char handle=%x insufficient resources\r\n",BleCharPointer->attr_handle);
-#endif
-        breath = 1;
-      }
+      breath = 1;
     }
+  } else {
+#ifdef BLE_MANAGER_STATS
+    BLE_StatsCharUpdate(BleCharPointer,ret,charValueLen);
+#endif /* BLE_MANAGER_STATS */
   }
   return ret;
 }
@@ -1958,23 +3118,64 @@ tBleStatus safe_aci_gatt_update_char_value(BleCharTypeDef *BleCharPointer,
 static BLE_ExtConfigCommandType BLE_ExtConfig_ExtractCommandType(uint8_t *hs_command_buffer)
 {
   BLE_ExtConfigCommandType ReturnCode = EXT_CONFIG_COM_NOT_VALID;
+  char CommandName[EXT_CONFIG_MAX_COMMAND_NAME_LEN];
   
-  /* Parse the Json for taking the pointer to the CommandName */
-  JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
-  JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
+  /* Scan the Json for taking the CommandName without building the tree */
+  if(ExtConfig_ScanCommandName(hs_command_buffer,CommandName)) {
+    ReturnCode = ExtConfig_CommandTypeFromName(CommandName);
+  }
   
-  if (json_object_dothas_value(JSON_ParseHandler,"command")) {
-    uint8_t SearchCommand=(uint8_t)EXT_CONFIG_COM_READ_COMMAND;
-    //Search the Command
-    while((ReturnCode == EXT_CONFIG_COM_NOT_VALID) && (SearchCommand<((uint8_t)EXT_CONFIG_COMMAND_NUMBER))) {
-      if (strncmp(json_object_dotget_string(JSON_ParseHandler,"command"),StandardExtConfigCommands[SearchCommand].CommandString,strlen(json_object_dotget_string(JSON_ParseHandler,"command"))) == 0) {
-        ReturnCode = StandardExtConfigCommands[SearchCommand].CommandType;
-      }
-      SearchCommand++;
+  return ReturnCode;
+}
+
+/**
+* @brief  Scan one json command for extracting the CommandName, without memory allocation.
+*         The whole command is checked, like json_parse_string would do
+* @param  uint8_t *hs_command_buffer json formatted command
+* @param  char *CommandName buffer of EXT_CONFIG_MAX_COMMAND_NAME_LEN bytes for the CommandName
+* @retval uint8_t 1 if the command is valid
+*/
+static uint8_t ExtConfig_ScanCommandName(uint8_t *hs_command_buffer,char *CommandName)
+{
+  JSON_Reader Reader;
+  JSON_Token_Type Token;
+  uint8_t Valid=0;
+  
+  json_reader_init(&Reader,(char *) hs_command_buffer);
+  if(json_reader_find(&Reader,"command")==JSONTokenString) {
+    if(json_reader_get_string(&Reader,CommandName,EXT_CONFIG_MAX_COMMAND_NAME_LEN)==JSONSuccess) {
+      Valid=1;
     }
   }
   
-  json_value_free(tempJSON);
+  /* Check the remaining part of the command */
+  do {
+    Token = json_reader_next(&Reader);
+  } while((Token!=JSONTokenEnd) && (Token!=JSONTokenError));
+  
+  if(Token==JSONTokenError) {
+    Valid=0;
+  }
+  return Valid;
+}
+
+/**
+* @brief Search one Standard Command by name
+* @param  const char *CommandName command name
+* @retval BLE_ExtConfigCommandType
+*/
+static BLE_ExtConfigCommandType ExtConfig_CommandTypeFromName(const char *CommandName)
+{
+  BLE_ExtConfigCommandType ReturnCode = EXT_CONFIG_COM_NOT_VALID;
+  uint8_t SearchCommand=(uint8_t)EXT_CONFIG_COM_READ_COMMAND;
+  
+  //Search the Command
+  while((ReturnCode == EXT_CONFIG_COM_NOT_VALID) && (SearchCommand<((uint8_t)EXT_CONFIG_COMMAND_NUMBER))) {
+    if (strncmp(CommandName,StandardExtConfigCommands[SearchCommand].CommandString,strlen(CommandName)) == 0) {
+      ReturnCode = StandardExtConfigCommands[SearchCommand].CommandType;
+    }
+    SearchCommand++;
+  }
   return ReturnCode;
 }
 
@@ -1986,19 +3187,19 @@ static BLE_ExtConfigCommandType BLE_ExtConfig_ExtractCommandType(uint8_t *hs_com
 BLE_CustomCommadResult_t *AskGenericCustomCommands(uint8_t *hs_command_buffer)
 {
   BLE_CustomCommadResult_t *CommandResult=NULL;
+  char CommandName[EXT_CONFIG_MAX_COMMAND_NAME_LEN];
   
-  /* Parse the Json for taking the pointer to the CommandName */
-  JSON_Value *tempJSON = json_parse_string( (char *) hs_command_buffer);
-  JSON_Object *JSON_ParseHandler = json_value_get_object(tempJSON);
-  
-  if (json_object_dothas_value(JSON_ParseHandler,"command")) {
-    if (strncmp(json_object_dotget_string(JSON_ParseHandler,"command"),StandardExtConfigCommands[EXT_CONFIG_COM_READ_CUSTOM_COMMAND].CommandString,strlen(json_object_dotget_string(JSON_ParseHandler,"command"))) == 0) {
+  /* Scan the Json for taking the CommandName */
+  if(ExtConfig_ScanCommandName(hs_command_buffer,CommandName)) {
+    if (strncmp(CommandName,StandardExtConfigCommands[EXT_CONFIG_COM_READ_CUSTOM_COMMAND].CommandString,strlen(CommandName)) == 0) {
      /* The User has asked a List of Custom Command */
       CommandResult = (BLE_CustomCommadResult_t *) BLE_MallocFunction(sizeof(BLE_CustomCommadResult_t));
       if(CommandResult == NULL) {
         BLE_MANAGER_PRINTF("Error: Mem alloc error: %d@%s\r\n", __LINE__, __FILE__);
       } else {
         CommandResult->CommandType= BLE_CUSTOM_COMMAND_VOID;
+        CommandResult->IntValue= 0;
+        CommandResult->StringValue= NULL;
         
         CommandResult->CommandName = BLE_MallocFunction(strlen(BLE_MANAGER_READ_CUSTOM_COMMAND) + 1U);
         if((CommandResult->CommandName)==NULL) {
@@ -2011,7 +3212,6 @@ BLE_CustomCommadResult_t *AskGenericCustomCommands(uint8_t *hs_command_buffer)
       }
     }
   }
-  json_value_free(tempJSON);
   return CommandResult;
 }
 
@@ -2039,473 +3239,4003 @@ static tBleStatus BLE_UpdateExtConf(uint8_t *data,uint8_t length)
   
   return ret;
 }
-#endif /* BLE_MANAGER_NO_PARSON */
-
-/* Exported functions -----------------------------------------------------------*/
 
-#ifndef BLE_MANAGER_NO_PARSON
 /**
-* @brief  Update Extended Configuration characteristic value
-* @param  uint8_t *data string to write
-* @param  uint32_t lenght lengt of string to write
+* @brief  Send a buffer already encapsulated with BLE_COMM_TP on Extended Configuration characteristic
+* @param  uint8_t *data BLE_COMM_TP packets to write
+* @param  uint32_t tot_len total length of the packets
 * @retval tBleStatus      Status
 */
-tBleStatus BLE_ExtConfiguration_Update(uint8_t *data,uint32_t length)
+static tBleStatus BLE_ExtConfig_SendTPBuffer(uint8_t *data,uint32_t tot_len)
 {
-  uint32_t tot_len,j;
-  uint8_t *JSON_string_command_wTP;
-  uint32_t length_wTP;
+  uint32_t j;
   uint32_t len;
   
-  if ((length % 19U) == 0U) {
-    length_wTP = (length/19U)+length;
-  } else {
-    length_wTP = (length/19U)+1U+length;
+  /* Data are sent as notifications*/
+  j = 0;
+  while (j < tot_len) {
+    len = MIN(20U, (tot_len - j));
+    if(BLE_UpdateExtConf(data+j,(uint8_t)len)!=(tBleStatus)BLE_STATUS_SUCCESS) {
+      return BLE_STATUS_ERROR;
+    }
+    BLE_MANAGER_DELAY(20);
+    j += len;
   }
-  
-  JSON_string_command_wTP = BLE_MallocFunction(sizeof(uint8_t) * length_wTP);
-  
-  if(JSON_string_command_wTP==NULL) {
-    BLE_MANAGER_PRINTF("Error: Mem calloc error [%lu]: %d@%s\r\n",length,__LINE__,__FILE__);
-    return BLE_STATUS_ERROR;
-  } else {
-    tot_len = BLE_Command_TP_Encapsulate(JSON_string_command_wTP, data, length);
+  return BLE_STATUS_SUCCESS;
+}
+
+/**
+* @brief  Serialize one Extended Configuration answer with the encoding of the current connection
+* @param  const JSON_Value *tempJSON answer to serialize
+* @param  uint32_t *length length of the serialized answer
+* @retval uint8_t* serialized answer (to release with BLE_FreeFunction) or NULL
+*/
+static uint8_t *ExtConfig_SerializeAnswer(const JSON_Value *tempJSON,uint32_t *length)
+{
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+  if(ExtConfigCborEncoding) {
+    BLE_CborWriter_t Cbor;
     
-    /* Data are sent as notifications*/
-    j = 0;
-    while (j < tot_len) {
-      len = MIN(20U, (tot_len - j));
-      if(BLE_UpdateExtConf(JSON_string_command_wTP+j,(uint8_t)len)!=(tBleStatus)BLE_STATUS_SUCCESS) {
-        return BLE_STATUS_ERROR;
+    Cbor_InitWriter(&Cbor);
+    Cbor_PutJsonValue(&Cbor,tempJSON);
+    if(Cbor.Error) {
+      if(Cbor.Buffer!=NULL) {
+        BLE_FreeFunction(Cbor.Buffer);
       }
-      BLE_MANAGER_DELAY(20);
-      j += len;
+      return NULL;
     }
-    BLE_FreeFunction(JSON_string_command_wTP);
-    return BLE_STATUS_SUCCESS;
+    *length = Cbor.Length;
+    return Cbor.Buffer;
+  }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+  
+  {
+    /* convert to a json string in a single pass (the answer length includes the null character) */
+    JSON_Growable_Buffer JsonBuffer = { NULL, 0, 0 };
+    
+    if(json_serialize_to_growable_buffer(tempJSON,&JsonBuffer)!=JSONSuccess) {
+      json_free_serialized_string(JsonBuffer.data);
+      return NULL;
+    }
+    *length = JsonBuffer.length + 1U;
+    return (uint8_t *)JsonBuffer.data;
   }
 }
-#endif /* BLE_MANAGER_NO_PARSON */
 
+#ifdef BLE_MANAGER_STATS
 /**
-* @brief Each time BLE FW stack raises the error code @ref ble_status_insufficient_resources (0x64),
-the @ref aci_gatt_tx_pool_available_event event is generated as soon as the available buffer size 
-is greater than maximum ATT MTU (on stack versions below v2.1 this event is generated when at least 2 packets
-with MTU of 23 bytes are available).
-* @param Connection_Handle Connection handle related to the request
-* @param Available_Buffers Not used.
+* @brief  Send the runtime counters as answer to the ReadStats command
+* @param  None
 * @retval None
 */
-void aci_gatt_tx_pool_available_event(uint16_t Connection_Handle,
-                                      uint16_t Available_Buffers)
+static void ExtConfig_SendStats(void)
 {
-#if (BLE_DEBUG_LEVEL>1)
-  BLE_MANAGER_PRINTF("aci_gatt_tx_pool_available_event\r\n");
-#endif
+  JSON_Value *tempJSON = json_value_init_object();
+  JSON_Object *tempJSON_Obj = json_value_get_object(tempJSON);
+  JSON_Array *JSON_CharsArray;
+  uint8_t BleChar;
   
-#ifdef ACC_BLUENRG_CONGESTION
-  breath=0;
-#endif /* ACC_BLUENRG_CONGESTION */
+  json_object_dotset_number(tempJSON_Obj, "Stats.HciEvents", (double)BLE_HciStats.HciEvents);
+  json_object_dotset_number(tempJSON_Obj, "Stats.HciRxPoolExhausted", (double)BLE_HciStats.HciRxPoolExhausted);
+  json_object_dotset_number(tempJSON_Obj, "Stats.TxPoolAvailable", (double)BLE_HciStats.TxPoolAvailableEvents);
+  json_object_dotset_number(tempJSON_Obj, "Stats.EventsLost", (double)BLE_HciStats.EventsLost);
   
-  if(CustomAciGattTxPoolAvailableEvent != NULL) {
-    CustomAciGattTxPoolAvailableEvent();
+  json_object_dotset_value(tempJSON_Obj, "Stats.Chars", json_value_init_array());
+  JSON_CharsArray = json_object_dotget_array(tempJSON_Obj, "Stats.Chars");
+  for(BleChar=0; BleChar<UsedBleChars; BleChar++) {
+    BLE_CharStats_t *Stats = &BleCharsArray[BleChar]->Stats;
+    
+    if(Stats->UpdatesAttempted!=0U) {
+      JSON_Value *tempJSON1 = json_value_init_object();
+      JSON_Object *tempJSON1_Obj = json_value_get_object(tempJSON1);
+      
+      json_object_set_number(tempJSON1_Obj, "Handle", (double)BleCharsArray[BleChar]->attr_handle);
+      json_object_set_number(tempJSON1_Obj, "Attempted", (double)Stats->UpdatesAttempted);
+      json_object_set_number(tempJSON1_Obj, "Succeeded", (double)Stats->UpdatesSucceeded);
+      json_object_set_number(tempJSON1_Obj, "InsufficientResources", (double)Stats->InsufficientResources);
+      json_object_set_number(tempJSON1_Obj, "BytesSent", (double)Stats->BytesSent);
+      json_object_set_number(tempJSON1_Obj, "PendingHighWater", (double)Stats->PendingHighWater);
+      json_object_set_number(tempJSON1_Obj, "LastLatency", (double)Stats->LastUpdateLatency);
+      json_object_set_string(tempJSON1_Obj, "LatencyUnit", BLE_MANAGER_STATS_LATENCY_UNIT);
+      json_array_append_value(JSON_CharsArray, tempJSON1);
+    }
   }
-}
-
-/* @brief  Update the value of a characteristic
-* @param  BleCharPointer pointer to the BleCharTypeDef for the current ble char
-* @param  charValOffset The offset of the characteristic
-* @param  charValueLen The length of the characteristic
-* @param  charValue The pointer to the characteristic
-* @retval tBleStatus Status
-*/
-tBleStatus aci_gatt_update_char_value_wrapper(BleCharTypeDef *BleCharPointer,
-                                              uint8_t charValOffset,
-                                              uint8_t charValueLen,
-                                              uint8_t *charValue)
-{
-  tBleStatus ret = BLE_STATUS_INSUFFICIENT_RESOURCES;
-  #if (BLUE_CORE != BLUENRG_LP)
-    ret = aci_gatt_update_char_value(BleCharPointer->Service_Handle,BleCharPointer->attr_handle,charValOffset,charValueLen,charValue);
-  #else /* (BLUE_CORE != BLUENRG_LP) */
-    ret = aci_gatt_srv_notify(connection_handle, BleCharPointer->attr_handle+1, GATT_NOTIFICATION, charValueLen, charValue);
-  #endif /* (BLUE_CORE != BLUENRG_LP) */
-        
-  if (ret != (tBleStatus)BLE_STATUS_SUCCESS){
-#if (BLE_DEBUG_LEVEL>2)
-    BLE_MANAGER_PRINTF("Error: Updating Char handle=%x ret=%x\r\n",BleCharPointer->attr_handle,ret);
-#endif
+  
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  {
+    BLE_AdvStats_t AdvStats;
+    
+    BLE_AdvertisingGetStats(&AdvStats);
+    json_object_dotset_string(tempJSON_Obj, "Stats.Adv.Step", BleAdvStepNames[AdvStats.Step]);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.Connections", (double)AdvStats.Connections);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.LastTimeToConnect", (double)AdvStats.LastTimeToConnect);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.AvgTimeToConnect", (double)AdvStats.AvgTimeToConnect);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.MaxTimeToConnect", (double)AdvStats.MaxTimeToConnect);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.AdvertisingTime", (double)AdvStats.AdvertisingTime);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.ObservedTime", (double)AdvStats.ObservedTime);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Adv.AdvertisingEvents", (double)AdvStats.AdvertisingEvents);
   }
-  return ret;
-}
-
-/**
-* @brief  Update Stderr characteristic value
-* @param  uint8_t *data string to write
-* @param  uint8_t lenght lengt of string to write
-* @retval tBleStatus      Status
-*/
-tBleStatus Stderr_Update(uint8_t *data,uint8_t length)
-{
-  uint8_t Offset;
-  uint8_t DataToSend;
-  /* Split the code in Chunks */
-  /* First Chunk */
-  DataToSend = (length>MaxBleCharStdErrLen) ?  MaxBleCharStdErrLen : length;
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
   
-  /* keep a copy */
-  memcpy(LastStderrBuffer,data,DataToSend);
-  LastStderrLen = DataToSend;
+#ifdef BLE_MANAGER_CONN_TUNER
+  {
+    BLE_ConnTunerStats_t ConnStats;
+    
+    BLE_ConnTunerGetStats(&ConnStats);
+    json_object_dotset_string(tempJSON_Obj, "Stats.Conn.Profile", BleConnProfileNames[ConnStats.Profile]);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Interval", (double)ConnStats.ConnInterval);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Latency", (double)ConnStats.ConnLatency);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.SupervisionTimeout", (double)ConnStats.SupervisionTimeout);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Rate", (double)ConnStats.Rate);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Requests", (double)ConnStats.Requests);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Accepted", (double)ConnStats.Accepted);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Rejected", (double)ConnStats.Rejected);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Conn.Timeouts", (double)ConnStats.Timeouts);
+  }
+#endif /* BLE_MANAGER_CONN_TUNER */
   
-  if(UpdateTermStdErr(data,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
-    return BLE_STATUS_ERROR;
+#ifdef BLE_MANAGER_RADIO_SYNC
+  {
+    BLE_RadioSyncStats_t RadioStats;
+    
+    BLE_RadioSyncGetStats(&RadioStats);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.ConnectionEvents", (double)RadioStats.ConnectionEvents);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.Queued", (double)RadioStats.Queued);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.QueueFull", (double)RadioStats.QueueFull);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.Sent", (double)RadioStats.Sent);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.Deferred", (double)RadioStats.Deferred);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.MaxBurst", (double)RadioStats.MaxBurst);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Radio.HighWater", (double)RadioStats.HighWater);
   }
+#endif /* BLE_MANAGER_RADIO_SYNC */
   
-  /* Following Chunks if necessary */
-  Offset = MaxBleCharStdErrLen;
-  for(; Offset<length; Offset +=MaxBleCharStdErrLen){
-    /* Add a Delay respect previous chunk */
-    BLE_MANAGER_DELAY(20);
+#ifdef BLE_MANAGER_TX_CREDITS
+  {
+    BLE_TxCreditsStats_t TxStats;
     
-    DataToSend = (length-Offset);
-    DataToSend = (DataToSend>MaxBleCharStdErrLen) ?  MaxBleCharStdErrLen : DataToSend;
+    BLE_TxCreditsGetStats(&TxStats);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.AclLength", (double)TxStats.AclLength);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.Total", (double)TxStats.Total);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.Available", (double)TxStats.Available);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.MinAvailable", (double)TxStats.MinAvailable);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.Consumed", (double)TxStats.Consumed);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.Completed", (double)TxStats.Completed);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.Skipped", (double)TxStats.Skipped);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Credits.Resyncs", (double)TxStats.Resyncs);
+  }
+#endif /* BLE_MANAGER_TX_CREDITS */
+  
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+  {
+    BLE_DeferredStats_t JobsStats;
     
-    /* keep a copy */
-    memcpy(LastStderrBuffer,data+Offset,DataToSend);
-    LastStderrLen = DataToSend;
+    BLE_DeferredGetStats(&JobsStats);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Jobs.Posted", (double)JobsStats.Posted);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Jobs.Executed", (double)JobsStats.Executed);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Jobs.Inline", (double)JobsStats.Inline);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Jobs.HighWater", (double)JobsStats.HighWater);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Jobs.MaxWait", (double)JobsStats.MaxWait);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Jobs.MaxRun", (double)JobsStats.MaxRun);
+  }
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+  
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  {
+    BLE_RecoveryStats_t RecoveryStats;
     
-    if(UpdateTermStdErr(data+Offset,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
-      return BLE_STATUS_ERROR;
-    }
+    BLE_StackRecoveryGetStats(&RecoveryStats);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.HardwareErrors", (double)RecoveryStats.HardwareErrors);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.ControllerResets", (double)RecoveryStats.ControllerResets);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.CrashInfos", (double)RecoveryStats.CrashInfos);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.Recoveries", (double)RecoveryStats.Recoveries);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.Failures", (double)RecoveryStats.Failures);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.LastDuration", (double)RecoveryStats.LastDuration);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Recovery.HandlesChanged", (double)RecoveryStats.HandlesChanged);
   }
-  return BLE_STATUS_SUCCESS;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+  
+#ifdef BLE_MANAGER_RTOS
+  {
+    BLE_RtosStats_t RtosStats;
+    
+    BLE_RtosGetStats(&RtosStats);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Rtos.Posted", (double)RtosStats.Posted);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Rtos.Dropped", (double)RtosStats.Dropped);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Rtos.SendErrors", (double)RtosStats.SendErrors);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Rtos.MaxUsed", (double)RtosStats.MaxUsed);
+  }
+#endif /* BLE_MANAGER_RTOS */
+  
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+  {
+    BLE_SampleStats_t SampleStats;
+    
+    BLE_SampleGetStats(&SampleStats);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Samples.Pushed", (double)SampleStats.Pushed);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Samples.Dropped", (double)SampleStats.Dropped);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Samples.Retries", (double)SampleStats.Retries);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Samples.Batches", (double)SampleStats.Batches);
+    json_object_dotset_number(tempJSON_Obj, "Stats.Samples.MaxUsed", (double)SampleStats.MaxUsed);
+  }
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+  
+  /* serialize it and write it */
+  ExtConfig_SendAnswer(tempJSON);
+  json_value_free(tempJSON);
 }
+#endif /* BLE_MANAGER_STATS */
 
 /**
-* @brief  
-* @param  uint8_t* buffer
-* @param  uint8_t len
-* @retval tBleStatus   Status
+* @brief  Serialize and send one Extended Configuration answer
+* @param  const JSON_Value *tempJSON answer to send
+* @retval tBleStatus      Status
 */
-tBleStatus BLE_StdOutSendBuffer(uint8_t* buffer, uint8_t len)
+static tBleStatus ExtConfig_SendAnswer(const JSON_Value *tempJSON)
 {
-  tBleStatus ret;
-  
-  #if (BLUE_CORE != BLUENRG_LP)
-    ret = aci_gatt_update_char_value(BleCharStdOut.Service_Handle, BleCharStdOut.attr_handle, 0, len, buffer);
-  #else /* (BLUE_CORE != BLUENRG_LP) */
-    ret = aci_gatt_srv_notify(connection_handle, BleCharStdOut.attr_handle+1, GATT_NOTIFICATION, len, buffer);
-  #endif /* (BLUE_CORE != BLUENRG_LP) */
+  tBleStatus ret = BLE_STATUS_ERROR;
+  uint32_t length;
+  uint8_t *data = ExtConfig_SerializeAnswer(tempJSON,&length);
   
+  if(data!=NULL) {
+    ret = BLE_ExtConfiguration_Update(data,length);
+    BLE_FreeFunction(data);
+  }
   return ret;
 }
 
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
 /**
-* @brief  Update Terminal characteristic value
-* @param  uint8_t *data string to write
-* @param  uint8_t lenght lengt of string to write
-* @retval tBleStatus      Status
+* @brief  Initialize one CBOR writer (the buffer is allocated on first write)
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @retval None
 */
-tBleStatus Term_Update(uint8_t *data,uint8_t length)
+static void Cbor_InitWriter(BLE_CborWriter_t *Cbor)
 {
-  uint8_t   Offset;
-  uint8_t   DataToSend;
-  
-  /* Split the code in Chunks */
-  /* First Chunk */
-  DataToSend = (length>MaxBleCharStdOutLen) ?  MaxBleCharStdOutLen : length;
-  
-  /* keep a copy */
-  memcpy(LastTermBuffer,data,DataToSend);
-  LastTermLen = DataToSend;
-  
-  if(UpdateTermStdOut(data,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
-    return BLE_STATUS_ERROR;
+  Cbor->Buffer = NULL;
+  Cbor->Size   = 0;
+  Cbor->Length = 0;
+  Cbor->Error  = 0;
+}
+
+/**
+* @brief  Make room for new bytes on CBOR writer buffer
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  uint32_t Size number of bytes to add
+* @retval uint8_t 1 if there is enough space
+*/
+static uint8_t Cbor_Reserve(BLE_CborWriter_t *Cbor,uint32_t Size)
+{
+  if(Cbor->Error) {
+    return 0;
   }
   
-  /* Following Chunks if necessary */
-  Offset = MaxBleCharStdOutLen;
-  for(; Offset<length; Offset +=MaxBleCharStdOutLen){
-    
-    /* Add a Delay respect previous chunk */
-    BLE_MANAGER_DELAY(20);
+  if((Cbor->Length+Size) > Cbor->Size) {
+    uint32_t NewSize = (Cbor->Size==0U) ? BLE_CBOR_WRITER_INITIAL_SIZE : Cbor->Size;
+    uint8_t *NewBuffer;
     
-    DataToSend = (length-Offset);
-    DataToSend = (DataToSend>MaxBleCharStdOutLen) ?  MaxBleCharStdOutLen : DataToSend;
+    while(NewSize < (Cbor->Length+Size)) {
+      NewSize <<= 1;
+    }
     
-    /* keep a copy */
-    memcpy(LastTermBuffer,data+Offset,DataToSend);
-    LastTermLen = DataToSend;
+    NewBuffer = BLE_MallocFunction(NewSize);
+    if(NewBuffer==NULL) {
+      BLE_MANAGER_PRINTF("Error: Mem alloc error [%lu]: %d@%s\r\n",NewSize,__LINE__,__FILE__);
+      Cbor->Error = 1;
+      return 0;
+    }
     
-    if(UpdateTermStdOut(data+Offset,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
-      return BLE_STATUS_ERROR;
+    if(Cbor->Buffer!=NULL) {
+      BLE_MemCpy(NewBuffer,Cbor->Buffer,Cbor->Length);
+      BLE_FreeFunction(Cbor->Buffer);
     }
+    Cbor->Buffer = NewBuffer;
+    Cbor->Size   = NewSize;
   }
-  return BLE_STATUS_SUCCESS;
+  return 1;
 }
 
-/* @brief  Send a BLE notification for answering to a configuration command for Accelerometer events
-* @param  uint32_t Feature Feature type
-* @param  uint8_t Command Replay to this Command
-* @param  uint8_t data result to send back
-* @retval tBleStatus Status
+/**
+* @brief  Add one byte to CBOR writer
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  uint8_t Value byte to add
+* @retval None
 */
-tBleStatus Config_Update(uint32_t Feature,uint8_t Command,uint8_t data)
+static void Cbor_PutByte(BLE_CborWriter_t *Cbor,uint8_t Value)
 {
-  uint8_t buff[2+4+1+1];
-  
-  STORE_LE_16(buff  ,(HAL_GetTick()>>3));
-  STORE_BE_32(buff+2,Feature);
-  buff[6] = Command;
-  buff[7] = data;
-  
-  if (ACI_GATT_UPDATE_CHAR_VALUE(&BleCharConfig, 0, 8 , buff) != (tBleStatus)BLE_STATUS_SUCCESS) {
-    BLE_MANAGER_PRINTF("Error: Updating Configuration Char\r\n");
-    return BLE_STATUS_ERROR;
-  } 
-  return BLE_STATUS_SUCCESS;
-  
+  if(Cbor_Reserve(Cbor,1U)) {
+    Cbor->Buffer[Cbor->Length] = Value;
+    Cbor->Length++;
+  }
 }
 
-/* @brief  Send a BLE notification for answering to a configuration command for Accelerometer events
-* @param  uint32_t Feature Feature type
-* @param  uint8_t Command Replay to this Command
-* @param  uint32_t data result to send back
-* @retval tBleStatus Status
+/**
+* @brief  Add one CBOR item head (major type and argument)
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  uint8_t Major CBOR major type
+* @param  uint32_t Value argument (value, length or number of items)
+* @retval None
 */
-tBleStatus Config_Update_32(uint32_t Feature,uint8_t Command,uint32_t data)
+static void Cbor_PutHead(BLE_CborWriter_t *Cbor,uint8_t Major,uint32_t Value)
 {
-  uint8_t buff[2+4+1+4];
-  
-  STORE_LE_16(buff  ,(HAL_GetTick()>>3));
-  STORE_BE_32(buff+2,Feature);
-  buff[6] = Command;
-  buff[7]  = (uint8_t)((data       ) & 0xFFU);
-  buff[8]  = (uint8_t)((data >>  8U) & 0xFFU);
-  buff[9]  = (uint8_t)((data >> 16U) & 0xFFU);
-  buff[10] = (uint8_t)((data >> 24U) & 0xFFU);
-  
-  if (ACI_GATT_UPDATE_CHAR_VALUE(&BleCharConfig, 0, 11 , buff) != (tBleStatus)BLE_STATUS_SUCCESS) {
-    BLE_MANAGER_PRINTF("Error: Updating Configuration Char\r\n");
-    return BLE_STATUS_ERROR;
-  } 
-  return BLE_STATUS_SUCCESS;
+  uint8_t MajorBits = (uint8_t)(Major<<5);
+  
+  if(Value < 24U) {
+    Cbor_PutByte(Cbor,MajorBits | (uint8_t)Value);
+  } else if(Value <= 0xFFU) {
+    if(Cbor_Reserve(Cbor,2U)) {
+      Cbor->Buffer[Cbor->Length++] = MajorBits | 24U;
+      Cbor->Buffer[Cbor->Length++] = (uint8_t)Value;
+    }
+  } else if(Value <= 0xFFFFU) {
+    if(Cbor_Reserve(Cbor,3U)) {
+      Cbor->Buffer[Cbor->Length++] = MajorBits | 25U;
+      Cbor->Buffer[Cbor->Length++] = (uint8_t)(Value>>8);
+      Cbor->Buffer[Cbor->Length++] = (uint8_t)Value;
+    }
+  } else {
+    if(Cbor_Reserve(Cbor,5U)) {
+      Cbor->Buffer[Cbor->Length++] = MajorBits | 26U;
+      STORE_BE_32(Cbor->Buffer+Cbor->Length,Value);
+      Cbor->Length += 4U;
+    }
+  }
 }
 
 /**
-* @brief  Puts the device in connectable mode.
-* @param  None
+* @brief  Add one text string with known length
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  const char *String string to add
+* @param  uint32_t Len length of the string
 * @retval None
 */
-#if (BLUE_CORE != BLUENRG_LP)
-void updateAdvData()
+static void Cbor_PutTextLen(BLE_CborWriter_t *Cbor,const char *String,uint32_t Len)
 {
-  /* Filling Manufacter Advertise data */
-  manuf_data[0 ] = 8U;
-  manuf_data[1 ] = 0x09U;
-  manuf_data[2 ] = (uint8_t)BLE_StackValue.BoardName[0];/* Complete Name */
-  manuf_data[3 ] = (uint8_t)BLE_StackValue.BoardName[1];
-  manuf_data[4 ] = (uint8_t)BLE_StackValue.BoardName[2];
-  manuf_data[5 ] = (uint8_t)BLE_StackValue.BoardName[3];
-  manuf_data[6 ] = (uint8_t)BLE_StackValue.BoardName[4];
-  manuf_data[7 ] = (uint8_t)BLE_StackValue.BoardName[5];
-  manuf_data[8 ] = (uint8_t)BLE_StackValue.BoardName[6];           
-  manuf_data[9 ] = 15U;
-  manuf_data[10] = 0xFFU;
-  manuf_data[11] = 0x30U;/* STM Manufacter AD */
-  manuf_data[12] = 0x00U;
-#ifdef BLE_MANAGER_SDKV2
-  manuf_data[13] = 0x02U;
-#else /* BLE_MANAGER_SDKV2 */
-  manuf_data[13] = 0x01U;
-#endif /* BLE_MANAGER_SDKV2 */
-  manuf_data[14] = BLE_MANAGER_USED_PLATFORM; /* BoardType */
-  manuf_data[15] = 0x00U;
-  manuf_data[16] = 0x00U;
-  manuf_data[17] = 0x00U;
-  manuf_data[18] = 0x00U;
-  manuf_data[19] = BLE_StackValue.BleMacAddress[5]; /* BLE MAC start */
-  manuf_data[20] = BLE_StackValue.BleMacAddress[4];
-  manuf_data[21] = BLE_StackValue.BleMacAddress[3];
-  manuf_data[22] = BLE_StackValue.BleMacAddress[2];
-  manuf_data[23] = BLE_StackValue.BleMacAddress[1];
-  manuf_data[24] = BLE_StackValue.BleMacAddress[0]; /* BLE MAC stop */
-  
-  /* Set the Custom BLE Advertise Data */
-  BLE_SetCustomAdvertiseData(manuf_data);
-  
-  if(CustomSetConnectable!=NULL){
-    CustomSetConnectable(manuf_data);
+  Cbor_PutHead(Cbor,3U,Len);
+  if(Cbor_Reserve(Cbor,Len)) {
+    BLE_MemCpy(Cbor->Buffer+Cbor->Length,String,Len);
+    Cbor->Length += Len;
   }
-  
-  /* Send Advertising data */
-  tBleStatus RetStatus = aci_gap_update_adv_data(BLE_MANAGER_ADVERTISE_DATA_LENGHT, manuf_data);
-  if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
-    BLE_MANAGER_PRINTF("Error: aci_gap_update_adv_data [%x]\r\n",RetStatus);
+}
+
+/**
+* @brief  Add one null terminated text string
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  const char *String string to add
+* @retval None
+*/
+static void Cbor_PutText(BLE_CborWriter_t *Cbor,const char *String)
+{
+  Cbor_PutTextLen(Cbor,String,strlen(String));
+}
+
+/**
+* @brief  Add one signed integer
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  int32_t Value integer to add
+* @retval None
+*/
+static void Cbor_PutInt(BLE_CborWriter_t *Cbor,int32_t Value)
+{
+  if(Value >= 0) {
+    Cbor_PutHead(Cbor,0U,(uint32_t)Value);
   } else {
-    BLE_MANAGER_PRINTF("aci_gap_update_adv_data OK\r\n");
-  } 
+    Cbor_PutHead(Cbor,1U,(uint32_t)(-(Value+1)));
+  }
 }
 
-void setConnectable(void)
+/**
+* @brief  Add one single precision float
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  float Value float to add
+* @retval None
+*/
+static void Cbor_PutFloat(BLE_CborWriter_t *Cbor,float Value)
 {
-#if (BLUE_CORE == BLUENRG_MS)
-  char local_name[8] = {AD_TYPE_COMPLETE_LOCAL_NAME,
-#else /* (BLUE_CORE == BLUENRG_MS) */
-  uint8_t local_name[8] = {AD_TYPE_COMPLETE_LOCAL_NAME,
-#endif /* (BLUE_CORE == BLUENRG_MS) */
-  BLE_StackValue.BoardName[0],
-  BLE_StackValue.BoardName[1],
-  BLE_StackValue.BoardName[2],
-  BLE_StackValue.BoardName[3],
-  BLE_StackValue.BoardName[4],
-  BLE_StackValue.BoardName[5],
-  BLE_StackValue.BoardName[6]};
-  tBleStatus RetStatus= BLE_STATUS_SUCCESS; 
+  uint32_t Bits;
   
-  /* disable scan response */
-  RetStatus = hci_le_set_scan_response_data(0U,NULL);
-  if(RetStatus !=(tBleStatus)BLE_STATUS_SUCCESS) {
-    BLE_MANAGER_PRINTF("Error: hci_le_set_scan_response_data [%x]\r\n",RetStatus);
-    goto EndLabel;
+  BLE_MemCpy(&Bits,&Value,4);
+  if(Cbor_Reserve(Cbor,5U)) {
+    Cbor->Buffer[Cbor->Length++] = 0xFAU;
+    STORE_BE_32(Cbor->Buffer+Cbor->Length,Bits);
+    Cbor->Length += 4U;
   }
-  
-  /* Set the board discoverable */
-  if(BLE_StackValue.AdvertisingFilter == ((uint8_t)NO_WHITE_LIST_USE)) {
-    RetStatus = aci_gap_set_discoverable(ADV_IND, BLE_StackValue.AdvIntervalMin, BLE_StackValue.AdvIntervalMax,
-                                         BLE_StackValue.OwnAddressType,
-                                         BLE_StackValue.AdvertisingFilter,
-                                         (uint8_t)(sizeof(local_name)), local_name, 0, NULL, 0, 0);
-    if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
-      BLE_MANAGER_PRINTF("Error: aci_gap_set_discoverable [%x] Filter=%x\r\n",RetStatus,BLE_StackValue.AdvertisingFilter);
-      goto EndLabel;
-    } else {
-#if (BLE_DEBUG_LEVEL>1)
-      BLE_MANAGER_PRINTF("aci_gap_set_discoverable OK Filter=%x\r\n",BLE_StackValue.AdvertisingFilter);
-#endif
-    }
+}
+
+/**
+* @brief  Add one number using the shortest encoding without losing precision
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  double Value number to add
+* @retval None
+*/
+static void Cbor_PutNumber(BLE_CborWriter_t *Cbor,double Value)
+{
+  if((Value == floor(Value)) && (Value >= -2147483648.0) && (Value <= 2147483647.0)) {
+    Cbor_PutInt(Cbor,(int32_t)Value);
+  } else if(((double)((float)Value)) == Value) {
+    Cbor_PutFloat(Cbor,(float)Value);
   } else {
-    /* Advertising filter is enabled: enter in undirected connectable mode in order to use the advertising filter on bonded device */
-#if (BLUE_CORE == BLUENRG_MS)
-	RetStatus = aci_gap_set_undirected_connectable(BLE_StackValue.OwnAddressType, BLE_StackValue.AdvertisingFilter);
-#else /* (BLUE_CORE == BLUENRG_MS) */
-    RetStatus = aci_gap_set_undirected_connectable(0,0,BLE_StackValue.OwnAddressType, BLE_StackValue.AdvertisingFilter);
-#endif /* (BLUE_CORE == BLUENRG_MS) */
-    if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
-      BLE_MANAGER_PRINTF("Error: aci_gap_set_undirected_connectable [%x] Filter=%x\r\n",RetStatus,BLE_StackValue.AdvertisingFilter);
-      goto EndLabel;
+    uint64_t Bits;
+    
+    BLE_MemCpy(&Bits,&Value,8);
+    if(Cbor_Reserve(Cbor,9U)) {
+      Cbor->Buffer[Cbor->Length++] = 0xFBU;
+      STORE_BE_32(Cbor->Buffer+Cbor->Length,(uint32_t)(Bits>>32));
+      STORE_BE_32(Cbor->Buffer+Cbor->Length+4U,(uint32_t)Bits);
+      Cbor->Length += 8U;
+    }
+  }
+}
+
+/**
+* @brief  Encode one parson tree with the same logical structure
+* @param  BLE_CborWriter_t *Cbor CBOR writer
+* @param  const JSON_Value *Value parson value to encode
+* @retval None
+*/
+static void Cbor_PutJsonValue(BLE_CborWriter_t *Cbor,const JSON_Value *Value)
+{
+  size_t Index;
+  size_t Count;
+  
+  switch(json_value_get_type(Value)) {
+  case JSONObject:
+    {
+      JSON_Object *Object = json_value_get_object(Value);
+      Count = json_object_get_count(Object);
+      Cbor_PutHead(Cbor,5U,(uint32_t)Count);
+      for(Index=0; Index<Count; Index++) {
+        Cbor_PutText(Cbor,json_object_get_name(Object,Index));
+        Cbor_PutJsonValue(Cbor,json_object_get_value_at(Object,Index));
+      }
+    }
+    break;
+  case JSONArray:
+    {
+      JSON_Array *Array = json_value_get_array(Value);
+      Count = json_array_get_count(Array);
+      Cbor_PutHead(Cbor,4U,(uint32_t)Count);
+      for(Index=0; Index<Count; Index++) {
+        Cbor_PutJsonValue(Cbor,json_array_get_value(Array,Index));
+      }
+    }
+    break;
+  case JSONString:
+    Cbor_PutTextLen(Cbor,json_value_get_string(Value),(uint32_t)json_value_get_string_len(Value));
+    break;
+  case JSONNumber:
+    Cbor_PutNumber(Cbor,json_value_get_number(Value));
+    break;
+  case JSONBoolean:
+    Cbor_PutByte(Cbor,(json_value_get_boolean(Value)==1) ? 0xF5U : 0xF4U);
+    break;
+  default:
+    /* null */
+    Cbor_PutByte(Cbor,0xF6U);
+    break;
+  }
+}
+
+/**
+* @brief  Read one CBOR item head
+* @param  BLE_CborReader_t *Reader CBOR reader
+* @param  uint8_t *Major CBOR major type
+* @param  uint8_t *AddInfo additional information (31 for indefinite length or break)
+* @param  uint64_t *Value argument (value, length or number of items)
+* @retval uint8_t 1 if the head is valid
+*/
+static uint8_t Cbor_GetHead(BLE_CborReader_t *Reader,uint8_t *Major,uint8_t *AddInfo,uint64_t *Value)
+{
+  uint8_t Initial;
+  uint8_t Bytes;
+  
+  if(Reader->Pos >= Reader->Length) {
+    return 0;
+  }
+  
+  Initial = Reader->Buffer[Reader->Pos++];
+  *Major = Initial>>5;
+  *AddInfo  = Initial & 0x1FU;
+  *Value = 0;
+  
+  if((*AddInfo < 24U) || (*AddInfo == 31U)) {
+    *Value = *AddInfo;
+    return 1;
+  }
+  
+  if(*AddInfo > 27U) {
+    return 0;
+  }
+  
+  Bytes = (uint8_t)(1U<<(*AddInfo-24U));
+  if((Reader->Length - Reader->Pos) < Bytes) {
+    return 0;
+  }
+  
+  while(Bytes>0U) {
+    *Value = ((*Value)<<8) | Reader->Buffer[Reader->Pos++];
+    Bytes--;
+  }
+  return 1;
+}
+
+/**
+* @brief  Skip one CBOR item (and all its children)
+* @param  BLE_CborReader_t *Reader CBOR reader
+* @param  uint8_t Depth current nesting level
+* @retval uint8_t 1 if the item is valid
+*/
+static uint8_t Cbor_SkipItem(BLE_CborReader_t *Reader,uint8_t Depth)
+{
+  uint8_t Major;
+  uint8_t AddInfo;
+  uint64_t Value;
+  
+  if(Depth > BLE_CBOR_MAX_NESTING) {
+    return 0;
+  }
+  
+  if(Cbor_GetHead(Reader,&Major,&AddInfo,&Value)==0U) {
+    return 0;
+  }
+  
+  if(AddInfo == 31U) {
+    /* Indefinite length: children until the break code */
+    if((Major<2U) || (Major==6U) || (Major==7U)) {
+      return 0;
+    }
+    while(Reader->Pos < Reader->Length) {
+      if(Reader->Buffer[Reader->Pos] == 0xFFU) {
+        Reader->Pos++;
+        return 1;
+      }
+      if(Cbor_SkipItem(Reader,Depth+1U)==0U) {
+        return 0;
+      }
+    }
+    return 0;
+  }
+  
+  switch(Major) {
+  case 2:
+  case 3:
+    if(Value > (Reader->Length - Reader->Pos)) {
+      return 0;
+    }
+    Reader->Pos += (uint32_t)Value;
+    break;
+  case 4:
+  case 5:
+    if(Major==5U) {
+      Value <<= 1;
+    }
+    while(Value>0U) {
+      if(Cbor_SkipItem(Reader,Depth+1U)==0U) {
+        return 0;
+      }
+      Value--;
+    }
+    break;
+  case 6:
+    /* Tag: skip the tagged item */
+    return Cbor_SkipItem(Reader,Depth+1U);
+  default:
+    /* Integers and simple values are already consumed */
+    break;
+  }
+  return 1;
+}
+
+/**
+* @brief  Read one text string in place.
+*         The string is moved back on its own head for adding the null termination,
+*         so the buffer can not be read again from the beginning
+* @param  BLE_CborReader_t *Reader CBOR reader
+* @param  char **String pointer to the null terminated string inside the buffer
+* @retval uint8_t 1 if the item is a valid text string
+*/
+static uint8_t Cbor_GetText(BLE_CborReader_t *Reader,char **String)
+{
+  uint32_t HeadPos = Reader->Pos;
+  uint8_t Major;
+  uint8_t AddInfo;
+  uint64_t Value;
+  
+  if(Cbor_GetHead(Reader,&Major,&AddInfo,&Value)==0U) {
+    return 0;
+  }
+  
+  if((Major!=3U) || (AddInfo==31U) || (Value > (Reader->Length - Reader->Pos))) {
+    return 0;
+  }
+  
+  memmove(Reader->Buffer+HeadPos,Reader->Buffer+Reader->Pos,(uint32_t)Value);
+  Reader->Buffer[HeadPos+(uint32_t)Value] = 0;
+  *String = (char *)(Reader->Buffer+HeadPos);
+  
+  Reader->Pos += (uint32_t)Value;
+  return 1;
+}
+
+/**
+* @brief  Read one number (integer, half, single or double precision float)
+* @param  BLE_CborReader_t *Reader CBOR reader
+* @param  double *Number number read
+* @retval uint8_t 1 if the item is a valid number
+*/
+static uint8_t Cbor_GetNumber(BLE_CborReader_t *Reader,double *Number)
+{
+  uint8_t Major;
+  uint8_t AddInfo;
+  uint64_t Value;
+  
+  if(Cbor_GetHead(Reader,&Major,&AddInfo,&Value)==0U) {
+    return 0;
+  }
+  
+  if(Major==0U) {
+    *Number = (double)Value;
+  } else if(Major==1U) {
+    *Number = -1.0 - (double)Value;
+  } else if((Major==7U) && (AddInfo==25U)) {
+    /* Half precision float */
+    int32_t Exponent = (int32_t)((Value>>10) & 0x1FU);
+    double Mantissa  = (double)(Value & 0x3FFU);
+    
+    if(Exponent==0) {
+      *Number = ldexp(Mantissa,-24);
+    } else if(Exponent!=31) {
+      *Number = ldexp(Mantissa+1024.0,Exponent-25);
     } else {
-#if (BLE_DEBUG_LEVEL>1)
-      BLE_MANAGER_PRINTF("aci_gap_set_undirected_connectable OK Filter=%x\r\n",BLE_StackValue.AdvertisingFilter);
-#endif
+      *Number = (Mantissa==0.0) ? HUGE_VAL : NAN;
     }
+    if((Value & 0x8000U)!=0U) {
+      *Number = -(*Number);
+    }
+  } else if((Major==7U) && (AddInfo==26U)) {
+    uint32_t Bits = (uint32_t)Value;
+    float SingleValue;
+    
+    BLE_MemCpy(&SingleValue,&Bits,4);
+    *Number = (double)SingleValue;
+  } else if((Major==7U) && (AddInfo==27U)) {
+    BLE_MemCpy(Number,&Value,8);
+  } else {
+    return 0;
   }
+  return 1;
+}
+
+/**
+* @brief  Read the head of one map
+* @param  BLE_CborReader_t *Reader CBOR reader
+* @param  uint32_t *Pairs number of pairs (BLE_CBOR_INDEFINITE_LENGTH for indefinite length map)
+* @retval uint8_t 1 if the item is a valid map
+*/
+static uint8_t Cbor_EnterMap(BLE_CborReader_t *Reader,uint32_t *Pairs)
+{
+  uint8_t Major;
+  uint8_t AddInfo;
+  uint64_t Value;
   
-  updateAdvData();
+  if(Cbor_GetHead(Reader,&Major,&AddInfo,&Value)==0U) {
+    return 0;
+  }
   
-EndLabel:
-  return;
+  if(Major!=5U) {
+    return 0;
+  }
+  
+  *Pairs = (AddInfo==31U) ? BLE_CBOR_INDEFINITE_LENGTH : (uint32_t)Value;
+  return 1;
 }
-#else /* (BLUE_CORE != BLUENRG_LP) */
-void setConnectable(void)
+
+/**
+* @brief  Read the next key of one map (without modifying the buffer)
+* @param  BLE_CborReader_t *Reader CBOR reader
+* @param  uint32_t *Pairs number of pairs still to read
+* @param  const char **Key pointer to the key (not null terminated)
+* @param  uint32_t *KeyLen length of the key
+* @retval uint8_t 1 if there is a valid key, 0 at the end of the map
+*/
+static uint8_t Cbor_NextKey(BLE_CborReader_t *Reader,uint32_t *Pairs,const char **Key,uint32_t *KeyLen)
 {
-  tBleStatus ret;
-  Advertising_Set_Parameters_t Advertising_Set_Parameters[1];
+  uint8_t Major;
+  uint8_t AddInfo;
+  uint64_t Value;
+  
+  if(*Pairs==BLE_CBOR_INDEFINITE_LENGTH) {
+    if(Reader->Pos >= Reader->Length) {
+      return 0;
+    }
+    if(Reader->Buffer[Reader->Pos] == 0xFFU) {
+      Reader->Pos++;
+      return 0;
+    }
+  } else {
+    if(*Pairs==0U) {
+      return 0;
+    }
+    (*Pairs)--;
+  }
+  
+  if(Cbor_GetHead(Reader,&Major,&AddInfo,&Value)==0U) {
+    return 0;
+  }
+  
+  if((Major!=3U) || (AddInfo==31U) || (Value > (Reader->Length - Reader->Pos))) {
+    return 0;
+  }
+  
+  *Key = (const char *)(Reader->Buffer+Reader->Pos);
+  *KeyLen = (uint32_t)Value;
+  Reader->Pos += (uint32_t)Value;
+  return 1;
+}
 
-  manuf_data[0 ]=0x02;
-  manuf_data[1 ]=AD_TYPE_FLAGS;
-  manuf_data[2 ]=FLAG_BIT_LE_GENERAL_DISCOVERABLE_MODE|FLAG_BIT_BR_EDR_NOT_SUPPORTED;
-  manuf_data[3 ]=8;
-  manuf_data[4 ]=0x09;
-  manuf_data[5 ]=BLE_StackValue.BoardName[0];/* Complete Name */
-  manuf_data[6 ]=BLE_StackValue.BoardName[1];
-  manuf_data[7 ]=BLE_StackValue.BoardName[2];
-  manuf_data[8 ]=BLE_StackValue.BoardName[3];
-  manuf_data[9 ]=BLE_StackValue.BoardName[4];
-  manuf_data[10]=BLE_StackValue.BoardName[5];
-  manuf_data[11]=BLE_StackValue.BoardName[6];
-  manuf_data[12]=15;
-  manuf_data[13]=0xFF;
-  manuf_data[14]=0x30;
-  manuf_data[15]=0x00; /* STM Manufacter AD */
-  manuf_data[16]=0x02;  /* SDK version */
-  manuf_data[17]=BLE_MANAGER_USED_PLATFORM; /* BoardType*/
-  manuf_data[18]=0x00; /* Fw ID*/
-  manuf_data[19]=0x00; /* Second Custom Byte -> Not Used */
-  manuf_data[20]=0x00; /* Third  Custom Byte -> Not Used */
-  manuf_data[21]=0x00; /* Fourth Custom Byte -> Not Used */
-  manuf_data[22]=BLE_StackValue.BleMacAddress[5]; /* BLE MAC start - MSB first - */
-  manuf_data[23]=BLE_StackValue.BleMacAddress[4];
-  manuf_data[24]=BLE_StackValue.BleMacAddress[3];
-  manuf_data[25]=BLE_StackValue.BleMacAddress[2];
-  manuf_data[26]=BLE_StackValue.BleMacAddress[1];
-  manuf_data[27]=BLE_StackValue.BleMacAddress[0];  /* BLE MAC stop */
+/**
+* @brief  Decode in place one CBOR encoded Extended Configuration command
+* @param  uint8_t *Buffer CBOR encoded command
+* @param  uint32_t Length length of the command
+* @param  BLE_ExtConfigCborCommand_t *Command decoded command (the strings point inside the buffer)
+* @retval uint8_t 1 if the command is valid
+*/
+static uint8_t ExtConfig_CborDecodeCommand(uint8_t *Buffer,uint32_t Length,BLE_ExtConfigCborCommand_t *Command)
+{
+  BLE_CborReader_t Reader;
+  uint32_t Pairs;
+  const char *Key;
+  uint32_t KeyLen;
+  uint8_t Valid;
+  
+  memset(Command,0,sizeof(BLE_ExtConfigCborCommand_t));
+  Reader.Buffer = Buffer;
+  Reader.Length = Length;
+  Reader.Pos    = 0;
+  
+  Valid = Cbor_EnterMap(&Reader,&Pairs);
+  
+  while((Valid==1U) && (Cbor_NextKey(&Reader,&Pairs,&Key,&KeyLen)==1U)) {
+    if(CBOR_KEY_IS(Key,KeyLen,"command")) {
+      Valid = Cbor_GetText(&Reader,&Command->Command);
+    } else if(CBOR_KEY_IS(Key,KeyLen,"argString")) {
+      Valid = Cbor_GetText(&Reader,&Command->ArgString);
+    } else if(CBOR_KEY_IS(Key,KeyLen,"argNumber")) {
+      Valid = Cbor_GetNumber(&Reader,&Command->ArgNumber);
+      Command->HasArgNumber = Valid;
+    } else if(CBOR_KEY_IS(Key,KeyLen,"argJsonElement")) {
+      uint32_t SubPairs;
+      
+      Valid = Cbor_EnterMap(&Reader,&SubPairs);
+      while((Valid==1U) && (Cbor_NextKey(&Reader,&SubPairs,&Key,&KeyLen)==1U)) {
+        if(CBOR_KEY_IS(Key,KeyLen,"ssid")) {
+          Valid = Cbor_GetText(&Reader,&Command->Ssid);
+        } else if(CBOR_KEY_IS(Key,KeyLen,"password")) {
+          Valid = Cbor_GetText(&Reader,&Command->Password);
+        } else if(CBOR_KEY_IS(Key,KeyLen,"securityType")) {
+          Valid = Cbor_GetText(&Reader,&Command->SecurityType);
+        } else {
+          Valid = Cbor_SkipItem(&Reader,1U);
+        }
+      }
+    } else {
+      Valid = Cbor_SkipItem(&Reader,0U);
+    }
+  }
+  
+  if((Valid==0U) || (Command->Command==NULL)) {
+    BLE_MANAGER_PRINTF("Error: CBOR Command Not Valid\r\n");
+    return 0;
+  }
+  return 1;
+}
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
 
-  /* Set the Custom BLE Advertise Data */
-  BLE_SetCustomAdvertiseData(manuf_data);
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+/**
+* @brief  Send one cached Extended Configuration answer if it's still valid
+* @param  BLE_ExtConfigCachedAnswerType AnswerType answer to send
+* @retval uint8_t 1 if the cached answer was sent, 0 if it must be built (or sent) again
+*/
+static uint8_t ExtConfig_SendCachedAnswer(BLE_ExtConfigCachedAnswerType AnswerType)
+{
+  BLE_ExtConfigCachedAnswer_t *CachedAnswer = &ExtConfigCachedAnswers[AnswerType];
+  tBleStatus ret;
+  
+  if((CachedAnswer->Buffer==NULL) || (CachedAnswer->Version!=ExtConfigAnswersVersion)) {
+    return 0;
+  }
+  
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+  /* The answer was cached with a different encoding */
+  if(CachedAnswer->CborEncoding!=ExtConfigCborEncoding) {
+    return 0;
+  }
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+  
+  ret = BLE_ExtConfig_SendTPBuffer(CachedAnswer->Buffer,CachedAnswer->Length);
+  if(ret!=(tBleStatus)BLE_STATUS_SUCCESS) {
+    /* The answer is sent again (from the beginning) on the not cached path */
+    BLE_MANAGER_PRINTF("Error: BLE_ExtConfig_SendTPBuffer() failed:0x%02x\r\n",ret);
+    return 0;
+  }
+  return 1;
+}
 
-  if(CustomSetConnectable!=NULL){
-    CustomSetConnectable(manuf_data);
+/**
+* @brief  Encapsulate one Extended Configuration answer, store it on cache and send it
+* @param  BLE_ExtConfigCachedAnswerType AnswerType answer to store
+* @param  uint8_t *data string to write
+* @param  uint32_t lenght lengt of string to write
+* @retval tBleStatus      Status
+*/
+static tBleStatus ExtConfig_CacheAndSendAnswer(BLE_ExtConfigCachedAnswerType AnswerType,uint8_t *data,uint32_t length)
+{
+  BLE_ExtConfigCachedAnswer_t *CachedAnswer = &ExtConfigCachedAnswers[AnswerType];
+  uint32_t length_wTP;
+  tBleStatus ret;
+  
+  /* Release the previous version */
+  if(CachedAnswer->Buffer!=NULL) {
+    BLE_FreeFunction(CachedAnswer->Buffer);
+    CachedAnswer->Buffer = NULL;
+  }
+  
+  if ((length % 19U) == 0U) {
+    length_wTP = (length/19U)+length;
+  } else {
+    length_wTP = (length/19U)+1U+length;
+  }
+  
+  CachedAnswer->Buffer = BLE_MallocFunction(sizeof(uint8_t) * length_wTP);
+  if(CachedAnswer->Buffer==NULL) {
+    /* Not able to cache it... send it in the usual way */
+    return BLE_ExtConfiguration_Update(data,length);
   }
+  
+  CachedAnswer->Length  = BLE_Command_TP_Encapsulate(CachedAnswer->Buffer, data, length);
+  CachedAnswer->Version = ExtConfigAnswersVersion;
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+  CachedAnswer->CborEncoding = ExtConfigCborEncoding;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+  
+  ret = BLE_ExtConfig_SendTPBuffer(CachedAnswer->Buffer,CachedAnswer->Length);
+  if(ret!=(tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: BLE_ExtConfig_SendTPBuffer() failed:0x%02x\r\n",ret);
+  }
+  return ret;
+}
 
-  ret = aci_gap_set_advertising_configuration(0, GAP_MODE_GENERAL_DISCOVERABLE,
-                                              ADV_PROP_CONNECTABLE | ADV_PROP_SCANNABLE | ADV_PROP_LEGACY,
-                                              ADV_INTERV_MIN,
-                                              ADV_INTERV_MAX,
-                                              ADV_CH_ALL,
-                                              STATIC_RANDOM_ADDR, NULL,
-                                              ADV_NO_WHITE_LIST_USE,
-                                              0, /* 0 dBm */
-                                              LE_1M_PHY, /* Primary advertising PHY */
-                                              0, /* 0 skips */
-                                              LE_1M_PHY, /* Secondary advertising PHY. Not used with legacy advertising. */
-                                              0, /* SID */
-                                              0 /* No scan request notifications */);
+/**
+* @brief  Serialize one Extended Configuration answer, store it on cache and send it
+* @param  BLE_ExtConfigCachedAnswerType AnswerType answer to store
+* @param  const JSON_Value *tempJSON answer to serialize
+* @retval tBleStatus      Status
+*/
+static tBleStatus ExtConfig_CacheAndSendJsonAnswer(BLE_ExtConfigCachedAnswerType AnswerType,const JSON_Value *tempJSON)
+{
+  tBleStatus ret = BLE_STATUS_ERROR;
+  uint32_t length;
+  uint8_t *data = ExtConfig_SerializeAnswer(tempJSON,&length);
+  
+  if(data!=NULL) {
+    ret = ExtConfig_CacheAndSendAnswer(AnswerType,data,length);
+    BLE_FreeFunction(data);
+  }
+  return ret;
+}
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+#endif /* BLE_MANAGER_NO_PARSON */
 
-  if(ret != BLE_STATUS_SUCCESS) {
-    BLE_MANAGER_PRINTF("aci_gap_set_advertising_configuration failed: 0x%02x\r\n", ret);
-    goto EndLabel;
+/* Exported functions -----------------------------------------------------------*/
+
+#ifndef BLE_MANAGER_NO_PARSON
+/**
+* @brief  Update Extended Configuration characteristic value
+* @param  uint8_t *data string to write
+* @param  uint32_t lenght lengt of string to write
+* @retval tBleStatus      Status
+*/
+tBleStatus BLE_ExtConfiguration_Update(uint8_t *data,uint32_t length)
+{
+  uint32_t tot_len;
+  uint8_t *JSON_string_command_wTP;
+  uint32_t length_wTP;
+  
+  if ((length % 19U) == 0U) {
+    length_wTP = (length/19U)+length;
   } else {
-    BLE_MANAGER_PRINTF("aci_gap_set_advertising_configuration\r\n");
+    length_wTP = (length/19U)+1U+length;
   }
+  
+  JSON_string_command_wTP = BLE_MallocFunction(sizeof(uint8_t) * length_wTP);
+  
+  if(JSON_string_command_wTP==NULL) {
+    BLE_MANAGER_PRINTF("Error: Mem calloc error [%lu]: %d@%s\r\n",length,__LINE__,__FILE__);
+    return BLE_STATUS_ERROR;
+  } else {
+    tBleStatus ret;
+    tot_len = BLE_Command_TP_Encapsulate(JSON_string_command_wTP, data, length);
+    
+    ret = BLE_ExtConfig_SendTPBuffer(JSON_string_command_wTP,tot_len);
+    BLE_FreeFunction(JSON_string_command_wTP);
+    return ret;
+  }
+}
+
+#ifdef BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE
+/**
+* @brief  Invalidate all the cached Extended Configuration answers.
+*         It's called by the BLE Manager when the Custom Commands List changes and
+*         it must be called by the application when the sensors configuration changes
+* @param  None
+* @retval None
+*/
+void BLE_ExtConfigInvalidateCachedAnswers(void)
+{
+  ExtConfigAnswersVersion++;
+}
+#endif /* BLE_MANAGER_EXTCONFIG_ANSWERS_CACHE */
+#endif /* BLE_MANAGER_NO_PARSON */
+
+/**
+* @brief Each time BLE FW stack raises the error code @ref ble_status_insufficient_resources (0x64),
+the @ref aci_gatt_tx_pool_available_event event is generated as soon as the available buffer size 
+is greater than maximum ATT MTU (on stack versions below v2.1 this event is generated when at least 2 packets
+with MTU of 23 bytes are available).
+* @param Connection_Handle Connection handle related to the request
+* @param Available_Buffers Not used.
+* @retval None
+*/
+void aci_gatt_tx_pool_available_event(uint16_t Connection_Handle,
+                                      uint16_t Available_Buffers)
+{
+#if (BLE_DEBUG_LEVEL>1)
+  BLE_MANAGER_PRINTF("aci_gatt_tx_pool_available_event\r\n");
+#endif
+  
+#ifdef ACC_BLUENRG_CONGESTION
+  breath=0;
+#endif /* ACC_BLUENRG_CONGESTION */
+  
+#ifdef BLE_MANAGER_STATS
+  BLE_HciStats.TxPoolAvailableEvents++;
+#endif /* BLE_MANAGER_STATS */
+  
+  if(CustomAciGattTxPoolAvailableEvent != NULL) {
+    CustomAciGattTxPoolAvailableEvent();
+  }
+}
+
+/* @brief  Update the value of a characteristic
+* @param  BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @param  charValOffset The offset of the characteristic
+* @param  charValueLen The length of the characteristic
+* @param  charValue The pointer to the characteristic
+* @retval tBleStatus Status
+*/
+tBleStatus aci_gatt_update_char_value_wrapper(BleCharTypeDef *BleCharPointer,
+                                              uint8_t charValOffset,
+                                              uint8_t charValueLen,
+                                              uint8_t *charValue)
+{
+  tBleStatus ret = BLE_STATUS_INSUFFICIENT_RESOURCES;
+  
+  if(BLE_UpdateCharPreSend(BleCharPointer,charValOffset,charValueLen,charValue,&ret)==0U) {
+    return ret;
+  }
+  
+  return BLE_UpdateCharSend(BleCharPointer,charValOffset,charValueLen,charValue);
+}
+
+#ifdef BLE_MANAGER_STATS
+/**
+* @brief  Update the runtime counters of one characteristic after an update
+* @param  BleCharTypeDef *BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @param  tBleStatus ret Status of the update
+* @param  uint8_t charValueLen The length of the characteristic
+* @retval None
+*/
+static void BLE_StatsCharUpdate(BleCharTypeDef *BleCharPointer,tBleStatus ret,uint8_t charValueLen)
+{
+  BLE_CharStats_t *Stats = &BleCharPointer->Stats;
+  
+  Stats->UpdatesAttempted++;
+  if(ret==(tBleStatus)BLE_STATUS_SUCCESS) {
+    Stats->UpdatesSucceeded++;
+    Stats->BytesSent += charValueLen;
+    Stats->PendingUpdates = 0U;
+  } else if(ret==(tBleStatus)BLE_STATUS_INSUFFICIENT_RESOURCES) {
+    Stats->InsufficientResources++;
+    if(Stats->PendingUpdates<0xFFFFU) {
+      Stats->PendingUpdates++;
+    }
+    if(Stats->PendingUpdates>Stats->PendingHighWater) {
+      Stats->PendingHighWater = Stats->PendingUpdates;
+    }
+  } else {
+    /* Other errors are only counted as attempts */
+  }
+}
+
+/**
+* @brief  Reset the HCI counters and the counters of all the characteristics
+* @param  None
+* @retval None
+*/
+void BLE_StatsReset(void)
+{
+  uint8_t BleChar;
+  
+  memset(&BLE_HciStats,0,sizeof(BLE_HciStats_t));
+  for(BleChar=0; BleChar<UsedBleChars; BleChar++) {
+    memset(&BleCharsArray[BleChar]->Stats,0,sizeof(BLE_CharStats_t));
+  }
+}
+
+/**
+* @brief  Count one event not received because the HCI read packets pool was exhausted
+*         (to call from the HCI transport layer interrupt)
+* @param  None
+* @retval None
+*/
+void BLE_StatsHciRxPoolExhausted(void)
+{
+  BLE_HciStats.HciRxPoolExhausted++;
+}
+
+/**
+* @brief  Write the runtime counters on the Term characteristic (one line for each used characteristic)
+* @param  None
+* @retval None
+*/
+static void Term_SendStats(void)
+{
+  uint8_t BleChar;
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"HCI evt=%lu rxFull=%lu txPool=%lu lost=%lu\r\n",
+                                 (unsigned long)BLE_HciStats.HciEvents,
+                                 (unsigned long)BLE_HciStats.HciRxPoolExhausted,
+                                 (unsigned long)BLE_HciStats.TxPoolAvailableEvents,
+                                 (unsigned long)BLE_HciStats.EventsLost);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  for(BleChar=0; BleChar<UsedBleChars; BleChar++) {
+    BLE_CharStats_t *Stats = &BleCharsArray[BleChar]->Stats;
+    
+    if(Stats->UpdatesAttempted!=0U) {
+      /* Add a Delay respect previous line */
+      BLE_MANAGER_DELAY(20);
+      BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"0x%04X a=%lu ok=%lu ir=%lu B=%lu q=%u lat=%lu (%s)\r\n",
+                                     BleCharsArray[BleChar]->attr_handle,
+                                     (unsigned long)Stats->UpdatesAttempted,
+                                     (unsigned long)Stats->UpdatesSucceeded,
+                                     (unsigned long)Stats->InsufficientResources,
+                                     (unsigned long)Stats->BytesSent,
+                                     Stats->PendingHighWater,
+                                     (unsigned long)Stats->LastUpdateLatency,
+                                     BLE_MANAGER_STATS_LATENCY_UNIT);
+      Term_Update(BufferToWrite,BytesToWrite);
+    }
+  }
+}
+#endif /* BLE_MANAGER_STATS */
+
+#ifdef BLE_MANAGER_PROFILING
+/**
+* @brief  Enable the cycle counter and reset all the histograms
+* @param  None
+* @retval None
+*/
+void BLE_ProfileInit(void)
+{
+  /* Enable the trace (DEMCR.TRCENA) and the DWT cycle counter (DWT_CTRL.CYCCNTENA) */
+  BLE_PROFILE_DEMCR |= (1UL << 24);
+  BLE_PROFILE_DWT_CYCCNT = 0U;
+  BLE_PROFILE_DWT_CTRL |= 1UL;
+  BLE_ProfileReset();
+}
+
+/**
+* @brief  Reset all the histograms
+* @param  None
+* @retval None
+*/
+void BLE_ProfileReset(void)
+{
+  memset(BleProfileProbes,0,sizeof(BleProfileProbes));
+}
+
+/**
+* @brief  Histogram bucket of one measure: values below 8 have one bucket each,
+*         then every power of two is split in 4 buckets
+* @param  uint32_t Elapsed measure
+* @retval uint32_t bucket
+*/
+static uint32_t BLE_ProfileBucket(uint32_t Elapsed)
+{
+  uint32_t Msb;
+  
+  if(Elapsed<8U) {
+    return Elapsed;
+  }
+  
+#if defined(__GNUC__)
+  Msb = 31U - (uint32_t)__builtin_clz(Elapsed);
+#else /* defined(__GNUC__) */
+  for(Msb=31U; (Elapsed & (1UL<<Msb))==0U; Msb--) {
+  }
+#endif /* defined(__GNUC__) */
+  
+  if(Msb>BLE_PROFILE_MAX_LOG2) {
+    return BLE_PROFILE_BUCKETS-1U;
+  }
+  return 8U + ((Msb-3U)*4U) + ((Elapsed>>(Msb-2U)) & 3U);
+}
+
+/**
+* @brief  Greatest value contained in one histogram bucket
+* @param  uint32_t Bucket bucket
+* @retval uint32_t upper bound
+*/
+static uint32_t BLE_ProfileBucketUpperBound(uint32_t Bucket)
+{
+  uint32_t Msb;
+  uint32_t Sub;
+  
+  if(Bucket<8U) {
+    return Bucket;
+  }
+  Msb = 3U + ((Bucket-8U)/4U);
+  Sub = (Bucket-8U)%4U;
+  return ((4U+Sub+1U)<<(Msb-2U)) - 1U;
+}
+
+/**
+* @brief  Add one measure to the histogram of one profiled section
+* @param  BLE_ProfileProbeType Probe profiled section
+* @param  uint32_t Elapsed measure (BLE_PROFILE_UNIT units)
+* @retval None
+*/
+void BLE_ProfileAdd(BLE_ProfileProbeType Probe, uint32_t Elapsed)
+{
+  BLE_ProfileProbe_t *LocProbe = &BleProfileProbes[Probe];
+  
+  if((LocProbe->Count==0U) || (Elapsed<LocProbe->Min)) {
+    LocProbe->Min = Elapsed;
+  }
+  if(Elapsed>LocProbe->Max) {
+    LocProbe->Max = Elapsed;
+  }
+  LocProbe->Count++;
+  LocProbe->Sum += Elapsed;
+  LocProbe->Histogram[BLE_ProfileBucket(Elapsed)]++;
+}
+
+/**
+* @brief  Compute min/avg/max/p99 of one profiled section
+* @param  BLE_ProfileProbeType Probe profiled section
+* @param  BLE_ProfileReport_t *Report filled with the summary
+* @retval uint8_t 1 for valid Probe, 0 otherwise
+*/
+uint8_t BLE_ProfileGetReport(BLE_ProfileProbeType Probe, BLE_ProfileReport_t *Report)
+{
+  BLE_ProfileProbe_t *LocProbe;
+  uint32_t Threshold;
+  uint32_t Cumulative=0;
+  uint32_t Bucket;
+  
+  if(((uint32_t)Probe)>=((uint32_t)BLE_PROFILE_PROBES_NUMBER)) {
+    return 0U;
+  }
+  
+  LocProbe = &BleProfileProbes[Probe];
+  memset(Report,0,sizeof(BLE_ProfileReport_t));
+  if(LocProbe->Count==0U) {
+    return 1U;
+  }
+  
+  Report->Count = LocProbe->Count;
+  Report->Min = LocProbe->Min;
+  Report->Max = LocProbe->Max;
+  Report->Avg = (uint32_t)(LocProbe->Sum / LocProbe->Count);
+  
+  /* First bucket where at least 99% of the measures are collected */
+  Threshold = LocProbe->Count - (LocProbe->Count/100U);
+  for(Bucket=0; Bucket<BLE_PROFILE_BUCKETS; Bucket++) {
+    Cumulative += LocProbe->Histogram[Bucket];
+    if(Cumulative>=Threshold) {
+      break;
+    }
+  }
+  Report->P99 = BLE_ProfileBucketUpperBound(Bucket);
+  if(Report->P99>Report->Max) {
+    Report->P99 = Report->Max;
+  }
+  return 1U;
+}
+
+/**
+* @brief  Format the summary of one profiled section in one text line
+* @param  BLE_ProfileProbeType Probe profiled section
+* @param  char *Buffer output buffer (at least 96 bytes)
+* @retval uint32_t length of the line
+*/
+uint32_t BLE_ProfileFormat(BLE_ProfileProbeType Probe, char *Buffer)
+{
+  BLE_ProfileReport_t Report;
+  
+  if(BLE_ProfileGetReport(Probe,&Report)==0U) {
+    Buffer[0] = '\0';
+    return 0U;
+  }
+  
+  return (uint32_t)sprintf(Buffer,"%s n=%lu min=%lu avg=%lu max=%lu p99=%lu\r\n",
+                           BleProfileProbeNames[Probe],
+                           (unsigned long)Report.Count,
+                           (unsigned long)Report.Min,
+                           (unsigned long)Report.Avg,
+                           (unsigned long)Report.Max,
+                           (unsigned long)Report.P99);
+}
+
+/**
+* @brief  Print the summary of all the profiled sections with BLE_MANAGER_PRINTF
+* @param  None
+* @retval None
+*/
+void BLE_ProfilePrint(void)
+{
+  char Line[96];
+  uint32_t Probe;
+  
+  BLE_MANAGER_PRINTF("Profiling (%s):\r\n",BLE_PROFILE_UNIT);
+  for(Probe=0; Probe<((uint32_t)BLE_PROFILE_PROBES_NUMBER); Probe++) {
+    (void)BLE_ProfileFormat((BLE_ProfileProbeType)Probe,Line);
+    BLE_MANAGER_PRINTF("%s",Line);
+  }
+}
+
+/**
+* @brief  Write the summary of all the profiled sections on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendProfiling(void)
+{
+  uint32_t Probe;
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Profiling (%s):\r\n",BLE_PROFILE_UNIT);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  for(Probe=0; Probe<((uint32_t)BLE_PROFILE_PROBES_NUMBER); Probe++) {
+    /* Add a Delay respect previous line */
+    BLE_MANAGER_DELAY(20);
+    BytesToWrite =(uint8_t)BLE_ProfileFormat((BLE_ProfileProbeType)Probe,(char *)BufferToWrite);
+    Term_Update(BufferToWrite,BytesToWrite);
+  }
+}
+
+#if (BLUE_CORE == BLUENRG_1_2)
+/**
+* @brief  Timing hook of the HCI transport layer: start of hci_send_req or hci_user_evt_proc
+* @param  None
+* @retval uint32_t start timestamp
+*/
+uint32_t hci_tl_timing_start(void)
+{
+  return BLE_PROFILE_TIMESTAMP();
+}
+
+/**
+* @brief  Timing hook of the HCI transport layer: end of hci_send_req or hci_user_evt_proc
+* @param  uint8_t Section HCI_TL_TIMING_SEND_REQ or HCI_TL_TIMING_USER_EVT_PROC
+* @param  uint32_t Start timestamp returned by hci_tl_timing_start
+* @retval None
+*/
+void hci_tl_timing_stop(uint8_t Section, uint32_t Start)
+{
+  BLE_ProfileAdd((Section==HCI_TL_TIMING_SEND_REQ) ? BLE_PROFILE_HCI_SEND_REQ : BLE_PROFILE_HCI_USER_EVT_PROC,
+                 BLE_PROFILE_TIMESTAMP() - Start);
+}
+#endif /* (BLUE_CORE == BLUENRG_1_2) */
+#endif /* BLE_MANAGER_PROFILING */
+
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+/**
+* @brief  Paint the free stack and the heap for the high-water marks tracking
+*         (to call at the beginning of main, before any dynamic allocation)
+* @param  void *HeapStart Lowest address of the heap
+* @param  void *HeapEnd First address after the heap
+* @param  void *StackLimit Lowest address of the stack
+* @param  void *StackTop First address after the stack (initial stack pointer)
+* @retval None
+*/
+void BLE_MemPaint(void *HeapStart, void *HeapEnd, void *StackLimit, void *StackTop)
+{
+  uint32_t *Word;
+  uint32_t Phase;
+  
+  /* Only the whole words inside the regions are used */
+  BleMemTracker.HeapStart  = (uint32_t *)(((uintptr_t)HeapStart + 3U) & ~((uintptr_t)3U));
+  BleMemTracker.HeapEnd    = (uint32_t *)((uintptr_t)HeapEnd & ~((uintptr_t)3U));
+  BleMemTracker.StackLimit = (uint32_t *)(((uintptr_t)StackLimit + 3U) & ~((uintptr_t)3U));
+  BleMemTracker.StackTop   = (uint32_t *)((uintptr_t)StackTop & ~((uintptr_t)3U));
+  
+  if(BleMemTracker.HeapEnd < BleMemTracker.HeapStart) {
+    BleMemTracker.HeapEnd = BleMemTracker.HeapStart;
+  }
+  if(BleMemTracker.StackTop < BleMemTracker.StackLimit) {
+    BleMemTracker.StackTop = BleMemTracker.StackLimit;
+  }
+  
+  for(Word=BleMemTracker.HeapStart; Word<BleMemTracker.HeapEnd; Word++) {
+    *Word = BLE_MEM_PAINT_PATTERN;
+  }
+  
+  for(Phase=0; Phase<((uint32_t)BLE_MEM_PHASES_NUMBER); Phase++) {
+    memset(&BleMemTracker.Phases[Phase],0,sizeof(BLE_MemWatermark_t));
+    BleMemTracker.Phases[Phase].StackSize = (uint32_t)((uintptr_t)BleMemTracker.StackTop - (uintptr_t)BleMemTracker.StackLimit);
+    BleMemTracker.Phases[Phase].HeapSize  = (uint32_t)((uintptr_t)BleMemTracker.HeapEnd - (uintptr_t)BleMemTracker.HeapStart);
+  }
+  BleMemTracker.ActivePhases = 1UL << ((uint32_t)BLE_MEM_PHASE_ALL);
+  
+  BLE_MemPaintStack();
+}
+
+/**
+* @brief  Start one phase (the current usage is accounted to the phases already running)
+* @param  BLE_MemPhaseType Phase phase to start
+* @retval None
+*/
+void BLE_MemPhaseEnter(BLE_MemPhaseType Phase)
+{
+  if((BleMemTracker.StackTop==NULL) || (Phase>=BLE_MEM_PHASES_NUMBER)) {
+    return;
+  }
+  
+  /* The heap is painted only once, so its high-water mark is read at the end of the phase */
+  BLE_MemSample(0U);
+  BleMemTracker.ActivePhases |= 1UL << ((uint32_t)Phase);
+}
+
+/**
+* @brief  End one phase updating its high-water marks
+* @param  BLE_MemPhaseType Phase phase to end
+* @retval None
+*/
+void BLE_MemPhaseExit(BLE_MemPhaseType Phase)
+{
+  if((BleMemTracker.StackTop==NULL) || (Phase>=BLE_MEM_PHASES_NUMBER) || (Phase==BLE_MEM_PHASE_ALL)) {
+    return;
+  }
+  
+  BLE_MemSample(1U);
+  BleMemTracker.ActivePhases &= ~(1UL << ((uint32_t)Phase));
+}
+
+/**
+* @brief  Reset the high-water marks of all the phases and paint again the free stack
+*         (the heap is not painted again, so its high-water mark is the one since the boot)
+* @param  None
+* @retval None
+*/
+void BLE_MemReset(void)
+{
+  uint32_t Phase;
+  
+  if(BleMemTracker.StackTop==NULL) {
+    return;
+  }
+  
+  for(Phase=0; Phase<((uint32_t)BLE_MEM_PHASES_NUMBER); Phase++) {
+    BleMemTracker.Phases[Phase].StackUsed = 0U;
+    BleMemTracker.Phases[Phase].HeapUsed = 0U;
+    BleMemTracker.Phases[Phase].StackOverflow = 0U;
+  }
+  
+  BLE_MemPaintStack();
+}
+
+/**
+* @brief  Read the high-water marks of one phase
+* @param  BLE_MemPhaseType Phase phase to read
+* @param  BLE_MemWatermark_t *Watermark filled with the high-water marks
+* @retval uint8_t 1 for valid Phase after BLE_MemPaint, 0 otherwise
+*/
+uint8_t BLE_MemGetWatermark(BLE_MemPhaseType Phase, BLE_MemWatermark_t *Watermark)
+{
+  if((BleMemTracker.StackTop==NULL) || (Phase>=BLE_MEM_PHASES_NUMBER) || (Watermark==NULL)) {
+    return 0U;
+  }
+  
+  /* A running phase includes also the usage up to now */
+  if((BleMemTracker.ActivePhases & (1UL << ((uint32_t)Phase)))!=0U) {
+    BLE_MemSample(1U);
+  }
+  
+  *Watermark = BleMemTracker.Phases[Phase];
+  return 1U;
+}
+
+/**
+* @brief  Update the high-water marks of the running phases and paint again the free stack
+* @param  uint8_t WithHeap 1 for scanning also the heap
+* @retval None
+*/
+static void BLE_MemSample(uint8_t WithHeap)
+{
+  uint32_t *Word;
+  uint32_t StackUsed;
+  uint32_t HeapUsed = 0U;
+  uint8_t StackOverflow = 0U;
+  uint32_t Phase;
+  
+  /* The stack grows down: the deepest point is the lowest word not painted */
+  Word = BleMemTracker.StackLimit;
+  if((Word<BleMemTracker.StackTop) && (*Word!=BLE_MEM_PAINT_PATTERN)) {
+    StackOverflow = 1U;
+  }
+  while((Word<BleMemTracker.StackTop) && (*Word==BLE_MEM_PAINT_PATTERN)) {
+    Word++;
+  }
+  StackUsed = (uint32_t)((uintptr_t)BleMemTracker.StackTop - (uintptr_t)Word);
+  
+  if(WithHeap) {
+    /* The heap grows up: the highest point is the highest word not painted */
+    Word = BleMemTracker.HeapEnd;
+    while((Word>BleMemTracker.HeapStart) && (*(Word-1)==BLE_MEM_PAINT_PATTERN)) {
+      Word--;
+    }
+    HeapUsed = (uint32_t)((uintptr_t)Word - (uintptr_t)BleMemTracker.HeapStart);
+  }
+  
+  for(Phase=0; Phase<((uint32_t)BLE_MEM_PHASES_NUMBER); Phase++) {
+    if((BleMemTracker.ActivePhases & (1UL << Phase))!=0U) {
+      BLE_MemWatermark_t *Watermark = &BleMemTracker.Phases[Phase];
+      if(StackUsed > Watermark->StackUsed) {
+        Watermark->StackUsed = StackUsed;
+      }
+      if(HeapUsed > Watermark->HeapUsed) {
+        Watermark->HeapUsed = HeapUsed;
+      }
+      Watermark->StackOverflow |= StackOverflow;
+    }
+  }
+  
+  BLE_MemPaintStack();
+}
+
+/**
+* @brief  Paint the stack below the current stack pointer (minus BLE_MEM_STACK_GUARD bytes)
+* @param  None
+* @retval None
+*/
+static void BLE_MemPaintStack(void)
+{
+  volatile uint32_t Marker = 0U;
+  uint32_t *Word;
+  uint32_t *PaintEnd;
+  
+  /* Nothing to do if we are not running on the painted stack (e.g. inside one RTOS thread) */
+  if(((uintptr_t)&Marker < ((uintptr_t)BleMemTracker.StackLimit + BLE_MEM_STACK_GUARD)) ||
+     ((uintptr_t)&Marker >= (uintptr_t)BleMemTracker.StackTop)) {
+    return;
+  }
+  
+  PaintEnd = (uint32_t *)(((uintptr_t)&Marker - BLE_MEM_STACK_GUARD) & ~((uintptr_t)3U));
+  for(Word=BleMemTracker.StackLimit; Word<PaintEnd; Word++) {
+    *Word = BLE_MEM_PAINT_PATTERN;
+  }
+}
+
+/**
+* @brief  Format the high-water marks of one phase in one text line
+* @param  BLE_MemPhaseType Phase phase to format
+* @param  char *Buffer output buffer (at least 64 bytes)
+* @retval uint32_t length of the line
+*/
+static uint32_t BLE_MemFormat(BLE_MemPhaseType Phase, char *Buffer)
+{
+  BLE_MemWatermark_t Watermark;
+  
+  if(BLE_MemGetWatermark(Phase,&Watermark)==0U) {
+    return (uint32_t)sprintf(Buffer,"Memory not painted\r\n");
+  }
+  
+  return (uint32_t)sprintf(Buffer,"%-10s S=%lu/%lu H=%lu/%lu%s\r\n",
+                           BleMemPhaseNames[Phase],
+                           (unsigned long)Watermark.StackUsed,
+                           (unsigned long)Watermark.StackSize,
+                           (unsigned long)Watermark.HeapUsed,
+                           (unsigned long)Watermark.HeapSize,
+                           (Watermark.StackOverflow!=0U) ? " OVF" : "");
+}
+
+/**
+* @brief  Print the high-water marks of all the phases with BLE_MANAGER_PRINTF
+* @param  None
+* @retval None
+*/
+void BLE_MemPrint(void)
+{
+  char Line[64];
+  uint32_t Phase;
+  
+  BLE_MANAGER_PRINTF("Memory high-water marks (bytes):\r\n");
+  for(Phase=0; Phase<((uint32_t)BLE_MEM_PHASES_NUMBER); Phase++) {
+    (void)BLE_MemFormat((BLE_MemPhaseType)Phase,Line);
+    BLE_MANAGER_PRINTF("%s",Line);
+  }
+}
+
+/**
+* @brief  Write the high-water marks of all the phases on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendMemWatermark(void)
+{
+  uint32_t Phase;
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Memory high-water marks (bytes):\r\n");
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  for(Phase=0; Phase<((uint32_t)BLE_MEM_PHASES_NUMBER); Phase++) {
+    /* Add a Delay respect previous line */
+    BLE_MANAGER_DELAY(20);
+    BytesToWrite =(uint8_t)BLE_MemFormat((BLE_MemPhaseType)Phase,(char *)BufferToWrite);
+    Term_Update(BufferToWrite,BytesToWrite);
+  }
+}
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+
+/**
+* @brief  Update Stderr characteristic value
+* @param  uint8_t *data string to write
+* @param  uint8_t lenght lengt of string to write
+* @retval tBleStatus      Status
+*/
+tBleStatus Stderr_Update(uint8_t *data,uint8_t length)
+{
+  uint8_t Offset;
+  uint8_t DataToSend;
+  
+#ifdef BLE_MANAGER_RTOS
+  if(BLE_RtosIsOtherThread()) {
+    /* Sent by the BLE task */
+    return BLE_RtosPostText(&BleCharStdErr,data,length);
+  }
+#endif /* BLE_MANAGER_RTOS */
+  /* Split the code in Chunks */
+  /* First Chunk */
+  DataToSend = (length>MaxBleCharStdErrLen) ?  MaxBleCharStdErrLen : length;
+  
+  /* keep a copy */
+  memcpy(LastStderrBuffer,data,DataToSend);
+  LastStderrLen = DataToSend;
+  
+  if(UpdateTermStdErr(data,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
+    return BLE_STATUS_ERROR;
+  }
+  
+  /* Following Chunks if necessary */
+  Offset = MaxBleCharStdErrLen;
+  for(; Offset<length; Offset +=MaxBleCharStdErrLen){
+    /* Add a Delay respect previous chunk */
+    BLE_MANAGER_DELAY(20);
+    
+    DataToSend = (length-Offset);
+    DataToSend = (DataToSend>MaxBleCharStdErrLen) ?  MaxBleCharStdErrLen : DataToSend;
+    
+    /* keep a copy */
+    memcpy(LastStderrBuffer,data+Offset,DataToSend);
+    LastStderrLen = DataToSend;
+    
+    if(UpdateTermStdErr(data+Offset,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
+      return BLE_STATUS_ERROR;
+    }
+  }
+  return BLE_STATUS_SUCCESS;
+}
+
+/**
+* @brief  
+* @param  uint8_t* buffer
+* @param  uint8_t len
+* @retval tBleStatus   Status
+*/
+tBleStatus BLE_StdOutSendBuffer(uint8_t* buffer, uint8_t len)
+{
+  tBleStatus ret;
+  
+#ifdef BLE_MANAGER_RTOS
+  if(BLE_RtosIsOtherThread()) {
+    /* Sent by the BLE task */
+    return BLE_RtosPostText(&BleCharStdOut,buffer,len);
+  }
+#endif /* BLE_MANAGER_RTOS */
+  
+  #if (BLUE_CORE != BLUENRG_LP)
+    ret = aci_gatt_update_char_value(BleCharStdOut.Service_Handle, BleCharStdOut.attr_handle, 0, len, buffer);
+  #else /* (BLUE_CORE != BLUENRG_LP) */
+    ret = aci_gatt_srv_notify(connection_handle, BleCharStdOut.attr_handle+1, GATT_NOTIFICATION, len, buffer);
+  #endif /* (BLUE_CORE != BLUENRG_LP) */
+  
+  return ret;
+}
+
+/**
+* @brief  Update Terminal characteristic value
+* @param  uint8_t *data string to write
+* @param  uint8_t lenght lengt of string to write
+* @retval tBleStatus      Status
+*/
+tBleStatus Term_Update(uint8_t *data,uint8_t length)
+{
+  uint8_t   Offset;
+  uint8_t   DataToSend;
+  
+#ifdef BLE_MANAGER_RTOS
+  if(BLE_RtosIsOtherThread()) {
+    /* Sent by the BLE task */
+    return BLE_RtosPostText(&BleCharStdOut,data,length);
+  }
+#endif /* BLE_MANAGER_RTOS */
+  
+  /* Split the code in Chunks */
+  /* First Chunk */
+  DataToSend = (length>MaxBleCharStdOutLen) ?  MaxBleCharStdOutLen : length;
+  
+  /* keep a copy */
+  memcpy(LastTermBuffer,data,DataToSend);
+  LastTermLen = DataToSend;
+  
+  if(UpdateTermStdOut(data,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
+    return BLE_STATUS_ERROR;
+  }
+  
+  /* Following Chunks if necessary */
+  Offset = MaxBleCharStdOutLen;
+  for(; Offset<length; Offset +=MaxBleCharStdOutLen){
+    
+    /* Add a Delay respect previous chunk */
+    BLE_MANAGER_DELAY(20);
+    
+    DataToSend = (length-Offset);
+    DataToSend = (DataToSend>MaxBleCharStdOutLen) ?  MaxBleCharStdOutLen : DataToSend;
+    
+    /* keep a copy */
+    memcpy(LastTermBuffer,data+Offset,DataToSend);
+    LastTermLen = DataToSend;
+    
+    if(UpdateTermStdOut(data+Offset,DataToSend)!=(tBleStatus)BLE_STATUS_SUCCESS) {
+      return BLE_STATUS_ERROR;
+    }
+  }
+  return BLE_STATUS_SUCCESS;
+}
+
+/* @brief  Send a BLE notification for answering to a configuration command for Accelerometer events
+* @param  uint32_t Feature Feature type
+* @param  uint8_t Command Replay to this Command
+* @param  uint8_t data result to send back
+* @retval tBleStatus Status
+*/
+tBleStatus Config_Update(uint32_t Feature,uint8_t Command,uint8_t data)
+{
+  uint8_t buff[2+4+1+1];
+  
+  STORE_LE_16(buff  ,(HAL_GetTick()>>3));
+  STORE_BE_32(buff+2,Feature);
+  buff[6] = Command;
+  buff[7] = data;
+  
+  if (ACI_GATT_UPDATE_CHAR_VALUE(&BleCharConfig, 0, 8 , buff) != (tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: Updating Configuration Char\r\n");
+    return BLE_STATUS_ERROR;
+  } 
+  return BLE_STATUS_SUCCESS;
+  
+}
+
+/* @brief  Send a BLE notification for answering to a configuration command for Accelerometer events
+* @param  uint32_t Feature Feature type
+* @param  uint8_t Command Replay to this Command
+* @param  uint32_t data result to send back
+* @retval tBleStatus Status
+*/
+tBleStatus Config_Update_32(uint32_t Feature,uint8_t Command,uint32_t data)
+{
+  uint8_t buff[2+4+1+4];
+  
+  STORE_LE_16(buff  ,(HAL_GetTick()>>3));
+  STORE_BE_32(buff+2,Feature);
+  buff[6] = Command;
+  buff[7]  = (uint8_t)((data       ) & 0xFFU);
+  buff[8]  = (uint8_t)((data >>  8U) & 0xFFU);
+  buff[9]  = (uint8_t)((data >> 16U) & 0xFFU);
+  buff[10] = (uint8_t)((data >> 24U) & 0xFFU);
+  
+  if (ACI_GATT_UPDATE_CHAR_VALUE(&BleCharConfig, 0, 11 , buff) != (tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: Updating Configuration Char\r\n");
+    return BLE_STATUS_ERROR;
+  } 
+  return BLE_STATUS_SUCCESS;
+}
+
+/**
+* @brief  Puts the device in connectable mode.
+* @param  None
+* @retval None
+*/
+#if (BLUE_CORE != BLUENRG_LP)
+void updateAdvData()
+{
+  /* Filling Manufacter Advertise data */
+  manuf_data[0 ] = 8U;
+  manuf_data[1 ] = 0x09U;
+  manuf_data[2 ] = (uint8_t)BLE_StackValue.BoardName[0];/* Complete Name */
+  manuf_data[3 ] = (uint8_t)BLE_StackValue.BoardName[1];
+  manuf_data[4 ] = (uint8_t)BLE_StackValue.BoardName[2];
+  manuf_data[5 ] = (uint8_t)BLE_StackValue.BoardName[3];
+  manuf_data[6 ] = (uint8_t)BLE_StackValue.BoardName[4];
+  manuf_data[7 ] = (uint8_t)BLE_StackValue.BoardName[5];
+  manuf_data[8 ] = (uint8_t)BLE_StackValue.BoardName[6];           
+  manuf_data[9 ] = 15U;
+  manuf_data[10] = 0xFFU;
+  manuf_data[11] = 0x30U;/* STM Manufacter AD */
+  manuf_data[12] = 0x00U;
+#ifdef BLE_MANAGER_SDKV2
+  manuf_data[13] = 0x02U;
+#else /* BLE_MANAGER_SDKV2 */
+  manuf_data[13] = 0x01U;
+#endif /* BLE_MANAGER_SDKV2 */
+  manuf_data[14] = BLE_MANAGER_USED_PLATFORM; /* BoardType */
+  manuf_data[15] = 0x00U;
+  manuf_data[16] = 0x00U;
+  manuf_data[17] = 0x00U;
+  manuf_data[18] = 0x00U;
+  manuf_data[19] = BLE_StackValue.BleMacAddress[5]; /* BLE MAC start */
+  manuf_data[20] = BLE_StackValue.BleMacAddress[4];
+  manuf_data[21] = BLE_StackValue.BleMacAddress[3];
+  manuf_data[22] = BLE_StackValue.BleMacAddress[2];
+  manuf_data[23] = BLE_StackValue.BleMacAddress[1];
+  manuf_data[24] = BLE_StackValue.BleMacAddress[0]; /* BLE MAC stop */
+  
+  /* Set the Custom BLE Advertise Data */
+  BLE_SetCustomAdvertiseData(manuf_data);
+  
+  if(CustomSetConnectable!=NULL){
+    CustomSetConnectable(manuf_data);
+  }
+  
+  /* Send Advertising data */
+  tBleStatus RetStatus = aci_gap_update_adv_data(BLE_MANAGER_ADVERTISE_DATA_LENGHT, manuf_data);
+  if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: aci_gap_update_adv_data [%x]\r\n",RetStatus);
+  } else {
+    BLE_MANAGER_PRINTF("aci_gap_update_adv_data OK\r\n");
+  } 
+}
+
+void setConnectable(void)
+{
+#if (BLUE_CORE == BLUENRG_MS)
+  char local_name[8] = {AD_TYPE_COMPLETE_LOCAL_NAME,
+#else /* (BLUE_CORE == BLUENRG_MS) */
+  uint8_t local_name[8] = {AD_TYPE_COMPLETE_LOCAL_NAME,
+#endif /* (BLUE_CORE == BLUENRG_MS) */
+  BLE_StackValue.BoardName[0],
+  BLE_StackValue.BoardName[1],
+  BLE_StackValue.BoardName[2],
+  BLE_StackValue.BoardName[3],
+  BLE_StackValue.BoardName[4],
+  BLE_StackValue.BoardName[5],
+  BLE_StackValue.BoardName[6]};
+  tBleStatus RetStatus= BLE_STATUS_SUCCESS; 
+  uint16_t AdvIntervalMin = BLE_StackValue.AdvIntervalMin;
+  uint16_t AdvIntervalMax = BLE_StackValue.AdvIntervalMax;
+  uint8_t AdvertisingFilter = BLE_StackValue.AdvertisingFilter;
+  
+#ifdef BLE_MANAGER_FAST_BOOT
+  BLE_BootMark(BLE_BOOT_PHASE_MAIN_LOOP);
+#endif /* BLE_MANAGER_FAST_BOOT */
+  
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  /* Intervals of the current step of the advertising schedule */
+  BLE_AdvertisingSchedule(&AdvIntervalMin,&AdvIntervalMax);
+  
+#ifdef BLE_MANAGER_ADV_DIRECTED
+  if(BleAdvSchedule.Step==BLE_ADV_STEP_DIRECTED) {
+    RetStatus = aci_gap_set_direct_connectable(BLE_StackValue.OwnAddressType, HIGH_DUTY_CYCLE_DIRECTED_ADV,
+                                               BleAdvSchedule.PeerAddressType, BleAdvSchedule.PeerAddress,
+                                               AdvIntervalMin, AdvIntervalMax);
+    if(RetStatus == (tBleStatus)BLE_STATUS_SUCCESS) {
+#if (BLE_DEBUG_LEVEL>1)
+      BLE_MANAGER_PRINTF("aci_gap_set_direct_connectable OK\r\n");
+#endif
+      goto EndLabel;
+    }
+    
+    /* Continue with the undirected advertising */
+    BLE_MANAGER_PRINTF("Error: aci_gap_set_direct_connectable [%x]\r\n",RetStatus);
+    BleAdvSchedule.Step = BLE_AdvertisingUndirectedStep();
+    BLE_AdvertisingIntervals(BleAdvSchedule.Step,&AdvIntervalMin,&AdvIntervalMax);
+  }
+#endif /* BLE_MANAGER_ADV_DIRECTED */
+  
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  if(BleAdvSchedule.Step==BLE_ADV_STEP_RECONNECT) {
+    /* Only the bonded centrals in the white list could connect */
+    AdvertisingFilter = WHITE_LIST_FOR_ALL;
+  }
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+  
+  /* disable scan response */
+  RetStatus = hci_le_set_scan_response_data(0U,NULL);
+  if(RetStatus !=(tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: hci_le_set_scan_response_data [%x]\r\n",RetStatus);
+    goto EndLabel;
+  }
+  
+  /* Set the board discoverable */
+  if(AdvertisingFilter == ((uint8_t)NO_WHITE_LIST_USE)) {
+    RetStatus = aci_gap_set_discoverable(ADV_IND, AdvIntervalMin, AdvIntervalMax,
+                                         BLE_StackValue.OwnAddressType,
+                                         AdvertisingFilter,
+                                         (uint8_t)(sizeof(local_name)), local_name, 0, NULL, 0, 0);
+    if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
+      BLE_MANAGER_PRINTF("Error: aci_gap_set_discoverable [%x] Filter=%x\r\n",RetStatus,AdvertisingFilter);
+      goto EndLabel;
+    } else {
+#if (BLE_DEBUG_LEVEL>1)
+      BLE_MANAGER_PRINTF("aci_gap_set_discoverable OK Filter=%x\r\n",AdvertisingFilter);
+#endif
+    }
+  } else {
+    /* Advertising filter is enabled: enter in undirected connectable mode in order to use the advertising filter on bonded device */
+#if (BLUE_CORE == BLUENRG_MS)
+	RetStatus = aci_gap_set_undirected_connectable(BLE_StackValue.OwnAddressType, AdvertisingFilter);
+#elif defined(BLE_MANAGER_ADAPTIVE_ADVERTISING)
+    RetStatus = aci_gap_set_undirected_connectable(AdvIntervalMin,AdvIntervalMax,BLE_StackValue.OwnAddressType, AdvertisingFilter);
+#else /* (BLUE_CORE == BLUENRG_MS) */
+    RetStatus = aci_gap_set_undirected_connectable(0,0,BLE_StackValue.OwnAddressType, AdvertisingFilter);
+#endif /* (BLUE_CORE == BLUENRG_MS) */
+    if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
+      BLE_MANAGER_PRINTF("Error: aci_gap_set_undirected_connectable [%x] Filter=%x\r\n",RetStatus,AdvertisingFilter);
+      goto EndLabel;
+    } else {
+#if (BLE_DEBUG_LEVEL>1)
+      BLE_MANAGER_PRINTF("aci_gap_set_undirected_connectable OK Filter=%x\r\n",AdvertisingFilter);
+#endif
+    }
+  }
+  
+  updateAdvData();
+  
+EndLabel:
+#ifdef BLE_MANAGER_FAST_BOOT
+  if(BleBootReport.PhasesDone==((uint8_t)BLE_BOOT_PHASE_ADVERTISING)) {
+    /* First advertising after InitBleManager */
+    BLE_BootMark(BLE_BOOT_PHASE_ADVERTISING);
+    BLE_BootPrint();
+  }
+#endif /* BLE_MANAGER_FAST_BOOT */
+  return;
+}
+#else /* (BLUE_CORE != BLUENRG_LP) */
+void setConnectable(void)
+{
+  tBleStatus ret;
+  Advertising_Set_Parameters_t Advertising_Set_Parameters[1];
+
+  manuf_data[0 ]=0x02;
+  manuf_data[1 ]=AD_TYPE_FLAGS;
+  manuf_data[2 ]=FLAG_BIT_LE_GENERAL_DISCOVERABLE_MODE|FLAG_BIT_BR_EDR_NOT_SUPPORTED;
+  manuf_data[3 ]=8;
+  manuf_data[4 ]=0x09;
+  manuf_data[5 ]=BLE_StackValue.BoardName[0];/* Complete Name */
+  manuf_data[6 ]=BLE_StackValue.BoardName[1];
+  manuf_data[7 ]=BLE_StackValue.BoardName[2];
+  manuf_data[8 ]=BLE_StackValue.BoardName[3];
+  manuf_data[9 ]=BLE_StackValue.BoardName[4];
+  manuf_data[10]=BLE_StackValue.BoardName[5];
+  manuf_data[11]=BLE_StackValue.BoardName[6];
+  manuf_data[12]=15;
+  manuf_data[13]=0xFF;
+  manuf_data[14]=0x30;
+  manuf_data[15]=0x00; /* STM Manufacter AD */
+  manuf_data[16]=0x02;  /* SDK version */
+  manuf_data[17]=BLE_MANAGER_USED_PLATFORM; /* BoardType*/
+  manuf_data[18]=0x00; /* Fw ID*/
+  manuf_data[19]=0x00; /* Second Custom Byte -> Not Used */
+  manuf_data[20]=0x00; /* Third  Custom Byte -> Not Used */
+  manuf_data[21]=0x00; /* Fourth Custom Byte -> Not Used */
+  manuf_data[22]=BLE_StackValue.BleMacAddress[5]; /* BLE MAC start - MSB first - */
+  manuf_data[23]=BLE_StackValue.BleMacAddress[4];
+  manuf_data[24]=BLE_StackValue.BleMacAddress[3];
+  manuf_data[25]=BLE_StackValue.BleMacAddress[2];
+  manuf_data[26]=BLE_StackValue.BleMacAddress[1];
+  manuf_data[27]=BLE_StackValue.BleMacAddress[0];  /* BLE MAC stop */
+
+  /* Set the Custom BLE Advertise Data */
+  BLE_SetCustomAdvertiseData(manuf_data);
+
+  if(CustomSetConnectable!=NULL){
+    CustomSetConnectable(manuf_data);
+  }
+
+  ret = aci_gap_set_advertising_configuration(0, GAP_MODE_GENERAL_DISCOVERABLE,
+                                              ADV_PROP_CONNECTABLE | ADV_PROP_SCANNABLE | ADV_PROP_LEGACY,
+                                              ADV_INTERV_MIN,
+                                              ADV_INTERV_MAX,
+                                              ADV_CH_ALL,
+                                              STATIC_RANDOM_ADDR, NULL,
+                                              ADV_NO_WHITE_LIST_USE,
+                                              0, /* 0 dBm */
+                                              LE_1M_PHY, /* Primary advertising PHY */
+                                              0, /* 0 skips */
+                                              LE_1M_PHY, /* Secondary advertising PHY. Not used with legacy advertising. */
+                                              0, /* SID */
+                                              0 /* No scan request notifications */);
+
+  if(ret != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("aci_gap_set_advertising_configuration failed: 0x%02x\r\n", ret);
+    goto EndLabel;
+  } else {
+    BLE_MANAGER_PRINTF("aci_gap_set_advertising_configuration\r\n");
+  }
+
+  ret = aci_gap_set_advertising_data_nwk(0, ADV_COMPLETE_DATA, BLE_MANAGER_ADVERTISE_DATA_LENGHT, manuf_data);
+  if(ret != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("aci_gap_set_advertising_data_nwk failed: 0x%02x\r\n", ret);
+    goto EndLabel;
+  } else {
+    BLE_MANAGER_PRINTF("aci_gap_set_advertising_data_nwk\r\n");
+  }
+
+  Advertising_Set_Parameters[0].Advertising_Handle = 0;
+  Advertising_Set_Parameters[0].Duration = 0;
+  Advertising_Set_Parameters[0].Max_Extended_Advertising_Events = 0;
+
+  /* enable advertising */
+  ret = aci_gap_set_advertising_enable(ENABLE, 1, Advertising_Set_Parameters);
+  if(ret != BLE_STATUS_SUCCESS)
+  {
+    BLE_MANAGER_PRINTF("aci_gap_set_advertising_enable failed: 0x%02x\r\n",ret);
+  } else {
+    BLE_MANAGER_PRINTF("aci_gap_set_advertising_enable\r\n");
+  }
+  
+EndLabel:
+  return;
+}
+#endif /* (BLUE_CORE != BLUENRG_LP) */
+
+#if (BLUE_CORE != BLUENRG_LP)
+/**
+* @brief  Exits the device from connectable mode.
+* @param  None
+* @retval None
+*/
+void setNotConnectable(void)
+{
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  BLE_AdvertisingStop();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+  aci_gap_set_non_discoverable();
+}
+#endif /* (BLUE_CORE != BLUENRG_LP) */
+
+#if (BLUE_CORE != BLUENRG_MS)
+/**
+* @brief  Request new connection parameters to the central
+* @param  int min minimum connection interval (1.25 ms units)
+* @param  int max maximum connection interval (1.25 ms units)
+* @param  int latency slave latency (connection events)
+* @param  int timeout supervision timeout (10 ms units)
+* @retval None
+*/
+void setConnectionParameters(int min , int max, int latency , int timeout )
+{
+  tBleStatus RetStatus;
+  
+  if(connection_handle==0U) {
+    /* No Device Connected */
+    return;
+  }
+  
+  RetStatus = aci_l2cap_connection_parameter_update_req(connection_handle,(uint16_t)min,(uint16_t)max,(uint16_t)latency,(uint16_t)timeout);
+  if(RetStatus != (tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: aci_l2cap_connection_parameter_update_req [%x]\r\n",RetStatus);
+  }
+}
+#endif /* (BLUE_CORE != BLUENRG_MS) */
+
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+/**
+* @brief  Advertising intervals of one step of the advertising schedule
+* @param  BLE_AdvStepType Step step of the schedule
+* @param  uint16_t *AdvIntervalMin minimum interval (0.625 ms units)
+* @param  uint16_t *AdvIntervalMax maximum interval (0.625 ms units)
+* @retval None
+*/
+static void BLE_AdvertisingIntervals(BLE_AdvStepType Step,uint16_t *AdvIntervalMin,uint16_t *AdvIntervalMax)
+{
+  switch(Step) {
+#ifdef BLE_MANAGER_FAST_RECONNECT
+    case BLE_ADV_STEP_RECONNECT:
+      *AdvIntervalMin = BLE_ADV_RECONNECT_INTERVAL_MIN;
+      *AdvIntervalMax = BLE_ADV_RECONNECT_INTERVAL_MAX;
+      break;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+    case BLE_ADV_STEP_MEDIUM:
+      *AdvIntervalMin = BLE_ADV_MEDIUM_INTERVAL_MIN;
+      *AdvIntervalMax = BLE_ADV_MEDIUM_INTERVAL_MAX;
+      break;
+    case BLE_ADV_STEP_SLOW:
+      *AdvIntervalMin = BLE_ADV_SLOW_INTERVAL_MIN;
+      *AdvIntervalMax = BLE_ADV_SLOW_INTERVAL_MAX;
+      break;
+    default:
+      /* Fast advertising (the intervals are not used by the high duty cycle directed advertising) */
+      *AdvIntervalMin = BLE_StackValue.AdvIntervalMin;
+      *AdvIntervalMax = BLE_StackValue.AdvIntervalMax;
+      break;
+  }
+}
+
+/**
+* @brief  Account the time elapsed from the previous call to the advertising metrics
+* @param  None
+* @retval None
+*/
+static void BLE_AdvertisingAccount(void)
+{
+  uint32_t Now = BLE_MANAGER_ADV_TICK();
+  uint32_t Elapsed = Now - BleAdvSchedule.LastAccountTick;
+  
+  BleAdvSchedule.LastAccountTick = Now;
+  BleAdvSchedule.Stats.ObservedTime += Elapsed;
+  
+  if(BleAdvSchedule.Advertising) {
+    uint32_t EventPeriod;
+    
+    BleAdvSchedule.Stats.AdvertisingTime += Elapsed;
+    
+    /* Estimation of the advertising events with the mean interval (us) */
+    if(BleAdvSchedule.Step==BLE_ADV_STEP_DIRECTED) {
+      /* High duty cycle directed advertising: one event every 3.75 ms at most */
+      EventPeriod = 3750U;
+    } else {
+      uint16_t AdvIntervalMin;
+      uint16_t AdvIntervalMax;
+      
+      BLE_AdvertisingIntervals(BleAdvSchedule.Step,&AdvIntervalMin,&AdvIntervalMax);
+      /* 625 us for each interval unit + 5 ms of mean advDelay */
+      EventPeriod = ((((uint32_t)AdvIntervalMin + (uint32_t)AdvIntervalMax) * 625U) / 2U) + 5000U;
+    }
+    BleAdvSchedule.Stats.AdvertisingEvents += (uint32_t)(((uint64_t)Elapsed * 1000U) / EventPeriod);
+  }
+}
+
+/**
+* @brief  Restart the advertising schedule from its first step
+* @param  None
+* @retval None
+*/
+static void BLE_AdvertisingReset(void)
+{
+#ifdef BLE_MANAGER_ADV_DIRECTED
+  BleAdvSchedule.Step = (BleAdvSchedule.BondedPeerValid!=0U) ? BLE_ADV_STEP_DIRECTED : BLE_AdvertisingUndirectedStep();
+#else /* BLE_MANAGER_ADV_DIRECTED */
+  BleAdvSchedule.Step = BLE_AdvertisingUndirectedStep();
+#endif /* BLE_MANAGER_ADV_DIRECTED */
+}
+
+/**
+* @brief  First undirected step of the advertising schedule
+* @param  None
+* @retval BLE_AdvStepType step
+*/
+static BLE_AdvStepType BLE_AdvertisingUndirectedStep(void)
+{
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  if(BleReconnectCache.PeersNumber!=0U) {
+    return BLE_ADV_STEP_RECONNECT;
+  }
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+  return BLE_ADV_STEP_FAST;
+}
+
+/**
+* @brief  Use the central of the current connection as target of the directed advertising
+* @param  None
+* @retval None
+*/
+static void BLE_AdvertisingSetBondedPeer(void)
+{
+  uint8_t PeerAddressType = BleAdvSchedule.ConnectedPeerAddressType;
+  uint8_t PeerAddress[6];
+  
+  BLE_MemCpy(PeerAddress,BleAdvSchedule.ConnectedPeerAddress,6);
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  /* The cache and the directed advertising use the identity address, not the private address of this connection */
+  if(BLE_ReconnectIdentityAddress(&PeerAddressType,PeerAddress)==0U) {
+    return;
+  }
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+  
+  BleAdvSchedule.BondedPeerValid = 1U;
+  BleAdvSchedule.PeerAddressType = PeerAddressType;
+  BLE_MemCpy(BleAdvSchedule.PeerAddress,PeerAddress,6);
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  BLE_ReconnectCacheTouch(PeerAddressType,PeerAddress);
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+}
+
+/**
+* @brief  Start the advertising with the current step of the schedule (called by setConnectable)
+* @param  uint16_t *AdvIntervalMin filled with the minimum interval (0.625 ms units)
+* @param  uint16_t *AdvIntervalMax filled with the maximum interval (0.625 ms units)
+* @retval None
+*/
+static void BLE_AdvertisingSchedule(uint16_t *AdvIntervalMin,uint16_t *AdvIntervalMax)
+{
+  BLE_AdvertisingAccount();
+  
+  BleAdvSchedule.Advertising = 1U;
+  BleAdvSchedule.StepStartTick = BleAdvSchedule.LastAccountTick;
+  
+  /* The time to connect is measured from the first advertising after boot/disconnection */
+  if(BleAdvSchedule.WaitingConnection==0U) {
+    BleAdvSchedule.WaitingConnection = 1U;
+    BleAdvSchedule.WaitingStartTick = BleAdvSchedule.LastAccountTick;
+  }
+  
+  BLE_AdvertisingIntervals(BleAdvSchedule.Step,AdvIntervalMin,AdvIntervalMax);
+  
+#if (BLE_DEBUG_LEVEL>1)
+  BLE_MANAGER_PRINTF("Advertising step %s\r\n",BleAdvStepNames[BleAdvSchedule.Step]);
+#endif
+}
+
+/**
+* @brief  Account the end of the advertising
+* @param  None
+* @retval None
+*/
+static void BLE_AdvertisingStop(void)
+{
+  BLE_AdvertisingAccount();
+  BleAdvSchedule.Advertising = 0U;
+}
+
+/**
+* @brief  Read the end of the current step of the advertising schedule
+*         (for waking up from low power modes in time)
+* @param  uint32_t *Deadline filled with the end of the step (BLE_MANAGER_ADV_TICK units)
+* @retval uint8_t 1 if the current step has a deadline, 0 otherwise
+*/
+uint8_t BLE_AdvertisingGetDeadline(uint32_t *Deadline)
+{
+  if(BleAdvSchedule.RestartFastRequest) {
+    *Deadline = BLE_MANAGER_ADV_TICK();
+    return 1U;
+  }
+  
+  if(BleAdvSchedule.Advertising==0U) {
+    return 0U;
+  }
+  
+  /* The directed advertising is stopped by the controller and the slow one lasts until the connection */
+  switch(BleAdvSchedule.Step) {
+#ifdef BLE_MANAGER_FAST_RECONNECT
+    case BLE_ADV_STEP_RECONNECT:
+      *Deadline = BleAdvSchedule.StepStartTick + BLE_ADV_RECONNECT_DURATION;
+      return 1U;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+    case BLE_ADV_STEP_FAST:
+      *Deadline = BleAdvSchedule.StepStartTick + BLE_ADV_FAST_DURATION;
+      return 1U;
+    case BLE_ADV_STEP_MEDIUM:
+      *Deadline = BleAdvSchedule.StepStartTick + BLE_ADV_MEDIUM_DURATION;
+      return 1U;
+    default:
+      return 0U;
+  }
+}
+
+/**
+* @brief  Move to the next step of the advertising schedule when the current one is expired
+*         (to call periodically from the main loop)
+* @param  None
+* @retval None
+*/
+void BLE_AdvertisingProcess(void)
+{
+  uint32_t Deadline;
+  
+  if(BleAdvSchedule.RestartFastRequest) {
+    BleAdvSchedule.RestartFastRequest = 0U;
+    /* Nothing to do if the device is connected or not connectable */
+    if(BleAdvSchedule.Advertising) {
+      setNotConnectable();
+      BLE_AdvertisingReset();
+      setConnectable();
+    }
+    return;
+  }
+  
+  if(BLE_AdvertisingGetDeadline(&Deadline)) {
+    if(((int32_t)(BLE_MANAGER_ADV_TICK() - Deadline)) >= 0) {
+      /* Back-off to the next step */
+      setNotConnectable();
+      BleAdvSchedule.Step = (BLE_AdvStepType)((uint32_t)BleAdvSchedule.Step + 1U);
+      setConnectable();
+    }
+  }
+}
+
+/**
+* @brief  Restart the advertising schedule from the fast advertising (e.g. on button press).
+*         It could be called from interrupt: the restart is done by BLE_AdvertisingProcess
+* @param  None
+* @retval None
+*/
+void BLE_AdvertisingRestartFast(void)
+{
+  BleAdvSchedule.RestartFastRequest = 1U;
+}
+
+/**
+* @brief  Read the advertising metrics
+* @param  BLE_AdvStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_AdvertisingGetStats(BLE_AdvStats_t *Stats)
+{
+  BLE_AdvertisingAccount();
+  BleAdvSchedule.Stats.Step = BleAdvSchedule.Step;
+  *Stats = BleAdvSchedule.Stats;
+}
+
+/**
+* @brief  Reset the advertising metrics
+* @param  None
+* @retval None
+*/
+void BLE_AdvertisingResetStats(void)
+{
+  memset(&BleAdvSchedule.Stats,0,sizeof(BLE_AdvStats_t));
+  BleAdvSchedule.SumTimeToConnect = 0U;
+  BleAdvSchedule.LastAccountTick = BLE_MANAGER_ADV_TICK();
+}
+
+/**
+* @brief  Write the advertising metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendAdvertisingStats(void)
+{
+  BLE_AdvStats_t Stats;
+  uint32_t DutyCycle = 0U;
+  
+  BLE_AdvertisingGetStats(&Stats);
+  if(Stats.ObservedTime!=0U) {
+    /* Per mille of the observed time spent advertising */
+    DutyCycle = (uint32_t)(((uint64_t)Stats.AdvertisingTime * 1000U) / Stats.ObservedTime);
+  }
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Adv %s duty=%lu.%lu%% evt=%lu\r\n",
+                                 BleAdvStepNames[Stats.Step],
+                                 (unsigned long)(DutyCycle/10U),
+                                 (unsigned long)(DutyCycle%10U),
+                                 (unsigned long)Stats.AdvertisingEvents);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  /* Add a Delay respect previous line */
+  BLE_MANAGER_DELAY(20);
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Conn=%lu ttc last=%lu avg=%lu max=%lu ms\r\n",
+                                 (unsigned long)Stats.Connections,
+                                 (unsigned long)Stats.LastTimeToConnect,
+                                 (unsigned long)Stats.AvgTimeToConnect,
+                                 (unsigned long)Stats.MaxTimeToConnect);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  if(BleReconnectCache.PeersNumber!=0U) {
+    BLE_BondedPeer_t *Peer = &BleReconnectCache.Peers[0];
+    
+    /* Add a Delay respect previous line */
+    BLE_MANAGER_DELAY(20);
+    BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Bonded=%u last=%02x:%02x:%02x:%02x:%02x:%02x\r\n",
+                                   BleReconnectCache.PeersNumber,
+                                   Peer->Address[5],Peer->Address[4],Peer->Address[3],
+                                   Peer->Address[2],Peer->Address[1],Peer->Address[0]);
+    Term_Update(BufferToWrite,BytesToWrite);
+  }
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+}
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+#ifdef BLE_MANAGER_FAST_RECONNECT
+/**
+* @brief  Load the reconnect cache and align it and the controller white and resolving lists
+*         with the bonded devices (called by InitBleManager)
+* @param  None
+* @retval None
+*/
+static void BLE_ReconnectInit(void)
+{
+  memset(&BleReconnectCache,0,sizeof(BLE_ReconnectCache_t));
+  /* The controller lists are empty after its reset */
+  BleReconnectListedNumber = 0U;
+  
+  if(CustomReconnectCacheLoad!=NULL) {
+    if((CustomReconnectCacheLoad(&BleReconnectCache)==0U) ||
+       (BleReconnectCache.PeersNumber>((uint8_t)BLE_RECONNECT_CACHE_SIZE))) {
+      memset(&BleReconnectCache,0,sizeof(BLE_ReconnectCache_t));
+    }
+  }
+  
+  BLE_ReconnectRefresh();
+  
+  /* The last central is the target of the directed advertising */
+  BleAdvSchedule.BondedPeerValid = (BleReconnectCache.PeersNumber!=0U) ? 1U : 0U;
+  if(BleAdvSchedule.BondedPeerValid) {
+    BleAdvSchedule.PeerAddressType = BleReconnectCache.Peers[0].AddressType;
+    BLE_MemCpy(BleAdvSchedule.PeerAddress,BleReconnectCache.Peers[0].Address,6);
+  }
+  BLE_AdvertisingReset();
+}
+
+/**
+* @brief  Align the reconnect cache with the bonded devices and write the controller
+*         white and resolving lists when the bonded devices are changed
+* @param  None
+* @retval None
+*/
+static void BLE_ReconnectRefresh(void)
+{
+  tBleStatus RetStatus;
+  uint8_t NumOfAddresses = 0;
+  Bonded_Device_Entry_t BondedDeviceEntry[BLE_MANAGER_MAX_BONDED_DEVICES];
+  Whitelist_Identity_Entry_t IdentityEntry[BLE_MANAGER_MAX_BONDED_DEVICES];
+  uint8_t Changed = 0U;
+  uint32_t Index;
+  
+  RetStatus = aci_gap_get_bonded_devices(&NumOfAddresses, BondedDeviceEntry);
+  if(RetStatus != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: aci_gap_get_bonded_devices() failed:0x%02x\r\n", RetStatus);
+    return;
+  }
+  if(NumOfAddresses > ((uint8_t)BLE_MANAGER_MAX_BONDED_DEVICES)) {
+    NumOfAddresses = (uint8_t)BLE_MANAGER_MAX_BONDED_DEVICES;
+  }
+  
+  /* Remove the cached centrals that are not bonded anymore */
+  Index = 0;
+  while(Index<((uint32_t)BleReconnectCache.PeersNumber)) {
+    if(BLE_ReconnectIsBonded(&BleReconnectCache.Peers[Index],BondedDeviceEntry,NumOfAddresses)) {
+      Index++;
+    } else {
+      BleReconnectCache.PeersNumber--;
+      memmove(&BleReconnectCache.Peers[Index],&BleReconnectCache.Peers[Index+1U],
+              (BleReconnectCache.PeersNumber - Index) * sizeof(BLE_BondedPeer_t));
+      Changed = 1U;
+    }
+  }
+  
+  /* Append the bonded devices that are not cached */
+  for(Index=0; Index<((uint32_t)NumOfAddresses); Index++) {
+    uint32_t Peer;
+    
+    for(Peer=0; Peer<((uint32_t)BleReconnectCache.PeersNumber); Peer++) {
+      if((BleReconnectCache.Peers[Peer].AddressType==BondedDeviceEntry[Index].Address_Type) &&
+         (memcmp(BleReconnectCache.Peers[Peer].Address,BondedDeviceEntry[Index].Address,6)==0)) {
+        break;
+      }
+    }
+    if((Peer==((uint32_t)BleReconnectCache.PeersNumber)) && (Peer<BLE_RECONNECT_CACHE_SIZE)) {
+      BleReconnectCache.Peers[Peer].AddressType = BondedDeviceEntry[Index].Address_Type;
+      BLE_MemCpy(BleReconnectCache.Peers[Peer].Address,BondedDeviceEntry[Index].Address,6);
+      BleReconnectCache.PeersNumber++;
+      Changed = 1U;
+    }
+  }
+  
+  if(Changed) {
+    BLE_ReconnectCacheSave();
+  }
+  
+  /* Nothing to write if the bonded devices are the same already in the controller lists */
+  if((NumOfAddresses==BleReconnectListedNumber) &&
+     (memcmp(BondedDeviceEntry,BleReconnectListed,NumOfAddresses*sizeof(Bonded_Device_Entry_t))==0)) {
+    return;
+  }
+  
+  if(NumOfAddresses==0U) {
+    RetStatus = hci_le_clear_white_list();
+  } else {
+    RetStatus = aci_gap_configure_whitelist();
+  }
+  if (RetStatus != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: aci_gap_configure_whitelist() failed:0x%02x\r\n", RetStatus);
+  }
+  
+  /* The resolving list can be written only with the address resolution disabled */
+  (void)hci_le_set_address_resolution_enable(0x00);
+  
+  if(NumOfAddresses!=0U) {
+    /* The controller resolves the private addresses of the bonded centrals with the IRKs of the security database */
+    for(Index=0; Index<((uint32_t)NumOfAddresses); Index++) {
+      IdentityEntry[Index].Peer_Identity_Address_Type = BondedDeviceEntry[Index].Address_Type;
+      BLE_MemCpy(IdentityEntry[Index].Peer_Identity_Address,BondedDeviceEntry[Index].Address,6);
+    }
+    RetStatus = aci_gap_add_devices_to_resolving_list(NumOfAddresses,IdentityEntry,1);
+    if (RetStatus != BLE_STATUS_SUCCESS) {
+      BLE_MANAGER_PRINTF("Error: aci_gap_add_devices_to_resolving_list() failed:0x%02x\r\n", RetStatus);
+    }
+    
+    /* Without it the white list filter of the RECONNECT step rejects the centrals with a resolvable private address */
+    RetStatus = hci_le_set_address_resolution_enable(0x01);
+    if (RetStatus != BLE_STATUS_SUCCESS) {
+      BLE_MANAGER_PRINTF("Error: hci_le_set_address_resolution_enable() failed:0x%02x\r\n", RetStatus);
+    }
+  }
+  
+  BleReconnectListedNumber = NumOfAddresses;
+  BLE_MemCpy(BleReconnectListed,BondedDeviceEntry,NumOfAddresses*sizeof(Bonded_Device_Entry_t));
+  
+#if (BLE_DEBUG_LEVEL>2)
+  BLE_MANAGER_PRINTF("White/resolving lists with %d Device(s)\r\n", NumOfAddresses);
+#endif
+}
+
+/**
+* @brief  Replace the address of one connected central with its identity address of the bonded devices list
+* @param  uint8_t *AddressType address type of the central (replaced with the identity address type)
+* @param  uint8_t Address[6] address of the central (replaced with the identity address)
+* @retval uint8_t 1 if the central is bonded, 0 otherwise
+*/
+static uint8_t BLE_ReconnectIdentityAddress(uint8_t *AddressType, uint8_t Address[6])
+{
+  tBleStatus RetStatus;
+  uint8_t NumOfAddresses = 0;
+  Bonded_Device_Entry_t BondedDeviceEntry[BLE_MANAGER_MAX_BONDED_DEVICES];
+  uint8_t Identity[6];
+  uint8_t Resolved = 0U;
+  uint32_t Index;
+  
+  RetStatus = aci_gap_get_bonded_devices(&NumOfAddresses, BondedDeviceEntry);
+  if(RetStatus != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: aci_gap_get_bonded_devices() failed:0x%02x\r\n", RetStatus);
+    return 0;
+  }
+  if(NumOfAddresses > ((uint8_t)BLE_MANAGER_MAX_BONDED_DEVICES)) {
+    NumOfAddresses = (uint8_t)BLE_MANAGER_MAX_BONDED_DEVICES;
+  }
+  
+  BLE_MemCpy(Identity,Address,6);
+  /* Resolvable private address: random with the two most significant bits 01 */
+  if((((*AddressType) & 0x01U)!=0U) && ((Address[5] & 0xC0U)==0x40U)) {
+    if(aci_gap_resolve_private_addr(Address,Identity)==(tBleStatus)BLE_STATUS_SUCCESS) {
+      Resolved = 1U;
+    }
+  }
+  
+  for(Index=0; Index<((uint32_t)NumOfAddresses); Index++) {
+    if(((Resolved!=0U) || (BondedDeviceEntry[Index].Address_Type==(*AddressType))) &&
+       (memcmp(BondedDeviceEntry[Index].Address,Identity,6)==0)) {
+      *AddressType = BondedDeviceEntry[Index].Address_Type;
+      BLE_MemCpy(Address,Identity,6);
+      return 1;
+    }
+  }
+  
+  return 0;
+}
+
+/**
+* @brief  Move one central at the head of the reconnect cache (adding it if it is not cached)
+* @param  uint8_t AddressType address type of the central
+* @param  uint8_t Address[6] address of the central
+* @retval None
+*/
+static void BLE_ReconnectCacheTouch(uint8_t AddressType, uint8_t Address[6])
+{
+  uint32_t Index;
+  
+  for(Index=0; Index<((uint32_t)BleReconnectCache.PeersNumber); Index++) {
+    if((BleReconnectCache.Peers[Index].AddressType==AddressType) &&
+       (memcmp(BleReconnectCache.Peers[Index].Address,Address,6)==0)) {
+      break;
+    }
+  }
+  
+  if(Index==0U) {
+    if(BleReconnectCache.PeersNumber!=0U) {
+      /* Already the most recent one */
+      return;
+    }
+    BleReconnectCache.PeersNumber = 1U;
+  } else if(Index==((uint32_t)BleReconnectCache.PeersNumber)) {
+    if(BleReconnectCache.PeersNumber<((uint8_t)BLE_RECONNECT_CACHE_SIZE)) {
+      BleReconnectCache.PeersNumber++;
+    } else {
+      /* The least recently connected central is dropped */
+      Index--;
+    }
+  }
+  
+  memmove(&BleReconnectCache.Peers[1],&BleReconnectCache.Peers[0],Index * sizeof(BLE_BondedPeer_t));
+  BleReconnectCache.Peers[0].AddressType = AddressType;
+  BLE_MemCpy(BleReconnectCache.Peers[0].Address,Address,6);
+  
+  BLE_ReconnectCacheSave();
+}
+
+/**
+* @brief  Give the reconnect cache to the application for saving it
+* @param  None
+* @retval None
+*/
+static void BLE_ReconnectCacheSave(void)
+{
+  if(CustomReconnectCacheSave!=NULL) {
+    CustomReconnectCacheSave(&BleReconnectCache);
+  }
+}
+
+/**
+* @brief  Check if one cached central is in the bonded devices list
+* @param  BLE_BondedPeer_t *Peer cached central
+* @param  Bonded_Device_Entry_t *BondedDeviceEntry bonded devices
+* @param  uint8_t NumOfAddresses number of bonded devices
+* @retval uint8_t 1 if the central is bonded, 0 otherwise
+*/
+static uint8_t BLE_ReconnectIsBonded(BLE_BondedPeer_t *Peer, Bonded_Device_Entry_t *BondedDeviceEntry, uint8_t NumOfAddresses)
+{
+  uint32_t Index;
+  
+  for(Index=0; Index<((uint32_t)NumOfAddresses); Index++) {
+    if((Peer->AddressType==BondedDeviceEntry[Index].Address_Type) &&
+       (memcmp(Peer->Address,BondedDeviceEntry[Index].Address,6)==0)) {
+      return 1U;
+    }
+  }
+  return 0U;
+}
+
+/**
+* @brief  Read the reconnect cache
+* @param  BLE_ReconnectCache_t *Cache filled with the cache
+* @retval None
+*/
+void BLE_ReconnectGetCache(BLE_ReconnectCache_t *Cache)
+{
+  *Cache = BleReconnectCache;
+}
+
+/**
+* @brief  Empty the reconnect cache and the controller white and resolving lists
+*         (after the clear of the security database, called also for the ClearDB command)
+* @param  None
+* @retval None
+*/
+void BLE_ReconnectClearCache(void)
+{
+  tBleStatus RetStatus;
+  
+  memset(&BleReconnectCache,0,sizeof(BLE_ReconnectCache_t));
+  BleAdvSchedule.BondedPeerValid = 0U;
+  BLE_ReconnectCacheSave();
+  
+  RetStatus = hci_le_clear_white_list();
+  if (RetStatus != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: hci_le_clear_white_list() failed:0x%02x\r\n", RetStatus);
+  }
+  
+  /* The resolving list can be written only with the address resolution disabled */
+  (void)hci_le_set_address_resolution_enable(0x00);
+  RetStatus = hci_le_clear_resolving_list();
+  if (RetStatus != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("Error: hci_le_clear_resolving_list() failed:0x%02x\r\n", RetStatus);
+  }
+  
+  BleReconnectListedNumber = 0U;
+}
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+
+#ifdef BLE_MANAGER_CONN_TUNER
+/**
+* @brief  Start the connection parameters tuner for a new connection
+* @param  uint16_t Conn_Interval connection interval (1.25 ms units)
+* @param  uint16_t Conn_Latency slave latency
+* @param  uint16_t Supervision_Timeout supervision timeout (10 ms units)
+* @retval None
+*/
+static void BLE_ConnTunerConnected(uint16_t Conn_Interval, uint16_t Conn_Latency, uint16_t Supervision_Timeout)
+{
+  BLE_ConnTunerStats_t Stats = BleConnTuner.Stats;
+  
+  memset(&BleConnTuner,0,sizeof(BLE_ConnTuner_t));
+  
+  /* The counters are kept across the connections */
+  BleConnTuner.Stats = Stats;
+  BleConnTuner.Stats.Profile = BLE_CONN_PROFILE_CENTRAL;
+  BleConnTuner.Stats.Rate = 0U;
+  BleConnTuner.Stats.ConnInterval = Conn_Interval;
+  BleConnTuner.Stats.ConnLatency = Conn_Latency;
+  BleConnTuner.Stats.SupervisionTimeout = Supervision_Timeout;
+  
+  BleConnTuner.TargetProfile = BLE_CONN_PROFILE_CENTRAL;
+  BleConnTuner.RetryDelay = BLE_CONN_TUNER_RETRY_MIN;
+  BleConnTuner.WindowStartTick = BLE_MANAGER_CONN_TUNER_TICK();
+  BleConnTuner.RetryTick = BleConnTuner.WindowStartTick;
+  BleConnTuner.Connected = 1U;
+}
+
+/**
+* @brief  Measure the notification traffic and request the connection parameters
+*         that fit it (to call periodically from the main loop)
+* @param  None
+* @retval None
+*/
+void BLE_ConnTunerProcess(void)
+{
+  uint32_t Now;
+  uint32_t Elapsed;
+  
+  if(BleConnTuner.Connected==0U) {
+    return;
+  }
+  
+  Now = BLE_MANAGER_CONN_TUNER_TICK();
+  Elapsed = Now - BleConnTuner.WindowStartTick;
+  
+  if(BleConnTuner.WindowBytes >= ((BLE_CONN_TUNER_STREAM_RATE * BLE_CONN_TUNER_WINDOW) / 1000U)) {
+    /* A stream is starting: no need to wait the end of the window */
+    BleConnTuner.TargetProfile = BLE_CONN_PROFILE_STREAM;
+    BleConnTuner.IdleWindows = 0U;
+  }
+  
+  if(Elapsed >= BLE_CONN_TUNER_WINDOW) {
+    uint32_t Rate = (uint32_t)(((uint64_t)BleConnTuner.WindowBytes * 1000U) / Elapsed);
+    
+    BleConnTuner.Stats.Rate = Rate;
+    BleConnTuner.WindowBytes = 0U;
+    BleConnTuner.WindowStartTick = Now;
+    
+    if(Rate >= BLE_CONN_TUNER_STREAM_RATE) {
+      BleConnTuner.TargetProfile = BLE_CONN_PROFILE_STREAM;
+      BleConnTuner.IdleWindows = 0U;
+    } else if(Rate <= BLE_CONN_TUNER_IDLE_RATE) {
+      /* Hysteresis: the idle parameters only after some idle windows */
+      if(BleConnTuner.IdleWindows < BLE_CONN_TUNER_IDLE_WINDOWS) {
+        BleConnTuner.IdleWindows++;
+      }
+      if(BleConnTuner.IdleWindows >= BLE_CONN_TUNER_IDLE_WINDOWS) {
+        BleConnTuner.TargetProfile = BLE_CONN_PROFILE_IDLE;
+      }
+    } else {
+      BleConnTuner.IdleWindows = 0U;
+    }
+  }
+  
+  if((BleConnTuner.TargetProfile != BleConnTuner.Stats.Profile) &&
+     (BleConnTuner.RequestPending==0U) &&
+     (((int32_t)(Now - BleConnTuner.RetryTick)) >= 0)) {
+    BLE_ConnTunerRequest(BleConnTuner.TargetProfile);
+  }
+}
+
+/**
+* @brief  Send the connection parameter update request of one profile to the central
+* @param  BLE_ConnProfileType Profile requested profile
+* @retval None
+*/
+static void BLE_ConnTunerRequest(BLE_ConnProfileType Profile)
+{
+  tBleStatus RetStatus;
+  
+  if(Profile==BLE_CONN_PROFILE_STREAM) {
+    RetStatus = aci_l2cap_connection_parameter_update_req(connection_handle,
+                                                          BLE_CONN_STREAM_INTERVAL_MIN, BLE_CONN_STREAM_INTERVAL_MAX,
+                                                          BLE_CONN_STREAM_LATENCY, BLE_CONN_STREAM_TIMEOUT);
+  } else if(Profile==BLE_CONN_PROFILE_IDLE) {
+    RetStatus = aci_l2cap_connection_parameter_update_req(connection_handle,
+                                                          BLE_CONN_IDLE_INTERVAL_MIN, BLE_CONN_IDLE_INTERVAL_MAX,
+                                                          BLE_CONN_IDLE_LATENCY, BLE_CONN_IDLE_TIMEOUT);
+  } else {
+    /* The central parameters are never requested */
+    return;
+  }
+  
+  BleConnTuner.Stats.Requests++;
+  
+  if(RetStatus == (tBleStatus)BLE_STATUS_SUCCESS) {
+    BleConnTuner.RequestPending = 1U;
+    BleConnTuner.RequestedProfile = Profile;
+#if (BLE_DEBUG_LEVEL>1)
+    BLE_MANAGER_PRINTF("Connection parameters request %s\r\n",BleConnProfileNames[Profile]);
+#endif
+  } else {
+    BLE_MANAGER_PRINTF("Error: aci_l2cap_connection_parameter_update_req [%x]\r\n",RetStatus);
+    BLE_ConnTunerBackOff();
+  }
+}
+
+/**
+* @brief  Delay the next request after a refusal (doubling the delay at each refusal)
+* @param  None
+* @retval None
+*/
+static void BLE_ConnTunerBackOff(void)
+{
+  BleConnTuner.RequestPending = 0U;
+  BleConnTuner.RetryTick = BLE_MANAGER_CONN_TUNER_TICK() + BleConnTuner.RetryDelay;
+  
+  if(BleConnTuner.RetryDelay < (BLE_CONN_TUNER_RETRY_MAX / 2U)) {
+    BleConnTuner.RetryDelay *= 2U;
+  } else {
+    BleConnTuner.RetryDelay = BLE_CONN_TUNER_RETRY_MAX;
+  }
+}
+
+/**
+* @brief  Read the next time BLE_ConnTunerProcess has something to do
+*         (for waking up from low power modes in time)
+* @param  uint32_t *Deadline filled with the deadline (BLE_MANAGER_CONN_TUNER_TICK units)
+* @retval uint8_t 1 if there is a deadline (only while connected), 0 otherwise
+*/
+uint8_t BLE_ConnTunerGetDeadline(uint32_t *Deadline)
+{
+  if(BleConnTuner.Connected==0U) {
+    return 0U;
+  }
+  
+  /* End of the measure window */
+  *Deadline = BleConnTuner.WindowStartTick + BLE_CONN_TUNER_WINDOW;
+  
+  if((BleConnTuner.TargetProfile != BleConnTuner.Stats.Profile) &&
+     (BleConnTuner.RequestPending==0U) &&
+     (((int32_t)(BleConnTuner.RetryTick - *Deadline)) < 0)) {
+    /* End of the back-off */
+    *Deadline = BleConnTuner.RetryTick;
+  }
+  return 1U;
+}
+
+/**
+* @brief  Read the connection parameters tuner metrics
+* @param  BLE_ConnTunerStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_ConnTunerGetStats(BLE_ConnTunerStats_t *Stats)
+{
+  *Stats = BleConnTuner.Stats;
+}
+
+/**
+* @brief  Write the connection parameters tuner metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendConnTuner(void)
+{
+  BLE_ConnTunerStats_t Stats;
+  
+  BLE_ConnTunerGetStats(&Stats);
+  
+  /* Connection interval in 1.25 ms units */
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Conn %s int=%lu.%02lu ms lat=%u to=%lu ms\r\n",
+                                 BleConnProfileNames[Stats.Profile],
+                                 (unsigned long)((Stats.ConnInterval * 125U) / 100U),
+                                 (unsigned long)((Stats.ConnInterval * 125U) % 100U),
+                                 Stats.ConnLatency,
+                                 (unsigned long)(Stats.SupervisionTimeout * 10U));
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  /* Add a Delay respect previous line */
+  BLE_MANAGER_DELAY(20);
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Rate=%lu B/s req=%lu ok=%lu rej=%lu tmo=%lu\r\n",
+                                 (unsigned long)Stats.Rate,
+                                 (unsigned long)Stats.Requests,
+                                 (unsigned long)Stats.Accepted,
+                                 (unsigned long)Stats.Rejected,
+                                 (unsigned long)Stats.Timeouts);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_CONN_TUNER */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+/**
+* @brief  Check if the updates of one characteristic are queued until the end of the next connection event.
+*         The Term and the Extended Configuration answers are sent in chunk loops that do not process
+*         the HCI events: they would fill the queue before the end of the connection event
+* @param  BleCharTypeDef *BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @retval uint8_t 1 if the updates are queued, 0 if they are sent directly
+*/
+static uint8_t BLE_RadioSyncIsQueued(BleCharTypeDef *BleCharPointer)
+{
+  if((BleCharPointer==&BleCharStdOut) || (BleCharPointer==&BleCharStdErr)) {
+    return 0;
+  }
+#ifndef BLE_MANAGER_NO_PARSON
+  if(BleCharPointer==&BleCharExtConfig) {
+    return 0;
+  }
+#endif /* BLE_MANAGER_NO_PARSON */
+  return 1;
+}
+
+/**
+* @brief  Queue one notification until the end of the next connection event
+* @param  BleCharTypeDef *BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @param  uint8_t charValOffset The offset of the characteristic
+* @param  uint8_t charValueLen The length of the characteristic
+* @param  uint8_t *charValue The pointer to the characteristic
+* @retval tBleStatus BLE_STATUS_INSUFFICIENT_RESOURCES if the queue is full
+*/
+static tBleStatus BLE_RadioSyncQueue(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue)
+{
+  BLE_RadioSyncEntry_t *Entry;
+  
+  if((BleRadioSync.EntriesNumber == BLE_RADIO_SYNC_QUEUE_SIZE) ||
+     ((BleRadioSync.DataLength + charValueLen) > BLE_RADIO_SYNC_QUEUE_BYTES)) {
+    BleRadioSync.Stats.QueueFull++;
+    return BLE_STATUS_INSUFFICIENT_RESOURCES;
+  }
+  
+  Entry = &BleRadioSync.Entries[BleRadioSync.EntriesNumber];
+  Entry->BleCharPointer = BleCharPointer;
+  Entry->DataOffset = (uint16_t)BleRadioSync.DataLength;
+  Entry->charValOffset = charValOffset;
+  Entry->charValueLen = charValueLen;
+  memcpy(&BleRadioSync.Data[BleRadioSync.DataLength],charValue,charValueLen);
+  
+  BleRadioSync.DataLength += charValueLen;
+  BleRadioSync.EntriesNumber++;
+  
+  BleRadioSync.Stats.Queued++;
+  if(BleRadioSync.EntriesNumber > BleRadioSync.Stats.HighWater) {
+    BleRadioSync.Stats.HighWater = BleRadioSync.EntriesNumber;
+  }
+  return BLE_STATUS_SUCCESS;
+}
+
+/**
+* @brief  Send now the queued notifications (without waiting the end of the next connection event)
+* @param  None
+* @retval uint32_t number of notifications still queued (controller buffer full)
+*/
+uint32_t BLE_RadioSyncFlush(void)
+{
+  uint32_t Sent = 0U;
+  
+  BleRadioSync.Flushing = 1U;
+  while(Sent < BleRadioSync.EntriesNumber) {
+    BLE_RadioSyncEntry_t *Entry = &BleRadioSync.Entries[Sent];
+    tBleStatus ret;
+    
+    ret = ACI_GATT_UPDATE_CHAR_VALUE(Entry->BleCharPointer,Entry->charValOffset,Entry->charValueLen,&BleRadioSync.Data[Entry->DataOffset]);
+    if(ret == (tBleStatus)BLE_STATUS_INSUFFICIENT_RESOURCES) {
+      /* Controller buffer full: the remaining ones at the next connection event */
+      BleRadioSync.Stats.Deferred++;
+      break;
+    }
+    /* The other errors drop the notification, like for the direct updates */
+    Sent++;
+  }
+  BleRadioSync.Flushing = 0U;
+  
+  if(Sent > BleRadioSync.Stats.MaxBurst) {
+    BleRadioSync.Stats.MaxBurst = Sent;
+  }
+  BleRadioSync.Stats.Sent += Sent;
+  
+  if(Sent == BleRadioSync.EntriesNumber) {
+    BleRadioSync.EntriesNumber = 0U;
+    BleRadioSync.DataLength = 0U;
+  } else if(Sent > 0U) {
+    /* Move the remaining ones at the beginning of the queue */
+    uint32_t FirstOffset = BleRadioSync.Entries[Sent].DataOffset;
+    uint32_t Index;
+    
+    BleRadioSync.EntriesNumber -= Sent;
+    BleRadioSync.DataLength -= FirstOffset;
+    memmove(BleRadioSync.Entries,&BleRadioSync.Entries[Sent],BleRadioSync.EntriesNumber*sizeof(BLE_RadioSyncEntry_t));
+    memmove(BleRadioSync.Data,&BleRadioSync.Data[FirstOffset],BleRadioSync.DataLength);
+    for(Index=0; Index<BleRadioSync.EntriesNumber; Index++) {
+      BleRadioSync.Entries[Index].DataOffset -= (uint16_t)FirstOffset;
+    }
+  } else {
+    /* Nothing sent */
+  }
+  
+  return BleRadioSync.EntriesNumber;
+}
+
+/**
+* @brief  Read the notifications queue metrics
+* @param  BLE_RadioSyncStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_RadioSyncGetStats(BLE_RadioSyncStats_t *Stats)
+{
+  *Stats = BleRadioSync.Stats;
+}
+
+/**
+* @brief  Write the notifications queue metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendRadioSync(void)
+{
+  BLE_RadioSyncStats_t Stats;
+  
+  BLE_RadioSyncGetStats(&Stats);
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Radio events=%lu queued=%lu full=%lu\r\n",
+                                 (unsigned long)Stats.ConnectionEvents,
+                                 (unsigned long)Stats.Queued,
+                                 (unsigned long)Stats.QueueFull);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  /* Add a Delay respect previous line */
+  BLE_MANAGER_DELAY(20);
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"sent=%lu deferred=%lu burst=%lu hwm=%lu\r\n",
+                                 (unsigned long)Stats.Sent,
+                                 (unsigned long)Stats.Deferred,
+                                 (unsigned long)Stats.MaxBurst,
+                                 (unsigned long)Stats.HighWater);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
+#ifdef BLE_MANAGER_TX_CREDITS
+/**
+* @brief  Read the size and the number of the controller data buffers
+* @param  None
+* @retval None
+*/
+static void BLE_TxCreditsInit(void)
+{
+  tBleStatus ret;
+  uint16_t AclLength;
+  uint8_t Total;
+  
+  memset(&BleTxCredits,0,sizeof(BLE_TxCreditsStats_t));
+  
+  ret = hci_le_read_buffer_size(&AclLength,&Total);
+  if(ret != (tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("\thci_le_read_buffer_size failed: 0x%02x\r\n", ret);
+    return;
+  }
+  
+  BleTxCredits.AclLength = AclLength;
+  BleTxCredits.Total = Total;
+  BLE_TxCreditsReset();
+  BLE_MANAGER_PRINTF("\tController buffers %u x %u bytes\r\n",Total,AclLength);
+}
+
+/**
+* @brief  Set all the controller buffers free (new connection or disconnection)
+* @param  None
+* @retval None
+*/
+static void BLE_TxCreditsReset(void)
+{
+  BleTxCredits.Available = BleTxCredits.Total;
+  BleTxCredits.MinAvailable = BleTxCredits.Total;
+  BleTxCreditsTracking = 0U;
+}
+
+/**
+* @brief  Compute the controller buffers taken by one notification
+* @param  uint8_t charValueLen The length of the characteristic
+* @retval uint32_t number of buffers
+*/
+static uint32_t BLE_TxCreditsCost(uint8_t charValueLen)
+{
+  return (((uint32_t)charValueLen + BLE_TX_CREDITS_HEADERS + BleTxCredits.AclLength) - 1U) / BleTxCredits.AclLength;
+}
+
+/**
+* @brief  Check if the controller buffer can take one notification
+* @param  uint8_t charValueLen The length of the characteristic
+* @retval uint8_t 1 if the notification could be sent, 0 otherwise
+*/
+static uint8_t BLE_TxCreditsCheck(uint8_t charValueLen)
+{
+  if((BleTxCredits.Total==0U) || (BleTxCreditsTracking==0U)) {
+    /* No accounting or no completed packets event yet on this connection:
+     * the controller decides */
+    return 1U;
+  }
+  
+  if(BLE_TxCreditsCost(charValueLen) > BleTxCredits.Available) {
+    BleTxCredits.Skipped++;
+    return 0U;
+  }
+  return 1U;
+}
+
+/**
+* @brief  Take the controller buffers after one characteristic update
+* @param  uint8_t charValueLen The length of the characteristic
+* @param  tBleStatus ret Status of the update
+* @retval None
+*/
+static void BLE_TxCreditsUpdate(uint8_t charValueLen, tBleStatus ret)
+{
+  if(BleTxCredits.Total==0U) {
+    return;
+  }
+  
+  if(ret==(tBleStatus)BLE_STATUS_SUCCESS) {
+    uint32_t Cost = BLE_TxCreditsCost(charValueLen);
+    
+    BleTxCredits.Available = (uint16_t)((Cost > BleTxCredits.Available) ? 0U : (BleTxCredits.Available - Cost));
+    BleTxCredits.Consumed += Cost;
+    if(BleTxCredits.Available < BleTxCredits.MinAvailable) {
+      BleTxCredits.MinAvailable = BleTxCredits.Available;
+    }
+  } else if(ret==(tBleStatus)BLE_STATUS_INSUFFICIENT_RESOURCES) {
+    /* The count was wrong: the controller is full */
+    BleTxCredits.Resyncs++;
+    BleTxCredits.Available = 0U;
+    BleTxCredits.MinAvailable = 0U;
+  } else {
+    /* Nothing given to the controller */
+  }
+}
+
+/**
+* @brief  Compute how many notifications the controller buffer can take now
+* @param  uint8_t charValueLen length of the notifications
+* @retval uint32_t number of notifications
+*/
+uint32_t BLE_TxCreditsGetNotifications(uint8_t charValueLen)
+{
+  if(BleTxCredits.Total==0U) {
+    return 0U;
+  }
+  return BleTxCredits.Available / BLE_TxCreditsCost(charValueLen);
+}
+
+/**
+* @brief  Read the controller buffer accounting metrics
+* @param  BLE_TxCreditsStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_TxCreditsGetStats(BLE_TxCreditsStats_t *Stats)
+{
+  *Stats = BleTxCredits;
+}
+
+/**
+* @brief  Write the controller buffer accounting metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendTxCredits(void)
+{
+  BLE_TxCreditsStats_t Stats;
+  
+  BLE_TxCreditsGetStats(&Stats);
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Credits %u/%u (min %u) x %u bytes\r\n",
+                                 Stats.Available,
+                                 Stats.Total,
+                                 Stats.MinAvailable,
+                                 Stats.AclLength);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  /* Add a Delay respect previous line */
+  BLE_MANAGER_DELAY(20);
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"used=%lu done=%lu skip=%lu resync=%lu\r\n",
+                                 (unsigned long)Stats.Consumed,
+                                 (unsigned long)Stats.Completed,
+                                 (unsigned long)Stats.Skipped,
+                                 (unsigned long)Stats.Resyncs);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_TX_CREDITS */
+
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+/**
+* @brief  Copy one write request in the queue of BLE_DeferredProcess
+* @param  BleCharTypeDef *BleCharPointer pointer to the BleCharTypeDef of the written ble char
+* @param  uint16_t attr_handle Attribute handle
+* @param  uint16_t Offset Offset of the written value
+* @param  uint16_t data_length Length of the written value
+* @param  uint8_t *att_data Written value
+* @retval uint8_t 1 if the write request is queued, 0 if it must be run now (the queue is empty)
+*/
+static uint8_t BLE_DeferredPost(BleCharTypeDef *BleCharPointer, uint16_t attr_handle, uint16_t Offset, uint16_t data_length, uint8_t *att_data)
+{
+  BLE_DeferredJob_t *Job;
+  
+  if((BleDeferred.Number == BLE_DEFERRED_JOBS) || (data_length > BLE_DEFERRED_DATA_SIZE)) {
+    /* Run now, but after the write requests already queued (the ExtConfig command chunks keep their order) */
+    (void)BLE_DeferredProcess(UINT32_MAX);
+    BleDeferred.Stats.Inline++;
+    return 0U;
+  }
+  
+  Job = &BleDeferred.Jobs[(BleDeferred.Head + BleDeferred.Number) % BLE_DEFERRED_JOBS];
+  Job->BleCharPointer = BleCharPointer;
+  Job->attr_handle = attr_handle;
+  Job->Offset = Offset;
+  Job->data_length = (uint8_t)data_length;
+  memcpy(Job->Data,att_data,data_length);
+  Job->PostTick = BLE_MANAGER_DEFERRED_TICK();
+  
+  BleDeferred.Number++;
+  BleDeferred.Stats.Posted++;
+  if(BleDeferred.Number > BleDeferred.Stats.HighWater) {
+    BleDeferred.Stats.HighWater = BleDeferred.Number;
+  }
+  return 1U;
+}
+
+/**
+* @brief  Run the write requests posted by the HCI events
+*         (to call from the main loop after hci_user_evt_proc)
+* @param  uint32_t Budget time budget in ms (at least one write request is run)
+* @retval uint32_t number of write requests still queued
+*/
+uint32_t BLE_DeferredProcess(uint32_t Budget)
+{
+  uint32_t StartTick = BLE_MANAGER_DEFERRED_TICK();
+  
+  while(BleDeferred.Number > 0U) {
+    BLE_DeferredJob_t *Job = &BleDeferred.Jobs[BleDeferred.Head];
+    uint32_t RunTick = BLE_MANAGER_DEFERRED_TICK();
+    uint32_t Elapsed;
+    
+    if((RunTick - Job->PostTick) > BleDeferred.Stats.MaxWait) {
+      BleDeferred.Stats.MaxWait = RunTick - Job->PostTick;
+    }
+    
+    Job->BleCharPointer->Write_Request_CB(Job->BleCharPointer,Job->attr_handle,Job->Offset,Job->data_length,Job->Data);
+    
+    /* The slot is released only after the callback (the data is used in place) */
+    BleDeferred.Head = (BleDeferred.Head + 1U) % BLE_DEFERRED_JOBS;
+    BleDeferred.Number--;
+    BleDeferred.Stats.Executed++;
+    
+    Elapsed = BLE_MANAGER_DEFERRED_TICK() - RunTick;
+    if(Elapsed > BleDeferred.Stats.MaxRun) {
+      BleDeferred.Stats.MaxRun = Elapsed;
+    }
+    
+    if((BLE_MANAGER_DEFERRED_TICK() - StartTick) >= Budget) {
+      break;
+    }
+  }
+  
+  return BleDeferred.Number;
+}
+
+/**
+* @brief  Discard the queued write requests (the central that has written them is gone)
+* @param  None
+* @retval None
+*/
+static void BLE_DeferredFlush(void)
+{
+  BleDeferred.Stats.Discarded += BleDeferred.Number;
+  BleDeferred.Number = 0U;
+  BleDeferred.Head = 0U;
+}
+
+/**
+* @brief  Read the number of write requests waiting BLE_DeferredProcess
+* @param  None
+* @retval uint32_t number of write requests
+*/
+uint32_t BLE_DeferredPending(void)
+{
+  return BleDeferred.Number;
+}
+
+/**
+* @brief  Read the deferred writes metrics
+* @param  BLE_DeferredStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_DeferredGetStats(BLE_DeferredStats_t *Stats)
+{
+  *Stats = BleDeferred.Stats;
+}
+
+/**
+* @brief  Write the deferred writes metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendDeferred(void)
+{
+  BLE_DeferredStats_t Stats;
+  
+  BLE_DeferredGetStats(&Stats);
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Jobs posted=%lu run=%lu inline=%lu hwm=%lu\r\n",
+                                 (unsigned long)Stats.Posted,
+                                 (unsigned long)Stats.Executed,
+                                 (unsigned long)Stats.Inline,
+                                 (unsigned long)Stats.HighWater);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  /* Add a Delay respect previous line */
+  BLE_MANAGER_DELAY(20);
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Max wait=%lu ms run=%lu ms discarded=%lu\r\n",
+                                 (unsigned long)Stats.MaxWait,
+                                 (unsigned long)Stats.MaxRun,
+                                 (unsigned long)Stats.Discarded);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+
+#ifdef BLE_MANAGER_STACK_RECOVERY
+/**
+* @brief  Reset the BlueNRG and rebuild the same GATT database after one hardware error
+*         or BlueNRG self reset (to call from the main loop, it does nothing otherwise)
+* @param  None
+* @retval None
+*/
+void BLE_StackRecoveryProcess(void)
+{
+  tBleStatus ret;
+  uint16_t OldHandles[BLE_MANAGER_MAX_ALLOCABLE_CHARS];
+  uint32_t StartTick;
+  uint8_t BleChar;
+  
+  if(BleRecoveryRequested==0U) {
+    return;
+  }
+  
+  BleRecoveryRequested = 0U;
+  BleRecoveryArmed = 0U;
+  StartTick = BLE_MANAGER_BOOT_TICK();
+  BLE_MANAGER_PRINTF("\r\nBLE stack recovery\r\n");
+  
+  if(connection_handle!=0U) {
+    /* The connection is lost with the BlueNRG reset */
+    hci_disconnection_complete_event(0x00,connection_handle,BLE_RECOVERY_DISCONNECT_REASON);
+  }
+  
+  /* Nothing queued for the lost BlueNRG state is sent after the recovery */
+#ifdef ACC_BLUENRG_CONGESTION
+  breath = 0;
+#endif /* ACC_BLUENRG_CONGESTION */
+#ifdef BLE_MANAGER_RADIO_SYNC
+  BleRadioSync.EntriesNumber = 0U;
+  BleRadioSync.DataLength = 0U;
+#endif /* BLE_MANAGER_RADIO_SYNC */
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+  BLE_DeferredFlush();
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+#ifdef BLE_MANAGER_RTOS
+  BLE_RtosFlush();
+#endif /* BLE_MANAGER_RTOS */
+  
+  for(BleChar=0; BleChar<UsedBleChars; BleChar++) {
+    OldHandles[BleChar] = BleCharsArray[BleChar]->attr_handle;
+  }
+  
+  /* hci_init resets the BlueNRG and the stack is configured again like at boot */
+  BleRecoveryRunning = 1U;
+  ret = InitBleManager_BLE_Stack();
+  BleRecoveryRunning = 0U;
+  
+  if(ret==(tBleStatus)BLE_STATUS_SUCCESS) {
+    ret = BLE_StackRecoveryServices();
+  }
+  
+  if(ret==(tBleStatus)BLE_STATUS_SUCCESS) {
+#ifdef BLE_MANAGER_FAST_RECONNECT
+    /* The controller white and resolving lists are empty after its reset */
+    BleReconnectListedNumber = 0U;
+    BLE_ReconnectRefresh();
+#else /* BLE_MANAGER_FAST_RECONNECT */
+    UpdateWhiteList();
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+    /* Fast advertising for the central that has just lost the connection */
+    BLE_AdvertisingReset();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+    
+    BleRecovery.HandlesChanged = 0U;
+    for(BleChar=0; BleChar<UsedBleChars; BleChar++) {
+      if(OldHandles[BleChar] != BleCharsArray[BleChar]->attr_handle) {
+        BleRecovery.HandlesChanged++;
+      }
+    }
+    
+    BleRecovery.Recoveries++;
+    BleRecovery.LastDuration = BLE_MANAGER_BOOT_TICK() - StartTick;
+    BleRecoveryArmed = 1U;
+    set_connectable = TRUE;
+    BLE_MANAGER_PRINTF("BLE stack recovered in %lu ms\r\n",(unsigned long)BleRecovery.LastDuration);
+  } else {
+    BleRecovery.Failures++;
+    BLE_MANAGER_PRINTF("Error: BLE stack recovery failed [%x]\r\n",ret);
+  }
+  
+  if(CustomStackRecovered!=NULL) {
+    CustomStackRecovered(ret);
+  } else if(ret!=(tBleStatus)BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_DELAY(1000);
+    HAL_NVIC_SystemReset();
+  } else {
+    /* Recovered */
+  }
+}
+
+/**
+* @brief  Add again the BLE Manager services with the characteristics already registered
+*         (same order of InitBleManagerServices, so the handles are the same)
+* @param  None
+* @retval tBleStatus Status
+*/
+static tBleStatus BLE_StackRecoveryServices(void)
+{
+  tBleStatus Status = BLE_STATUS_SUCCESS;
+  
+  if(BLE_StackValue.EnableConfig) {
+    Status = BLE_Manager_AddConfigService();
+  }
+  
+  if((Status == (tBleStatus)BLE_STATUS_SUCCESS) && (BLE_StackValue.EnableConsole)) {
+    Status = BLE_Manager_AddConsoleService();
+  }
+  
+  if((Status == (tBleStatus)BLE_STATUS_SUCCESS) && (UsedBleChars > UsedStandardBleChars)) {
+    Status = BLE_Manager_AddFeaturesService();
+  }
+  
+  return Status;
+}
+
+/**
+* @brief  Read the BLE stack recovery metrics
+* @param  BLE_RecoveryStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_StackRecoveryGetStats(BLE_RecoveryStats_t *Stats)
+{
+  *Stats = BleRecovery;
+}
+
+/**
+* @brief  Write the BLE stack recovery metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendRecovery(void)
+{
+  BLE_RecoveryStats_t Stats;
+  
+  BLE_StackRecoveryGetStats(&Stats);
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"HwErr=%lu (last %x) Resets=%lu (last %x) Crash=%lu\r\n",
+                                 (unsigned long)Stats.HardwareErrors,
+                                 Stats.LastHardwareCode,
+                                 (unsigned long)Stats.ControllerResets,
+                                 Stats.LastResetReason,
+                                 (unsigned long)Stats.CrashInfos);
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  /* Add a Delay respect previous line */
+  BLE_MANAGER_DELAY(20);
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Recovered=%lu Failed=%lu last=%lu ms handles changed=%lu\r\n",
+                                 (unsigned long)Stats.Recoveries,
+                                 (unsigned long)Stats.Failures,
+                                 (unsigned long)Stats.LastDuration,
+                                 (unsigned long)Stats.HandlesChanged);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+
+#ifdef BLE_MANAGER_RTOS
+/**
+* @brief  Create the BLE task that owns the HCI transport (after InitBleManager, before osKernelStart).
+*         From now the characteristic updates of the other threads are copied and posted to the BLE task,
+*         and all the BLE Manager callbacks run in the BLE task.
+*         The Term_Update/Stderr_Update messages of the other threads are copied and sent by the BLE task:
+*         they should be built in their own buffers, not in the shared BufferToWrite
+* @param  None
+* @retval uint8_t 1 for success, 0 otherwise
+*/
+uint8_t BLE_RtosStart(void)
+{
+  BleRtos.PoolId = osPoolCreate(osPool(BleRtosPool));
+  BleRtos.QueueId = osMessageCreate(osMessageQ(BleRtosQueue), NULL);
+  if((BleRtos.PoolId==NULL) || (BleRtos.QueueId==NULL)) {
+    BLE_MANAGER_PRINTF("Error: BLE task queue\r\n");
+    return 0;
+  }
+  
+  /* The updates are posted only when the task exists */
+  BleRtos.TaskId = osThreadCreate(osThread(BLE_RtosTask), NULL);
+  if(BleRtos.TaskId==NULL) {
+    BLE_MANAGER_PRINTF("Error: BLE task creation\r\n");
+    return 0;
+  }
+  
+  return 1;
+}
+
+/**
+* @brief  BLE task: it sends the posted updates and handles the HCI events and the BLE Manager timers
+* @param  void const *argument not used
+* @retval None
+*/
+static void BLE_RtosTask(void const *argument)
+{
+  osEvent Event;
+  
+  for(;;) {
+    /* Posted updates, HCI events or BLE_RTOS_POLL_TIME for the BLE Manager timers */
+    (void)osSignalWait(BLE_RTOS_SIGNAL_WAKEUP, BLE_RTOS_POLL_TIME);
+    
+    Event = osMessageGet(BleRtos.QueueId, 0);
+    while(Event.status == osEventMessage) {
+      BLE_RtosSend((BLE_RtosBuffer_t *)Event.value.p);
+      Event = osMessageGet(BleRtos.QueueId, 0);
+    }
+    
+    /* The event callbacks run in this task */
+    hci_user_evt_proc();
+    
+#ifdef BLE_MANAGER_STACK_RECOVERY
+    BLE_StackRecoveryProcess();
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+    BLE_AdvertisingProcess();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+    (void)BLE_DeferredProcess(BLE_DEFERRED_BUDGET);
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+#ifdef BLE_MANAGER_CONN_TUNER
+    BLE_ConnTunerProcess();
+#endif /* BLE_MANAGER_CONN_TUNER */
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+    (void)BLE_SampleProcess(BLE_SAMPLE_BUDGET);
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+    
+    if(CustomRtosTaskLoop!=NULL) {
+      CustomRtosTaskLoop();
+    }
+  }
+}
+
+/**
+* @brief  Check if the caller is a thread different from the BLE task
+*         (its characteristic updates and Term/Stderr messages are posted to the BLE task)
+* @param  None
+* @retval uint8_t 1 for one thread different from the BLE task (0 before BLE_RtosStart)
+*/
+uint8_t BLE_RtosIsOtherThread(void)
+{
+  if(BleRtos.TaskId == NULL) {
+    /* Before BLE_RtosStart (BLE Manager init) */
+    return 0;
+  }
+  return (osThreadGetId() != BleRtos.TaskId) ? 1U : 0U;
+}
+
+/**
+* @brief  Signal the HCI events to the BLE task (to call from hci_tl_lowlevel_isr)
+* @param  None
+* @retval None
+*/
+void BLE_RtosHciNotify(void)
+{
+  if(BleRtos.TaskId != NULL) {
+    BLE_RtosWakeUp();
+    BleRtos.Stats.HciNotifications++;
+  }
+}
+
+/**
+* @brief  Wake up the BLE task (also from interrupt). The signal does not use the queue of the posted updates
+* @param  None
+* @retval None
+*/
+static void BLE_RtosWakeUp(void)
+{
+  if(BleRtos.TaskId != NULL) {
+    (void)osSignalSet(BleRtos.TaskId, BLE_RTOS_SIGNAL_WAKEUP);
+  }
+}
+
+/**
+* @brief  Take one buffer for a zero-copy characteristic update (filled by the caller and sent with BLE_RtosPostBuffer)
+* @param  None
+* @retval BLE_RtosBuffer_t* buffer or NULL if all the buffers are in use
+*/
+BLE_RtosBuffer_t *BLE_RtosGetBuffer(void)
+{
+  BLE_RtosBuffer_t *Buffer = (BLE_RtosBuffer_t *)osPoolAlloc(BleRtos.PoolId);
+  
+  if(Buffer == NULL) {
+    /* Metrics counted without lock */
+    BleRtos.Stats.Dropped++;
+    return NULL;
+  }
+  
+  BleRtos.Used++;
+  if(BleRtos.Used > BleRtos.Stats.MaxUsed) {
+    BleRtos.Stats.MaxUsed = BleRtos.Used;
+  }
+  Buffer->charValOffset = 0;
+  return Buffer;
+}
+
+/**
+* @brief  Post one buffer taken with BLE_RtosGetBuffer to the BLE task (the buffer is released by the BLE task)
+* @param  BLE_RtosBuffer_t *Buffer buffer with the characteristic value in Data
+* @param  BleCharTypeDef *BleCharPointer characteristic to update
+* @param  uint8_t charValueLen length of the characteristic value
+* @retval tBleStatus Status
+*/
+tBleStatus BLE_RtosPostBuffer(BLE_RtosBuffer_t *Buffer, BleCharTypeDef *BleCharPointer, uint8_t charValueLen)
+{
+  Buffer->BleCharPointer = BleCharPointer;
+  Buffer->charValueLen = charValueLen;
+  
+  if(osMessagePut(BleRtos.QueueId, (uint32_t)Buffer, 0U) != osOK) {
+    (void)osPoolFree(BleRtos.PoolId, Buffer);
+    BleRtos.Used--;
+    BleRtos.Stats.Dropped++;
+    return BLE_STATUS_INSUFFICIENT_RESOURCES;
+  }
+  
+  BleRtos.Stats.Posted++;
+  BLE_RtosWakeUp();
+  return BLE_STATUS_SUCCESS;
+}
+
+/**
+* @brief  Copy one characteristic update and post it to the BLE task
+* @param  BleCharPointer pointer to the BleCharTypeDef for the current ble char
+* @param  charValOffset The offset of the characteristic
+* @param  charValueLen The length of the characteristic
+* @param  charValue The pointer to the characteristic
+* @retval tBleStatus Status
+*/
+static tBleStatus BLE_RtosPost(BleCharTypeDef *BleCharPointer, uint8_t charValOffset, uint8_t charValueLen, uint8_t *charValue)
+{
+  BLE_RtosBuffer_t *Buffer;
+  
+  if(charValueLen > BLE_RTOS_DATA_SIZE) {
+    BleRtos.Stats.Dropped++;
+    return BLE_STATUS_INVALID_PARAMS;
+  }
+  
+  Buffer = BLE_RtosGetBuffer();
+  if(Buffer == NULL) {
+    return BLE_STATUS_INSUFFICIENT_RESOURCES;
+  }
+  
+  memcpy(Buffer->Data, charValue, charValueLen);
+  Buffer->charValOffset = charValOffset;
+  return BLE_RtosPostBuffer(Buffer, BleCharPointer, charValueLen);
+}
+
+/**
+* @brief  Copy one Term/Stderr message and post it to the BLE task (in more buffers if necessary)
+* @param  BleCharTypeDef *BleCharPointer BleCharStdOut or BleCharStdErr
+* @param  uint8_t *data string to write
+* @param  uint8_t length length of string to write
+* @retval tBleStatus Status
+*/
+static tBleStatus BLE_RtosPostText(BleCharTypeDef *BleCharPointer, uint8_t *data, uint8_t length)
+{
+  tBleStatus ret = BLE_STATUS_SUCCESS;
+  uint32_t Offset;
+  uint32_t DataToSend;
+  
+  for(Offset=0; (Offset<length) && (ret==(tBleStatus)BLE_STATUS_SUCCESS); Offset+=DataToSend) {
+    DataToSend = ((length-Offset)>BLE_RTOS_DATA_SIZE) ? BLE_RTOS_DATA_SIZE : (length-Offset);
+    ret = BLE_RtosPost(BleCharPointer,0,(uint8_t)DataToSend,data+Offset);
+  }
+  return ret;
+}
+
+/**
+* @brief  Send one posted characteristic update and release its buffer (BLE task)
+* @param  BLE_RtosBuffer_t *Buffer posted buffer
+* @retval None
+*/
+static void BLE_RtosSend(BLE_RtosBuffer_t *Buffer)
+{
+  tBleStatus ret;
+  
+  if(Buffer->BleCharPointer == &BleCharStdOut) {
+    /* Term message (Term_Update keeps the copy for the read requests) */
+    ret = Term_Update(Buffer->Data, Buffer->charValueLen);
+  } else if(Buffer->BleCharPointer == &BleCharStdErr) {
+    ret = Stderr_Update(Buffer->Data, Buffer->charValueLen);
+  } else {
+    ret = ACI_GATT_UPDATE_CHAR_VALUE(Buffer->BleCharPointer, Buffer->charValOffset, Buffer->charValueLen, Buffer->Data);
+  }
+  
+  if(ret != (tBleStatus)BLE_STATUS_SUCCESS) {
+    BleRtos.Stats.SendErrors++;
+  }
+  
+  (void)osPoolFree(BleRtos.PoolId, Buffer);
+  BleRtos.Used--;
+}
+
+/**
+* @brief  Release the posted updates without sending them (BLE task)
+* @param  None
+* @retval None
+*/
+static void BLE_RtosFlush(void)
+{
+  osEvent Event;
+  
+  if(BleRtos.QueueId == NULL) {
+    /* Before BLE_RtosStart */
+    return;
+  }
+  
+  Event = osMessageGet(BleRtos.QueueId, 0);
+  while(Event.status == osEventMessage) {
+    (void)osPoolFree(BleRtos.PoolId, Event.value.p);
+    BleRtos.Used--;
+    BleRtos.Stats.Dropped++;
+    Event = osMessageGet(BleRtos.QueueId, 0);
+  }
+}
+
+/**
+* @brief  Read the BLE task metrics
+* @param  BLE_RtosStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_RtosGetStats(BLE_RtosStats_t *Stats)
+{
+  *Stats = BleRtos.Stats;
+}
+
+/**
+* @brief  Write the BLE task metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendRtos(void)
+{
+  BLE_RtosStats_t Stats;
+  
+  BLE_RtosGetStats(&Stats);
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Posted=%lu Dropped=%lu SendErr=%lu MaxUsed=%lu/%lu Hci=%lu\r\n",
+                                 (unsigned long)Stats.Posted,
+                                 (unsigned long)Stats.Dropped,
+                                 (unsigned long)Stats.SendErrors,
+                                 (unsigned long)Stats.MaxUsed,
+                                 (unsigned long)BLE_RTOS_QUEUE_SIZE,
+                                 (unsigned long)Stats.HciNotifications);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_RTOS */
+
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+/**
+* @brief  Empty the sample queue
+* @param  None
+* @retval None
+*/
+static void BLE_SampleQueueInit(void)
+{
+  uint32_t Slot;
+  
+  memset(&BleSampleQueue,0,sizeof(BLE_SampleQueue_t));
+  for(Slot=0; Slot<BLE_SAMPLE_QUEUE_SIZE; Slot++) {
+    BleSampleQueue.Slots[Slot].Sequence = Slot;
+  }
+}
+
+/**
+* @brief  Replace one value if it has not been changed (interrupted between load and store means retry)
+* @param  volatile uint32_t *Value value to change
+* @param  uint32_t Expected value read before
+* @param  uint32_t New new value
+* @retval uint8_t 1 if the value has been changed, 0 otherwise
+*/
+static uint8_t BLE_SampleCompareAndSwap(volatile uint32_t *Value, uint32_t Expected, uint32_t New)
+{
+  if(__LDREXW(Value) != Expected) {
+    __CLREX();
+    return 0;
+  }
+  /* The exception entry/return clears the exclusive monitor: the store fails if one interrupt has pushed in the middle */
+  return (__STREXW(New,Value)==0U) ? 1U : 0U;
+}
+
+/**
+* @brief  Increment one counter shared by the interrupts
+* @param  volatile uint32_t *Value counter
+* @retval None
+*/
+static void BLE_SampleAtomicIncrement(volatile uint32_t *Value)
+{
+  uint32_t Old;
+  
+  do {
+    Old = *Value;
+  } while(BLE_SampleCompareAndSwap(Value,Old,Old+1U)==0U);
+}
+
+/**
+* @brief  Queue one sample with its timestamp (lock-free, callable from any interrupt priority)
+* @param  uint8_t Channel source of the sample
+* @param  const uint8_t *Data BLE_SAMPLE_SIZE bytes of the sample
+* @retval uint8_t 1 for success, 0 if the queue is full (sample dropped)
+*/
+uint8_t BLE_SamplePush(uint8_t Channel, const uint8_t *Data)
+{
+  BLE_SampleSlot_t *Slot;
+  uint32_t Position;
+  int32_t Diff;
+  
+  for(;;) {
+    Position = BleSampleQueue.Tail;
+    Slot = &BleSampleQueue.Slots[Position & (BLE_SAMPLE_QUEUE_SIZE-1U)];
+    Diff = (int32_t)(Slot->Sequence - Position);
+    
+    if(Diff == 0) {
+      /* Free slot: claim it */
+      if(BLE_SampleCompareAndSwap(&BleSampleQueue.Tail,Position,Position+1U)) {
+        break;
+      }
+      BLE_SampleAtomicIncrement(&BleSampleQueue.Retries);
+    } else if(Diff < 0) {
+      /* Slot not yet read by the consumer: queue full */
+      BLE_SampleAtomicIncrement(&BleSampleQueue.Dropped);
+      return 0;
+    } else {
+      /* Slot claimed by one interrupt that has preempted us: read Tail again */
+    }
+  }
+  
+  /* The slot is owned by this producer: no other interrupt writes it */
+  Slot->Sample.Timestamp = BLE_MANAGER_SAMPLE_TICK();
+  Slot->Sample.Channel = Channel;
+  memcpy(Slot->Sample.Data,Data,BLE_SAMPLE_SIZE);
+  
+  /* Sample visible to the consumer only after it has been written */
+  BLE_SAMPLE_BARRIER();
+  Slot->Sequence = Position + 1U;
+#ifdef BLE_MANAGER_RTOS
+  /* The BLE task is the consumer */
+  BLE_RtosWakeUp();
+#endif /* BLE_MANAGER_RTOS */
+  return 1;
+}
+
+/**
+* @brief  Read the oldest sample of the queue (single consumer)
+* @param  BLE_Sample_t *Sample filled with the sample
+* @retval uint8_t 1 for one sample read, 0 if empty (or oldest sample still being written)
+*/
+static uint8_t BLE_SamplePop(BLE_Sample_t *Sample)
+{
+  BLE_SampleSlot_t *Slot = &BleSampleQueue.Slots[BleSampleQueue.Head & (BLE_SAMPLE_QUEUE_SIZE-1U)];
+  
+  if(Slot->Sequence != (BleSampleQueue.Head + 1U)) {
+    return 0;
+  }
+  
+  BLE_SAMPLE_BARRIER();
+  *Sample = Slot->Sample;
+  BLE_SAMPLE_BARRIER();
+  
+  /* Slot free for the producers of the next lap */
+  Slot->Sequence = BleSampleQueue.Head + BLE_SAMPLE_QUEUE_SIZE;
+  BleSampleQueue.Head++;
+  return 1;
+}
+
+/**
+* @brief  Give the first samples of the batch to CustomSampleBatch
+* @param  uint32_t Number number of samples
+* @retval None
+*/
+static void BLE_SampleDeliver(uint32_t Number)
+{
+  BleSampleQueue.Batches++;
+  if(CustomSampleBatch!=NULL) {
+    CustomSampleBatch(BleSampleBatch[0].Channel,BleSampleBatch,Number);
+  }
+}
+
+/**
+* @brief  Give the queued samples in batches to CustomSampleBatch
+*         (to call from the main loop, single consumer)
+* @param  uint32_t Budget max number of samples handled
+* @retval uint32_t number of samples still queued
+*/
+uint32_t BLE_SampleProcess(uint32_t Budget)
+{
+  uint32_t Done = 0;
+  uint32_t Number = 0;
+  uint32_t Used = BleSampleQueue.Tail - BleSampleQueue.Head;
+  
+  if(Used > BleSampleQueue.MaxUsed) {
+    BleSampleQueue.MaxUsed = Used;
+  }
+  
+  while((Done < Budget) && (BLE_SamplePop(&BleSampleBatch[Number]))) {
+    Done++;
+    if((Number > 0U) && (BleSampleBatch[Number].Channel != BleSampleBatch[0].Channel)) {
+      /* Another channel: one batch for the previous samples */
+      BLE_SampleDeliver(Number);
+      BleSampleBatch[0] = BleSampleBatch[Number];
+      Number = 1;
+    } else {
+      Number++;
+      if(Number == BLE_SAMPLE_BATCH) {
+        BLE_SampleDeliver(Number);
+        Number = 0;
+      }
+    }
+  }
+  
+  if(Number > 0U) {
+    BLE_SampleDeliver(Number);
+  }
+  
+  return BleSampleQueue.Tail - BleSampleQueue.Head;
+}
+
+/**
+* @brief  Read the sample queue metrics
+* @param  BLE_SampleStats_t *Stats filled with the metrics
+* @retval None
+*/
+void BLE_SampleGetStats(BLE_SampleStats_t *Stats)
+{
+  /* Every claimed position is one pushed sample */
+  Stats->Pushed = BleSampleQueue.Tail;
+  Stats->Dropped = BleSampleQueue.Dropped;
+  Stats->Retries = BleSampleQueue.Retries;
+  Stats->Batches = BleSampleQueue.Batches;
+  Stats->MaxUsed = BleSampleQueue.MaxUsed;
+}
+
+/**
+* @brief  Write the sample queue metrics on the Term characteristic
+* @param  None
+* @retval None
+*/
+static void Term_SendSamples(void)
+{
+  BLE_SampleStats_t Stats;
+  
+  BLE_SampleGetStats(&Stats);
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Pushed=%lu Dropped=%lu Retries=%lu Batches=%lu MaxUsed=%lu/%lu\r\n",
+                                 (unsigned long)Stats.Pushed,
+                                 (unsigned long)Stats.Dropped,
+                                 (unsigned long)Stats.Retries,
+                                 (unsigned long)Stats.Batches,
+                                 (unsigned long)Stats.MaxUsed,
+                                 (unsigned long)BLE_SAMPLE_QUEUE_SIZE);
+  Term_Update(BufferToWrite,BytesToWrite);
+}
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+
+#ifdef BLE_MANAGER_FAST_BOOT
+/**
+* @brief  Timestamp the end of one boot phase (only the first time after InitBleManager)
+* @param  BLE_BootPhaseType Phase boot phase
+* @retval None
+*/
+static void BLE_BootMark(BLE_BootPhaseType Phase)
+{
+  if(BleBootReport.PhasesDone==((uint8_t)Phase)) {
+    BleBootReport.PhaseEnd[Phase] = BLE_MANAGER_BOOT_TICK() - BleBootReport.StartTick;
+    BleBootReport.PhasesDone++;
+  }
+}
 
-  ret = aci_gap_set_advertising_data_nwk(0, ADV_COMPLETE_DATA, BLE_MANAGER_ADVERTISE_DATA_LENGHT, manuf_data);
-  if(ret != BLE_STATUS_SUCCESS) {
-    BLE_MANAGER_PRINTF("aci_gap_set_advertising_data_nwk failed: 0x%02x\r\n", ret);
-    goto EndLabel;
-  } else {
-    BLE_MANAGER_PRINTF("aci_gap_set_advertising_data_nwk\r\n");
+/**
+* @brief  Wait the BlueNRG initialized event after its reset
+*         (the user events received in the meantime are processed)
+* @param  None
+* @retval uint8_t 1 if the event was received, 0 for timeout
+*/
+static uint8_t BLE_BootWaitReady(void)
+{
+  uint32_t StartTick = BLE_MANAGER_BOOT_TICK();
+  
+  while(BleBootReady==0U) {
+    hci_user_evt_proc();
+    if((BLE_MANAGER_BOOT_TICK() - StartTick) >= BLE_BOOT_READY_TIMEOUT) {
+      BleBootReport.ReadyTimeout = 1U;
+      return 0;
+    }
   }
+  return 1;
+}
 
-  Advertising_Set_Parameters[0].Advertising_Handle = 0;
-  Advertising_Set_Parameters[0].Duration = 0;
-  Advertising_Set_Parameters[0].Max_Extended_Advertising_Events = 0;
+/**
+* @brief  Read the boot report
+* @param  BLE_BootReport_t *Report filled with the report
+* @retval None
+*/
+void BLE_BootGetReport(BLE_BootReport_t *Report)
+{
+  *Report = BleBootReport;
+}
 
-  /* enable advertising */
-  ret = aci_gap_set_advertising_enable(ENABLE, 1, Advertising_Set_Parameters);
-  if(ret != BLE_STATUS_SUCCESS)
-  {
-    BLE_MANAGER_PRINTF("aci_gap_set_advertising_enable failed: 0x%02x\r\n",ret);
-  } else {
-    BLE_MANAGER_PRINTF("aci_gap_set_advertising_enable\r\n");
+/**
+* @brief  Print the boot report with BLE_MANAGER_PRINTF
+* @param  None
+* @retval None
+*/
+void BLE_BootPrint(void)
+{
+  uint32_t Phase;
+  uint32_t PhaseStart = 0U;
+  
+  BLE_MANAGER_PRINTF("\r\nBoot report (InitBleManager at %lu ms):\r\n",(unsigned long)BleBootReport.StartTick);
+  for(Phase=0; Phase<((uint32_t)BleBootReport.PhasesDone); Phase++) {
+    BLE_MANAGER_PRINTF("\t%-12s %5lu ms (+%lu ms)\r\n",
+                       BleBootPhaseNames[Phase],
+                       (unsigned long)BleBootReport.PhaseEnd[Phase],
+                       (unsigned long)(BleBootReport.PhaseEnd[Phase] - PhaseStart));
+    PhaseStart = BleBootReport.PhaseEnd[Phase];
   }
   
-EndLabel:
-  return;
+  if(BleBootReport.ReadyTimeout) {
+    BLE_MANAGER_PRINTF("\tBlueNRG initialized event timeout\r\n\r\n");
+  } else {
+    BLE_MANAGER_PRINTF("\tBlueNRG initialized Reason_Code=%x\r\n\r\n",BleBootReport.ReadyReason);
+  }
 }
-#endif /* (BLUE_CORE != BLUENRG_LP) */
 
-#if (BLUE_CORE != BLUENRG_LP)
 /**
-* @brief  Exits the device from connectable mode.
+* @brief  Write the boot report on the Term characteristic
 * @param  None
 * @retval None
 */
-void setNotConnectable(void)
+static void Term_SendBootReport(void)
 {
-  aci_gap_set_non_discoverable();
+  uint32_t Phase;
+  uint32_t PhaseStart = 0U;
+  
+  BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"Boot at %lu ms ready=%s\r\n",
+                                 (unsigned long)BleBootReport.StartTick,
+                                 (BleBootReport.ReadyTimeout!=0U) ? "timeout" : "event");
+  Term_Update(BufferToWrite,BytesToWrite);
+  
+  for(Phase=0; Phase<((uint32_t)BleBootReport.PhasesDone); Phase++) {
+    /* Add a Delay respect previous line */
+    BLE_MANAGER_DELAY(20);
+    BytesToWrite =(uint8_t)sprintf((char *)BufferToWrite,"%s %lu ms (+%lu)\r\n",
+                                   BleBootPhaseNames[Phase],
+                                   (unsigned long)BleBootReport.PhaseEnd[Phase],
+                                   (unsigned long)(BleBootReport.PhaseEnd[Phase] - PhaseStart));
+    Term_Update(BufferToWrite,BytesToWrite);
+    PhaseStart = BleBootReport.PhaseEnd[Phase];
+  }
 }
-#endif /* (BLUE_CORE != BLUENRG_LP) */
+#endif /* BLE_MANAGER_FAST_BOOT */
 
 /**
 * @brief  Added BLE service
@@ -2536,10 +7266,21 @@ int32_t BleManagerAddChar(BleCharTypeDef *BleChar)
 void ResetBleManager(void)
 {
   BLE_MANAGER_PRINTF("\r\nReset BleManager\r\n\r\n");
+#ifdef BLE_MANAGER_FAST_BOOT
+  BleBootReady = 0U;
+  /* Same reset pulse of the HCI transport layer */
+  HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_RESET);
+  BLE_MANAGER_DELAY(5);
+  HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_SET);
+  if(BLE_BootWaitReady()==0U) {
+    BLE_MANAGER_PRINTF("BlueNRG initialized event timeout\r\n");
+  }
+#else /* BLE_MANAGER_FAST_BOOT */
   HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_RESET);
   BLE_MANAGER_DELAY(300);
   HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_SET);
   BLE_MANAGER_DELAY(300);
+#endif /* BLE_MANAGER_FAST_BOOT */
 }
 #endif /* (BLUE_CORE != BLUE_WB) */
 
@@ -2557,6 +7298,22 @@ static void ResetBleManagerCallbackFunctionPointer(void)
   CustomDisconnectionCompleted=NULL;
   CustomAciGattTxPoolAvailableEvent=NULL;
   CustomHardwareErrorEventHandler=NULL;
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  CustomReconnectCacheSave=NULL;
+  CustomReconnectCacheLoad=NULL;
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  CustomStackRecovered=NULL;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+#ifdef BLE_MANAGER_RTOS
+  CustomRtosTaskLoop=NULL;
+#endif /* BLE_MANAGER_RTOS */
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+  CustomSampleBatch=NULL;
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+#ifdef BLE_MANAGER_RADIO_SYNC
+  CustomEndOfConnectionEvent=NULL;
+#endif /* BLE_MANAGER_RADIO_SYNC */
 
   /**************** Debug Console *************************/
   CustomDebugConsoleParsingCallback=NULL;
@@ -2607,6 +7364,10 @@ static void ResetBleManagerCallbackFunctionPointer(void)
   //For Sensor Configuration
   CustomExtConfigReadSensorsConfigCommandsCallback=NULL;
   CustomExtConfigSetSensorsConfigCommandsCallback=NULL;
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+  CustomExtConfigReadSensorsConfigCborCommandsCallback=NULL;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+  CustomExtConfigReadSensorsConfigStaticCommandsCallback=NULL;
 #endif /* BLE_MANAGER_NO_PARSON */
 }
 
@@ -2619,6 +7380,30 @@ tBleStatus InitBleManager(void)
 {
   tBleStatus ret= BLE_STATUS_SUCCESS;
   
+#ifdef BLE_MANAGER_PROFILING
+  /* Before the stack initialization for profiling also the first HCI commands */
+  BLE_ProfileInit();
+#endif /* BLE_MANAGER_PROFILING */
+  
+  BLE_MEM_PHASE_ENTER(BLE_MEM_PHASE_INIT);
+  
+#ifdef BLE_MANAGER_FAST_BOOT
+  memset(&BleBootReport,0,sizeof(BLE_BootReport_t));
+  BleBootReport.StartTick = BLE_MANAGER_BOOT_TICK();
+#endif /* BLE_MANAGER_FAST_BOOT */
+  
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+  /* Before enabling the sensor interrupts */
+  BLE_SampleQueueInit();
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+  
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  /* The first advertising after boot starts with the fast one */
+  memset(&BleAdvSchedule,0,sizeof(BLE_AdvSchedule_t));
+  BleAdvSchedule.LastAccountTick = BLE_MANAGER_ADV_TICK();
+  BLE_AdvertisingReset();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+  
   BLE_Conf_Service = BLE_SERV_NOT_ENABLE;
   BLE_StdTerm_Service = BLE_SERV_NOT_ENABLE;
   BLE_StdErr_Service = BLE_SERV_NOT_ENABLE;
@@ -2639,15 +7424,32 @@ tBleStatus InitBleManager(void)
   ResetBleManagerCallbackFunctionPointer();
 #ifndef BLE_MANAGER_NO_PARSON
   ClearCustomCommandsList();
+  (void)json_path_compile(&ExtConfigPathCommand,"command");
+  (void)json_path_compile(&ExtConfigPathArgString,"argString");
+  (void)json_path_compile(&ExtConfigPathArgNumber,"argNumber");
 #endif /* BLE_MANAGER_NO_PARSON */
   
   if(ret==(tBleStatus)BLE_STATUS_SUCCESS) {
     /* Ble Manager services initialization */
     ret = InitBleManagerServices();
+#ifdef BLE_MANAGER_FAST_RECONNECT
+    /* After the services: the application has set the reconnect cache callbacks */
+    BLE_ReconnectInit();
+#endif /* BLE_MANAGER_FAST_RECONNECT */
+#ifdef BLE_MANAGER_FAST_BOOT
+    BLE_BootMark(BLE_BOOT_PHASE_SERVICES);
+#endif /* BLE_MANAGER_FAST_BOOT */
   }
   
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  /* From now the BlueNRG errors are recovered without MCU reset */
+  BleRecoveryArmed = (ret==(tBleStatus)BLE_STATUS_SUCCESS) ? 1U : 0U;
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+  
   set_connectable=TRUE;
   
+  BLE_MEM_PHASE_EXIT(BLE_MEM_PHASE_INIT);
+  
   return ret;
 }
 
@@ -2667,6 +7469,10 @@ void HCI_Event_CB(void *pckt)
   if(hci_pckt->type != (uint8_t)HCI_EVENT_PKT) {
     return;
   }
+  
+#ifdef BLE_MANAGER_STATS
+  BLE_HciStats.HciEvents++;
+#endif /* BLE_MANAGER_STATS */
  
   switch(event_pckt->evt){
     
@@ -2970,6 +7776,10 @@ static void APP_UserEvtRx(void *pData)
   if(hci_pckt->type == (uint8_t)HCI_EVENT_PKT) {
     hci_event_pckt *event_pckt = (hci_event_pckt*)hci_pckt->data;
     
+#ifdef BLE_MANAGER_STATS
+    BLE_HciStats.HciEvents++;
+#endif /* BLE_MANAGER_STATS */
+    
     if(event_pckt->evt == (uint8_t)EVT_LE_META_EVENT) {
       evt_le_meta_event *evt = (void *)event_pckt->data;
       
@@ -3016,6 +7826,10 @@ static void APP_UserEvtRx(void *pData)
     void *data;
     hci_event_pckt *event_pckt = (hci_event_pckt*)hci_pckt->data;
 
+#ifdef BLE_MANAGER_STATS
+    BLE_HciStats.HciEvents++;
+#endif /* BLE_MANAGER_STATS */
+
     if(hci_pckt->type == HCI_EVENT_PKT){
       data = event_pckt->data;
     }
@@ -3082,6 +7896,11 @@ static tBleStatus InitBleManager_BLE_Stack(void)
   uint8_t  hwVersion;
   uint16_t fwVersion;
   
+#ifdef BLE_MANAGER_FAST_BOOT
+  /* The hci_init resets the BlueNRG that sends the initialized event when it is operational */
+  BleBootReady = 0U;
+#endif /* BLE_MANAGER_FAST_BOOT */
+  
   /* Initialize the BlueNRG HCI */
   hci_init(APP_UserEvtRx, NULL);
   
@@ -3089,11 +7908,21 @@ static tBleStatus InitBleManager_BLE_Stack(void)
   InitBLEIntForBlueNRGLP();
 #endif /* (BLUE_CORE == BLUENRG_LP) */
   
+#ifdef BLE_MANAGER_FAST_BOOT
+  BLE_BootMark(BLE_BOOT_PHASE_HCI_INIT);
+  
+  /* No Sw reset: the BlueNRG has just been reset by hci_init */
+  if(BLE_BootWaitReady()==0U) {
+    BLE_MANAGER_PRINTF("\r\nBlueNRG initialized event timeout\r\n");
+  }
+  BLE_BootMark(BLE_BOOT_PHASE_STACK_READY);
+#else /* BLE_MANAGER_FAST_BOOT */
   /* Sw reset of the device */
   hci_reset();
 
   /* Wait some time for the BlueNRG to be fully operational */
   HAL_Delay(2000);
+#endif /* BLE_MANAGER_FAST_BOOT */
   
   /* get the BlueNRG HW and FW versions */
   getBlueNRGVersion(&hwVersion, &fwVersion);
@@ -3114,7 +7943,12 @@ static tBleStatus InitBleManager_BLE_Stack(void)
   }
   
   /* Generate Random Key at every boot */
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  /* The recovery keeps the secure PIN */
+  if((BLE_StackValue.EnableRandomSecurePIN) && (BleRecoveryRunning==0U)) {
+#else /* BLE_MANAGER_STACK_RECOVERY */
   if(BLE_StackValue.EnableRandomSecurePIN) {
+#endif /* BLE_MANAGER_STACK_RECOVERY */
     BLE_StackValue.SecurePIN = 99999;
     
     /* get a random number from BlueNRG-1 */
@@ -3152,7 +7986,12 @@ static tBleStatus InitBleManager_BLE_Stack(void)
   }
 
 #if (BLUE_CORE != BLUENRG_LP)
+#ifdef BLE_MANAGER_FAST_RECONNECT
+  /* Controller privacy: the resolving list lets the white list accept the bonded centrals with a resolvable private address */
+  ret = aci_gap_init(BLE_StackValue.GAP_Roles, 0x02, (uint8_t) strlen(BLE_StackValue.BoardName), &service_handle, &dev_name_char_handle, &appearance_char_handle);
+#else /* BLE_MANAGER_FAST_RECONNECT */
   ret = aci_gap_init(BLE_StackValue.GAP_Roles, 0, (uint8_t) strlen(BLE_StackValue.BoardName), &service_handle, &dev_name_char_handle, &appearance_char_handle);
+#endif /* BLE_MANAGER_FAST_RECONNECT */
 #else /* (BLUE_CORE != BLUENRG_LP) */
   ret = aci_gap_init(BLE_StackValue.GAP_Roles, 0x00, (uint8_t) strlen(BLE_StackValue.BoardName), STATIC_RANDOM_ADDR, &service_handle, &dev_name_char_handle,
                      &appearance_char_handle);
@@ -3282,6 +8121,23 @@ static tBleStatus InitBleManager_BLE_Stack(void)
   }
 #endif /*(BLUE_CORE == BLUENRG_LP) */
   
+#ifdef BLE_MANAGER_RADIO_SYNC
+  /* End of radio activity events only for the connection events */
+  ret = aci_hal_set_radio_activity_mask(BLE_RADIO_SYNC_ACTIVITY_MASK);
+  if (ret != BLE_STATUS_SUCCESS) {
+    BLE_MANAGER_PRINTF("\taci_hal_set_radio_activity_mask failed: 0x%02x\r\n", ret);
+    goto fail;
+  }
+#endif /* BLE_MANAGER_RADIO_SYNC */
+  
+#ifdef BLE_MANAGER_TX_CREDITS
+  BLE_TxCreditsInit();
+#endif /* BLE_MANAGER_TX_CREDITS */
+  
+#ifdef BLE_MANAGER_FAST_BOOT
+  BLE_BootMark(BLE_BOOT_PHASE_STACK_CONFIG);
+#endif /* BLE_MANAGER_FAST_BOOT */
+  
 fail:
   return ret;
 }
@@ -3433,6 +8289,132 @@ static tBleStatus InitBleManagerServices(void)
   return Status;
 }
 
+#ifdef BLE_MANAGER_STATIC_POOLS
+/**
+* @brief  Link all the blocks of each pool inside its free list
+* @param  None
+* @retval None
+*/
+static void BLE_PoolInit(void)
+{
+  uint32_t Pool;
+  
+  for(Pool=0; Pool<BLE_POOL_NUMBER; Pool++) {
+    BLE_Pool_t *LocPool = &BlePools[Pool];
+    uint32_t Block;
+    
+    LocPool->FreeList = NULL;
+    /* Link from the last block so the first allocations use the lowest addresses */
+    for(Block=LocPool->Stats.Blocks; Block>0U; Block--) {
+      void **FreeBlock = (void **)(LocPool->Memory + ((Block-1U) * LocPool->Stats.BlockSize));
+      *FreeBlock = LocPool->FreeList;
+      LocPool->FreeList = FreeBlock;
+    }
+  }
+  BlePoolsInitialized=1U;
+}
+
+/**
+* @brief  Allocate one block from the smallest pool with free blocks that could contain Size bytes
+* @param  size_t Size Number of bytes requested
+* @retval void *Pointer to the block or NULL if there are not free blocks
+*/
+void *BLE_PoolMalloc(size_t Size)
+{
+  uint32_t SizeClass;
+  uint32_t Pool;
+  
+  if(BlePoolsInitialized==0U) {
+    BLE_PoolInit();
+  }
+  
+  /* Search the smallest pool that could contain the request */
+  for(SizeClass=0; SizeClass<BLE_POOL_NUMBER; SizeClass++) {
+    if(Size <= BlePools[SizeClass].Stats.BlockSize) {
+      break;
+    }
+  }
+  
+  if(SizeClass==BLE_POOL_NUMBER) {
+    BlePools[BLE_POOL_NUMBER-1U].Stats.AllocFailures++;
+#if (BLE_DEBUG_LEVEL>1)
+    BLE_MANAGER_PRINTF("Error: Pool request too big [%lu]\r\n",(unsigned long)Size);
+#endif
+    return NULL;
+  }
+  
+  /* Fall back on the bigger pools when the right one is exhausted */
+  for(Pool=SizeClass; Pool<BLE_POOL_NUMBER; Pool++) {
+    BLE_Pool_t *LocPool = &BlePools[Pool];
+    
+    if(LocPool->FreeList!=NULL) {
+      void **Block = (void **)LocPool->FreeList;
+      LocPool->FreeList = *Block;
+      
+      LocPool->Stats.UsedBlocks++;
+      if(LocPool->Stats.UsedBlocks > LocPool->Stats.MaxUsedBlocks) {
+        LocPool->Stats.MaxUsedBlocks = LocPool->Stats.UsedBlocks;
+      }
+      if(Pool!=SizeClass) {
+        LocPool->Stats.FallbackAllocs++;
+      }
+      return (void *)Block;
+    }
+  }
+  
+  BlePools[SizeClass].Stats.AllocFailures++;
+#if (BLE_DEBUG_LEVEL>1)
+  BLE_MANAGER_PRINTF("Error: Pools exhausted [%lu]\r\n",(unsigned long)Size);
+#endif
+  return NULL;
+}
+
+/**
+* @brief  Give back one block allocated with BLE_PoolMalloc (NULL is ignored)
+* @param  void *Pointer Pointer to the block
+* @retval None
+*/
+void BLE_PoolFree(void *Pointer)
+{
+  uint32_t Pool;
+  
+  if(Pointer==NULL) {
+    return;
+  }
+  
+  /* The pool is identified by the address range */
+  for(Pool=0; Pool<BLE_POOL_NUMBER; Pool++) {
+    BLE_Pool_t *LocPool = &BlePools[Pool];
+    uint8_t *Block = (uint8_t *)Pointer;
+    
+    if((Block >= LocPool->Memory) &&
+       (Block < (LocPool->Memory + (LocPool->Stats.BlockSize * LocPool->Stats.Blocks)))) {
+      *((void **)Pointer) = LocPool->FreeList;
+      LocPool->FreeList = Pointer;
+      LocPool->Stats.UsedBlocks--;
+      return;
+    }
+  }
+  
+  BLE_MANAGER_PRINTF("Error: Freeing one block not allocated from the pools\r\n");
+}
+
+/**
+* @brief  Read the usage statistics of one blocks pool
+* @param  uint32_t Pool Pool number (0 Small, 1 Medium, 2 Large)
+* @param  BLE_PoolStats_t *Stats Pointer to the structure filled with the statistics
+* @retval uint8_t 1 for valid Pool number, 0 otherwise
+*/
+uint8_t BLE_PoolGetStats(uint32_t Pool, BLE_PoolStats_t *Stats)
+{
+  if(Pool>=BLE_POOL_NUMBER) {
+    return 0U;
+  }
+  *Stats = BlePools[Pool].Stats;
+  return 1U;
+}
+#endif /* BLE_MANAGER_STATIC_POOLS */
+
 #ifndef BLE_MANAGER_NO_PARSON
 /**
 * @brief  This function is called to parse a BLE_COMM_TP packet.
@@ -3444,6 +8426,8 @@ static tBleStatus InitBleManagerServices(void)
 uint32_t BLE_Command_TP_Parse(uint8_t** buffer_out, uint8_t* buffer_in, uint32_t len) 
 {
   static uint32_t tot_len = 0;
+  /* Length declared on the start packet (the buffer is allocated only for this number of bytes) */
+  static uint32_t message_length = 0;
   uint32_t buff_out_len = 0;
   static BLE_COMM_TP_Status_Typedef status = BLE_COMM_TP_WAIT_START;
   BLE_COMM_TP_Packet_Typedef packet_type;
@@ -3453,50 +8437,41 @@ uint32_t BLE_Command_TP_Parse(uint8_t** buffer_out, uint8_t* buffer_in, uint32_t
   switch (status)
   {
   case BLE_COMM_TP_WAIT_START:
-    if (packet_type == BLE_COMM_TP_START_PACKET) 
+    if ((packet_type == BLE_COMM_TP_START_PACKET) || (packet_type == BLE_COMM_TP_START_END_PACKET))
     {
       /*First part of an BLE Command packet*/
       /*packet is enqueued*/        
-      uint16_t message_length = buffer_in[1];
-      message_length = message_length << 8;
-      message_length |= buffer_in[2];
-      
-      *buffer_out = (uint8_t*)BLE_MallocFunction((message_length) * sizeof(uint8_t));
-      
-      if(*buffer_out == NULL) {
-        BLE_MANAGER_PRINTF("Error: Mem alloc error [%d]: %d@%s\r\n", message_length, __LINE__, __FILE__);
-      }      
-      
-      memcpy(*buffer_out + tot_len, (uint8_t*) &buffer_in[3], (len - 3U));
-      
-      
-      tot_len += len - 3U;
-      status = BLE_COMM_TP_WAIT_END;
-      buff_out_len = 0; 
-    }
-    else if (packet_type == BLE_COMM_TP_START_END_PACKET) 
-    {
-      /*Final part of an BLE Command packet*/
-      /*packet is enqueued*/      
-      uint16_t message_length = buffer_in[1];
+      message_length = buffer_in[1];
       message_length = message_length << 8;
       message_length |= buffer_in[2];
+      tot_len = 0;
       
-      *buffer_out = (uint8_t*)BLE_MallocFunction((message_length) * sizeof(uint8_t));        
-      if(*buffer_out == NULL) {
-        BLE_MANAGER_PRINTF("Error: Mem alloc error [%d]: %d@%s\r\n", message_length, __LINE__, __FILE__);
+      if((len < 3U) || ((len - 3U) > message_length)) {
+        BLE_MANAGER_PRINTF("Error: BLE_COMM_TP start packet not valid\r\n");
+        *buffer_out = NULL;
+      } else {
+        *buffer_out = (uint8_t*)BLE_MallocFunction((message_length) * sizeof(uint8_t));
+        
+        if(*buffer_out == NULL) {
+          BLE_MANAGER_PRINTF("Error: Mem alloc error [%lu]: %d@%s\r\n", (unsigned long)message_length, __LINE__, __FILE__);
+        } else {
+          memcpy(*buffer_out, (uint8_t*) &buffer_in[3], (len - 3U));
+          tot_len = len - 3U;
+        }
       }
       
-      memcpy(*buffer_out + tot_len, (uint8_t*) &buffer_in[3], (len - 3U));
-      
-      
-      tot_len += len - 3U;
-      /*number of bytes of the output packet*/
-      buff_out_len = tot_len;
-      /*total length set to zero*/
-      tot_len = 0;
-      /*reset status*/
-      status = BLE_COMM_TP_WAIT_START;
+      if(packet_type == BLE_COMM_TP_START_PACKET) {
+        /* Wait the remaining packets also when the message is dropped, for staying aligned with the Client */
+        status = BLE_COMM_TP_WAIT_END;
+        buff_out_len = 0;
+      } else if(*buffer_out != NULL) {
+        /*number of bytes of the output packet*/
+        buff_out_len = tot_len;
+        /*total length set to zero*/
+        tot_len = 0;
+      } else {
+        buff_out_len = 0;
+      }
     }
     else
     {
@@ -3505,32 +8480,39 @@ uint32_t BLE_Command_TP_Parse(uint8_t** buffer_out, uint8_t* buffer_in, uint32_t
     }
     break;
   case BLE_COMM_TP_WAIT_END: 
-    if (packet_type == BLE_COMM_TP_MIDDLE_PACKET) 
+    if ((packet_type == BLE_COMM_TP_MIDDLE_PACKET) || (packet_type == BLE_COMM_TP_END_PACKET))
     {
-      /*Central part of an BLE Command packet*/
+      /*Central/Final part of an BLE Command packet*/
       /*packet is enqueued*/
-      memcpy(*buffer_out + tot_len, (uint8_t*) &buffer_in[1], (len - 1U));
-      
-      tot_len += len - 1U;
+      if(*buffer_out != NULL) {
+        if((len < 1U) || ((tot_len + len - 1U) > message_length)) {
+          BLE_MANAGER_PRINTF("Error: BLE_COMM_TP message longer than %lu bytes\r\n", (unsigned long)message_length);
+          BLE_FreeFunction(*buffer_out);
+          *buffer_out = NULL;
+        } else {
+          memcpy(*buffer_out + tot_len, (uint8_t*) &buffer_in[1], (len - 1U));
+          tot_len += len - 1U;
+        }
+      }
       
-      buff_out_len = 0; 
+      if(packet_type == BLE_COMM_TP_END_PACKET) {
+        /*number of bytes of the output packet (0 if the message was dropped)*/
+        buff_out_len = (*buffer_out != NULL) ? tot_len : 0U;
+        /*total length set to zero*/
+        tot_len = 0;
+        /*reset status*/
+        status = BLE_COMM_TP_WAIT_START;
+      } else {
+        buff_out_len = 0;
+      }
     }
-    else if (packet_type == BLE_COMM_TP_END_PACKET) 
-    {
-      /*Final part of an BLE Command packet*/
-      /*packet is enqueued*/
-      memcpy(*buffer_out + tot_len, (uint8_t*) &buffer_in[1], (len - 1U));
-      
-      tot_len += len - 1U;
-      /*number of bytes of the output packet*/
-      buff_out_len = tot_len;
-      /*total length set to zero*/
-      tot_len = 0;
-      /*reset status*/
-      status = BLE_COMM_TP_WAIT_START; 
-    } 
     else 
     {
+      /* Drop the partial message */
+      if(*buffer_out != NULL) {
+        BLE_FreeFunction(*buffer_out);
+        *buffer_out = NULL;
+      }
       /*reset status*/
       status = BLE_COMM_TP_WAIT_START;
       /*total length set to zero*/
@@ -3630,8 +8612,50 @@ void hci_le_connection_complete_event(uint8_t Status,
                                       uint16_t Supervision_Timeout,
                                       uint8_t Master_Clock_Accuracy)
 {
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  BLE_AdvertisingStop();
+  
+  if(Status != (uint8_t)BLE_STATUS_SUCCESS) {
+    /* The high duty cycle directed advertising is expired (0x3C): continue with the undirected one */
+    if(BleAdvSchedule.Step==BLE_ADV_STEP_DIRECTED) {
+      BleAdvSchedule.Step = BLE_AdvertisingUndirectedStep();
+    }
+    set_connectable = TRUE;
+    return;
+  }
+  
+  if(BleAdvSchedule.WaitingConnection) {
+    uint32_t TimeToConnect = BleAdvSchedule.LastAccountTick - BleAdvSchedule.WaitingStartTick;
+    
+    BleAdvSchedule.WaitingConnection = 0U;
+    BleAdvSchedule.Stats.Connections++;
+    BleAdvSchedule.Stats.LastTimeToConnect = TimeToConnect;
+    if(TimeToConnect > BleAdvSchedule.Stats.MaxTimeToConnect) {
+      BleAdvSchedule.Stats.MaxTimeToConnect = TimeToConnect;
+    }
+    BleAdvSchedule.SumTimeToConnect += TimeToConnect;
+    BleAdvSchedule.Stats.AvgTimeToConnect = (uint32_t)(BleAdvSchedule.SumTimeToConnect / BleAdvSchedule.Stats.Connections);
+  }
+  
+  /* Candidate target of the directed advertising (used once bonded) */
+  BleAdvSchedule.ConnectedPeerAddressType = Peer_Address_Type;
+  BLE_MemCpy(BleAdvSchedule.ConnectedPeerAddress,Peer_Address,6);
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+  
   connection_handle = Connection_Handle;
   
+#ifdef BLE_MANAGER_CONN_TUNER
+  if(Status == (uint8_t)BLE_STATUS_SUCCESS) {
+    BLE_ConnTunerConnected(Conn_Interval,Conn_Latency,Supervision_Timeout);
+  }
+#endif /* BLE_MANAGER_CONN_TUNER */
+  
+#ifdef BLE_MANAGER_TX_CREDITS
+  BLE_TxCreditsReset();
+#endif /* BLE_MANAGER_TX_CREDITS */
+  
+  BLE_MEM_PHASE_ENTER(BLE_MEM_PHASE_CONNECTION);
+  
   BLE_MANAGER_PRINTF(">>>>>>CONNECTED %x:%x:%x:%x:%x:%x\r\n",Peer_Address[5],Peer_Address[4],Peer_Address[3],Peer_Address[2],Peer_Address[1],Peer_Address[0]);
 
 #if (BLUE_CORE != BLUENRG_MS)
@@ -3653,6 +8677,9 @@ void hci_le_connection_complete_event(uint8_t Status,
 #if (BLE_DEBUG_LEVEL>1)
       BLE_MANAGER_PRINTF("Device already bounded\r\n");
 #endif
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+      BLE_AdvertisingSetBondedPeer();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
     }
   }
 #endif /* (BLUE_CORE != BLUENRG_MS) */
@@ -3690,6 +8717,39 @@ void hci_disconnection_complete_event(uint8_t Status,
   /* No Device Connected */
   connection_handle =0;
   
+#ifdef BLE_MANAGER_CONN_TUNER
+  BleConnTuner.Connected = 0U;
+#endif /* BLE_MANAGER_CONN_TUNER */
+  
+#ifdef BLE_MANAGER_RADIO_SYNC
+  /* The queued notifications are lost with the connection */
+  BleRadioSync.EntriesNumber = 0U;
+  BleRadioSync.DataLength = 0U;
+#endif /* BLE_MANAGER_RADIO_SYNC */
+  
+#ifdef BLE_MANAGER_TX_CREDITS
+  /* The controller flushes the packets of the connection */
+  BLE_TxCreditsReset();
+#endif /* BLE_MANAGER_TX_CREDITS */
+  
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+  /* The write requests of this central are not run for the next one */
+  BLE_DeferredFlush();
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+  
+#ifdef BLE_MANAGER_EXTCONFIG_CBOR
+  /* The next central chooses again the Extended Configuration encoding */
+  ExtConfigCborEncoding = 0U;
+  ExtConfigEncodingSet = 0U;
+#endif /* BLE_MANAGER_EXTCONFIG_CBOR */
+  
+  BLE_MEM_PHASE_EXIT(BLE_MEM_PHASE_CONNECTION);
+  
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  /* Fast advertising after the disconnection */
+  BLE_AdvertisingReset();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+  
   BLE_MANAGER_PRINTF("<<<<<<DISCONNECTED\r\n");
   
   /* Make the device connectable again. */
@@ -3769,6 +8829,7 @@ void aci_gatt_attribute_modified_event(uint16_t Connection_Handle,
 {
   uint32_t FoundHandle=0;
   uint8_t RegisteredHandle;
+  BLE_PROFILE_START(ProfileStart);
   
   if (Attr_Handle==((uint16_t)(0x0002+2))) {
     BLE_MANAGER_PRINTF("Notification on Service Change Characteristic\r\n");
@@ -3811,7 +8872,13 @@ void aci_gatt_attribute_modified_event(uint16_t Connection_Handle,
       if(BleCharsArray[RegisteredHandle]->Write_Request_CB!=NULL) {
         if(Attr_Handle==(BleCharsArray[RegisteredHandle]->attr_handle+1U)) {
           FoundHandle = 1U;
-          BleCharsArray[RegisteredHandle]->Write_Request_CB(BleCharsArray[RegisteredHandle],Attr_Handle, Offset, Attr_Data_Length, Attr_Data);
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+          /* Run by BLE_DeferredProcess (or now if the queue is full) */
+          if(BLE_DeferredPost(BleCharsArray[RegisteredHandle],Attr_Handle, Offset, Attr_Data_Length, Attr_Data)==0U)
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+          {
+            BleCharsArray[RegisteredHandle]->Write_Request_CB(BleCharsArray[RegisteredHandle],Attr_Handle, Offset, Attr_Data_Length, Attr_Data);
+          }
         }
       }
     }
@@ -3825,11 +8892,13 @@ void aci_gatt_attribute_modified_event(uint16_t Connection_Handle,
       BLE_MANAGER_PRINTF("Notification UNKNOWN handle =%d\r\n",Attr_Handle);
     }
   }
+  BLE_PROFILE_STOP(BLE_PROFILE_ATTR_MODIFIED,ProfileStart);
 }
 
-#if (BLUE_CORE == BLUENRG_LP)
+#if ((BLUE_CORE == BLUENRG_LP) || defined(BLE_MANAGER_FAST_RECONNECT))
 /**
 * @brief  This event indicates that a new connection has been created
+*         (BlueNRG-1/2: given with the controller privacy of BLE_MANAGER_FAST_RECONNECT)
 *
 * @param  See file bluenrg_lp_events.h
 * @retval See file bluenrg_lp_events.h
@@ -3846,18 +8915,20 @@ void hci_le_enhanced_connection_complete_event(uint8_t Status,
                                                uint16_t Supervision_Timeout,
                                                uint8_t Master_Clock_Accuracy)
 {
-  
+  /* 0x02/0x03: identity address resolved by the controller (public/random static) */
   hci_le_connection_complete_event(Status,
                                    Connection_Handle,
                                    Role,
-                                   Peer_Address_Type,
+                                   (uint8_t)(Peer_Address_Type & 0x01U),
                                    Peer_Address,
                                    Conn_Interval,
                                    Conn_Latency,
                                    Supervision_Timeout,
                                    Master_Clock_Accuracy);
 }
+#endif /* ((BLUE_CORE == BLUENRG_LP) || defined(BLE_MANAGER_FAST_RECONNECT)) */
 
+#if (BLUE_CORE == BLUENRG_LP)
 
 /**
 * @brief  This event is given when an attribute changes his value
@@ -3956,8 +9027,15 @@ void aci_gap_pairing_complete_event(uint16_t ConnectionHandle, uint8_t status, u
     case 0x00: //Success
       BLE_MANAGER_PRINTF("aci_gap_pairing_complete_event %s\r\n", StatusString[status]);
 #if (BLUE_CORE != BLUENRG_MS)
+#ifdef BLE_MANAGER_FAST_RECONNECT
+      BLE_ReconnectRefresh();
+#else /* BLE_MANAGER_FAST_RECONNECT */
       UpdateWhiteList();
+#endif /* BLE_MANAGER_FAST_RECONNECT */
 #endif /* (BLUE_CORE != BLUENRG_MS) */
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+      BLE_AdvertisingSetBondedPeer();
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
       BLE_MANAGER_DELAY(100);
       break;
     case 0x02: //Pairing Failed
@@ -4010,7 +9088,41 @@ void aci_l2cap_connection_update_resp_event(uint16_t Connection_Handle,
 #if (BLE_DEBUG_LEVEL>2)
   BLE_MANAGER_PRINTF("aci_l2cap_connection_update_resp_event Result=%d\r\n",Result);
 #endif
+#ifdef BLE_MANAGER_CONN_TUNER
+  if(BleConnTuner.RequestPending) {
+    if(Result==0U) {
+      /* Accepted: the central will update the connection */
+      BleConnTuner.RequestPending = 0U;
+      BleConnTuner.RetryDelay = BLE_CONN_TUNER_RETRY_MIN;
+      BleConnTuner.Stats.Profile = BleConnTuner.RequestedProfile;
+      BleConnTuner.Stats.Accepted++;
+    } else {
+      BleConnTuner.Stats.Rejected++;
+      BLE_ConnTunerBackOff();
+    }
+  }
+#endif /* BLE_MANAGER_CONN_TUNER */
+}
+
+#ifdef BLE_MANAGER_CONN_TUNER
+/*******************************************************************************
+* Function Name  : aci_l2cap_proc_timeout_event
+* Description    : This event is generated when the master does not respond to
+*                  the connection update request packet within 30 seconds
+* Input          : See file bluenrg1_events.h
+* Output         : See file bluenrg1_events.h
+* Return         : See file bluenrg1_events.h
+*******************************************************************************/
+void aci_l2cap_proc_timeout_event(uint16_t Connection_Handle,
+                                  uint8_t Data_Length,
+                                  uint8_t Data[])
+{
+  if(BleConnTuner.RequestPending) {
+    BleConnTuner.Stats.Timeouts++;
+    BLE_ConnTunerBackOff();
+  }
 }
+#endif /* BLE_MANAGER_CONN_TUNER */
 
 /*******************************************************************************
 * Function Name  : hci_le_connection_update_complete_event
@@ -4032,6 +9144,13 @@ void hci_le_connection_update_complete_event(uint8_t Status,
   BLE_MANAGER_PRINTF("\tConn_Latency=%d\r\n",Conn_Latency);
   BLE_MANAGER_PRINTF("\tSupervision_Timeout=%d\r\n",Supervision_Timeout);
 #endif
+#ifdef BLE_MANAGER_CONN_TUNER
+  if(Status == (uint8_t)BLE_STATUS_SUCCESS) {
+    BleConnTuner.Stats.ConnInterval = Conn_Interval;
+    BleConnTuner.Stats.ConnLatency = Conn_Latency;
+    BleConnTuner.Stats.SupervisionTimeout = Supervision_Timeout;
+  }
+#endif /* BLE_MANAGER_CONN_TUNER */
 }
 
 /*******************************************************************************
@@ -4381,6 +9500,15 @@ After this event is recommended to force device reset.
 */
 void hci_hardware_error_event(uint8_t Hardware_Code)
 {
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  BleRecovery.HardwareErrors++;
+  BleRecovery.LastHardwareCode = Hardware_Code;
+  if(BleRecoveryArmed) {
+    /* Served by BLE_StackRecoveryProcess outside the HCI event processing */
+    BleRecoveryRequested = 1U;
+    return;
+  }
+#endif /* BLE_MANAGER_STACK_RECOVERY */
   if(CustomHardwareErrorEventHandler!=NULL)
   {
     CustomHardwareErrorEventHandler(Hardware_Code);
@@ -4417,6 +9545,7 @@ void aci_gap_bond_lost_event(void) {
 #endif
 }
 
+#ifndef BLE_MANAGER_FAST_RECONNECT
 /**
 * @brief  This function Updates the White list for BLE Connection
 * @param None
@@ -4455,6 +9584,7 @@ static void UpdateWhiteList(void)
     }
   }
 }
+#endif /* BLE_MANAGER_FAST_RECONNECT */
 
 /*******************************************************************************
 * Function Name  : aci_gap_numeric_comparison_value_event
@@ -4490,3 +9620,133 @@ void hci_encryption_change_event(uint8_t Status,uint16_t Connection_Handle,uint8
 }
 #endif /* (BLUE_CORE != BLUENRG_MS) */
 
+#if (BLUE_CORE == BLUENRG_1_2)
+#ifdef BLE_MANAGER_STATS
+/*******************************************************************************
+* Function Name  : aci_blue_events_lost_event
+* Description    : This event is generated when the device completes a radio
+*                  activity but one or more events have been lost
+* Input          : See file bluenrg1_events.h
+* Output         : See file bluenrg1_events.h
+* Return         : See file bluenrg1_events.h
+*******************************************************************************/
+void aci_blue_events_lost_event(uint8_t Lost_Events[8])
+{
+  BLE_HciStats.EventsLost++;
+#if (BLE_DEBUG_LEVEL>1)
+  BLE_MANAGER_PRINTF("aci_blue_events_lost_event %02X%02X%02X%02X%02X%02X%02X%02X\r\n",
+                     Lost_Events[7],Lost_Events[6],Lost_Events[5],Lost_Events[4],
+                     Lost_Events[3],Lost_Events[2],Lost_Events[1],Lost_Events[0]);
+#endif
+}
+#endif /* BLE_MANAGER_STATS */
+
+#ifdef BLE_MANAGER_FAST_BOOT
+/*******************************************************************************
+* Function Name  : aci_blue_initialized_event
+* Description    : This event is generated when the BlueNRG is operational
+*                  after its reset
+* Input          : See file bluenrg1_events.h
+* Output         : See file bluenrg1_events.h
+* Return         : See file bluenrg1_events.h
+*******************************************************************************/
+void aci_blue_initialized_event(uint8_t Reason_Code)
+{
+  BleBootReport.ReadyReason = Reason_Code;
+  BleBootReady = 1U;
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  if(BleRecoveryArmed) {
+    /* The BlueNRG has reset itself (crash, watchdog...) and its GATT database is lost */
+    BleRecovery.ControllerResets++;
+    BleRecovery.LastResetReason = Reason_Code;
+    BleRecoveryRequested = 1U;
+  }
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+#if (BLE_DEBUG_LEVEL>1)
+  BLE_MANAGER_PRINTF("aci_blue_initialized_event Reason_Code=%x\r\n",Reason_Code);
+#endif
+}
+#endif /* BLE_MANAGER_FAST_BOOT */
+
+#ifdef BLE_MANAGER_STACK_RECOVERY
+/*******************************************************************************
+* Function Name  : aci_blue_crash_info_event
+* Description    : This event is generated after a BlueNRG reset caused by
+*                  one crash of its firmware
+* Input          : See file bluenrg1_events.h
+* Output         : See file bluenrg1_events.h
+* Return         : See file bluenrg1_events.h
+*******************************************************************************/
+void aci_blue_crash_info_event(uint8_t Crash_Type,
+                               uint32_t SP,
+                               uint32_t R0,
+                               uint32_t R1,
+                               uint32_t R2,
+                               uint32_t R3,
+                               uint32_t R12,
+                               uint32_t LR,
+                               uint32_t PC,
+                               uint32_t xPSR,
+                               uint8_t Debug_Data_Length,
+                               uint8_t Debug_Data[])
+{
+  BleRecovery.CrashInfos++;
+  BLE_MANAGER_PRINTF("BlueNRG crash Type=%x PC=%lx LR=%lx SP=%lx\r\n",
+                     Crash_Type,(unsigned long)PC,(unsigned long)LR,(unsigned long)SP);
+}
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+
+#ifdef BLE_MANAGER_RADIO_SYNC
+/*******************************************************************************
+* Function Name  : aci_hal_end_of_radio_activity_event
+* Description    : This event is generated when the BlueNRG completes a radio
+*                  activity (only the connection events are enabled)
+* Input          : See file bluenrg1_events.h
+* Output         : See file bluenrg1_events.h
+* Return         : See file bluenrg1_events.h
+*******************************************************************************/
+void aci_hal_end_of_radio_activity_event(uint8_t Last_State,
+                                         uint8_t Next_State,
+                                         uint32_t Next_State_SysTime)
+{
+  if(Last_State != BLE_RADIO_SYNC_CONNECTION_EVENT) {
+    return;
+  }
+  
+  BleRadioSync.Stats.ConnectionEvents++;
+  
+  /* Fill the controller buffer for the next anchor point */
+  BLE_RadioSyncFlush();
+  
+  if(CustomEndOfConnectionEvent != NULL) {
+    CustomEndOfConnectionEvent(Next_State_SysTime);
+  }
+}
+#endif /* BLE_MANAGER_RADIO_SYNC */
+
+#ifdef BLE_MANAGER_TX_CREDITS
+/*******************************************************************************
+* Function Name  : hci_number_of_completed_packets_event
+* Description    : This event is generated when the controller has transmitted
+*                  (or flushed) data packets
+* Input          : See file bluenrg1_events.h
+* Output         : See file bluenrg1_events.h
+* Return         : See file bluenrg1_events.h
+*******************************************************************************/
+void hci_number_of_completed_packets_event(uint8_t Number_of_Handles,
+                                           Handle_Packets_Pair_Entry_t Handle_Packets_Pair_Entry[])
+{
+  uint32_t Index;
+  
+  for(Index=0; Index<Number_of_Handles; Index++) {
+    if(Handle_Packets_Pair_Entry[Index].Connection_Handle == connection_handle) {
+      uint32_t Available = (uint32_t)BleTxCredits.Available + Handle_Packets_Pair_Entry[Index].HC_Num_Of_Completed_Packets;
+      
+      BleTxCredits.Available = (uint16_t)((Available > BleTxCredits.Total) ? BleTxCredits.Total : Available);
+      BleTxCredits.Completed += Handle_Packets_Pair_Entry[Index].HC_Num_Of_Completed_Packets;
+      BleTxCreditsTracking = 1U;
+    }
+  }
+}
+#endif /* BLE_MANAGER_TX_CREDITS */
+#endif /* (BLUE_CORE == BLUENRG_1_2) */
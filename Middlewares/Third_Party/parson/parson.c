@@ -46,6 +46,26 @@
 #include <ctype.h>
 #include <math.h>
 #include <errno.h>
+#ifdef PARSON_FAST_NUMBERS
+#include <stdint.h>
+#endif
+
+/* On Linux hosts json_parse_file parses a read-only mapping of the file instead of a heap copy */
+#if defined(__linux__) && !defined(PARSON_NO_MMAP)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef MAP_ANONYMOUS /* not declared in strict ISO C builds */
+#define PARSON_MMAP
+#endif
+#endif
+
+/* SSE2 fast paths for the string scanning loops (the portable word-at-a-time version is used otherwise) */
+#if defined(__SSE2__) && defined(__GNUC__) && !defined(PARSON_NO_SSE2)
+#define PARSON_SSE2
+#include <emmintrin.h>
+#endif
 
 /* Apparently sscanf is not implemented in some "standard" libraries, so don't use it, if you
  * don't have to. */
@@ -71,6 +91,12 @@
 #define PARSON_NUM_BUF_SIZE 64 /* double printed with "%1.17g" shouldn't be longer than 25 bytes so let's be paranoid and use 64 */
 #endif
 
+#ifndef PARSON_WRITER_CHUNK_SIZE
+#define PARSON_WRITER_CHUNK_SIZE 64 /* single-pass serialization output is buffered in chunks of this size */
+#endif
+
+#define GROWABLE_BUFFER_STARTING_CAPACITY 256
+
 #define SIZEOF_TOKEN(a)       (sizeof(a) - 1)
 #define SKIP_CHAR(str)        ((*str)++)
 #define SKIP_WHITESPACES(str) while (isspace((unsigned char)(**str))) { SKIP_CHAR(str); }
@@ -96,6 +122,13 @@ static char *parson_float_format = NULL;
 
 #define IS_CONT(b) (((unsigned char)(b) & 0xC0) == 0x80) /* is utf-8 continuation byte */
 
+/* Word-at-a-time (SWAR) byte tests, exact when telling whether any byte in the word matches */
+#define SWAR_ONES            ((size_t)-1 / 0xFF)
+#define SWAR_HIGHS           (SWAR_ONES * 0x80)
+#define SWAR_HAS_ZERO(w)     (((w) - SWAR_ONES) & ~(w) & SWAR_HIGHS)
+#define SWAR_HAS_LESS(w, n)  (((w) - SWAR_ONES * (n)) & ~(w) & SWAR_HIGHS) /* n <= 128 */
+#define SWAR_HAS_BYTE(w, b)  SWAR_HAS_ZERO((w) ^ (SWAR_ONES * (b)))
+
 typedef int parson_bool_t;
 
 #define PARSON_TRUE 1
@@ -106,6 +139,22 @@ typedef struct json_string {
     size_t length;
 } JSON_String;
 
+/* Single-pass serializer state */
+typedef struct json_writer {
+    JSON_Output_Function output;
+    void *context;
+    parson_bool_t is_pretty;
+    const char *float_format;
+    size_t used;
+    char chunk[PARSON_WRITER_CHUNK_SIZE];
+} JSON_Writer;
+
+typedef struct json_fixed_buffer {
+    char *buf;
+    size_t size;
+    size_t used;
+} JSON_Fixed_Buffer;
+
 /* Type definitions */
 typedef union json_value_value {
     JSON_String  string;
@@ -132,6 +181,8 @@ struct json_object_t {
     size_t         count;
     size_t         item_capacity;
     size_t         cell_capacity;
+    const char    *insitu_start; /* names and strings inside [insitu_start, insitu_end) are not owned */
+    const char    *insitu_end;
 };
 
 struct json_array_t {
@@ -139,10 +190,17 @@ struct json_array_t {
     JSON_Value **items;
     size_t       count;
     size_t       capacity;
+    const char  *insitu_start; /* strings inside [insitu_start, insitu_end) are not owned */
+    const char  *insitu_end;
 };
 
 /* Various */
 static char * read_file(const char *filename);
+#ifdef PARSON_MMAP
+static char * map_file(const char *filename, size_t *map_size);
+#endif
+static char * load_file(const char *filename, size_t *map_size);
+static void   unload_file(char *file_contents, size_t map_size);
 static void   remove_comments(char *string, const char *start_token, const char *end_token);
 static char * parson_strndup(const char *string, size_t n);
 static char * parson_strdup(const char *string);
@@ -151,8 +209,16 @@ static JSON_Status parse_utf16_hex(const char *string, unsigned int *result);
 static int         num_bytes_in_utf8_sequence(unsigned char c);
 static JSON_Status   verify_utf8_sequence(const unsigned char *string, int *len);
 static parson_bool_t is_valid_utf8(const char *string, size_t string_len);
+static size_t        ascii_prefix_len(const char *string, size_t len);
+static size_t        plain_prefix_len(const char *string, size_t len);
 static parson_bool_t is_decimal(const char *string, size_t length);
 static unsigned long hash_string(const char *string, size_t n);
+static double        parson_strtod(const char *string, char **end);
+static int           serialize_number(double num, char *buf);
+#ifdef PARSON_FAST_NUMBERS
+static int           grisu2(double value, char *digits, int *K);
+static int           serialize_number_shortest(double num, char *buf);
+#endif
 
 /* JSON Object */
 static JSON_Object * json_object_make(JSON_Value *wrapping_value);
@@ -162,6 +228,7 @@ static JSON_Status   json_object_grow_and_rehash(JSON_Object *object);
 static size_t        json_object_get_cell_ix(const JSON_Object *object, const char *key, size_t key_len, unsigned long hash, parson_bool_t *out_found);
 static JSON_Status   json_object_add(JSON_Object *object, char *name, JSON_Value *value);
 static JSON_Value  * json_object_getn_value(const JSON_Object *object, const char *name, size_t name_len);
+static JSON_Value  * json_object_getn_value_hashed(const JSON_Object *object, const char *name, size_t name_len, unsigned long hash);
 static JSON_Status   json_object_remove_internal(JSON_Object *object, const char *name, parson_bool_t free_value);
 static JSON_Status   json_object_dotremove_internal(JSON_Object *object, const char *name, parson_bool_t free_value);
 static void          json_object_free(JSON_Object *object);
@@ -175,25 +242,48 @@ static void         json_array_free(JSON_Array *array);
 /* JSON Value */
 static JSON_Value * json_value_init_string_no_copy(char *string, size_t length);
 static const JSON_String * json_value_get_string_desc(const JSON_Value *value);
+static parson_bool_t is_insitu_string(const JSON_Value *container, const char *string);
 
 /* Parser */
 static JSON_Status   skip_quotes(const char **string);
 static JSON_Status   parse_utf16(const char **unprocessed, char **processed);
+static JSON_Status   unescape_string(const char *input, size_t input_len, char *output, size_t *output_len);
 static char *        process_string(const char *input, size_t input_len, size_t *output_len);
-static char *        get_quoted_string(const char **string, size_t *output_string_len);
-static JSON_Value *  parse_object_value(const char **string, size_t nesting);
-static JSON_Value *  parse_array_value(const char **string, size_t nesting);
-static JSON_Value *  parse_string_value(const char **string);
+static char *        get_quoted_string(const char **string, size_t *output_string_len, parson_bool_t insitu);
+static void          free_parsed_value(JSON_Value *value, parson_bool_t insitu);
+static JSON_Value *  parse_object_value(const char **string, size_t nesting, parson_bool_t insitu);
+static JSON_Value *  parse_array_value(const char **string, size_t nesting, parson_bool_t insitu);
+static JSON_Value *  parse_string_value(const char **string, parson_bool_t insitu);
 static JSON_Value *  parse_boolean_value(const char **string);
 static JSON_Value *  parse_number_value(const char **string);
 static JSON_Value *  parse_null_value(const char **string);
-static JSON_Value *  parse_value(const char **string, size_t nesting);
+static JSON_Value *  parse_value(const char **string, size_t nesting, parson_bool_t insitu);
 
 /* Serialization */
 static int json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int level, parson_bool_t is_pretty, char *num_buf);
 static int json_serialize_string(const char *string, size_t len, char *buf);
 static int append_indent(char *buf, int level);
 static int append_string(char *buf, const char *string);
+static JSON_Status json_writer_put(JSON_Writer *writer, const char *data, size_t len);
+static JSON_Status json_writer_flush(JSON_Writer *writer);
+static JSON_Status json_writer_string(JSON_Writer *writer, const char *string, size_t len);
+static JSON_Status json_writer_number(JSON_Writer *writer, double num);
+static JSON_Status json_writer_indent(JSON_Writer *writer, int level);
+static JSON_Status json_serialize_to_writer_r(const JSON_Value *value, JSON_Writer *writer, int level);
+static JSON_Status json_serialize_to_writer(const JSON_Value *value, JSON_Output_Function output, void *context,
+                                            int is_pretty, const char *float_format);
+static JSON_Status growable_buffer_output(void *context, const char *data, size_t len);
+static JSON_Status fixed_buffer_output(void *context, const char *data, size_t len);
+
+/* Pull parser */
+static JSON_Token_Type reader_error(JSON_Reader *reader);
+static JSON_Token_Type reader_push(JSON_Reader *reader, parson_bool_t is_object, JSON_Token_Type type);
+static JSON_Token_Type reader_pop(JSON_Reader *reader, parson_bool_t is_object, JSON_Token_Type type);
+static parson_bool_t   reader_in_object(const JSON_Reader *reader);
+static JSON_Token_Type reader_scan_string(JSON_Reader *reader, JSON_Token_Type type);
+static JSON_Token_Type reader_scan_value(JSON_Reader *reader);
+static size_t          reader_decode_char(const char **token_ptr, char *decoded);
+static parson_bool_t   reader_token_equals_n(const JSON_Reader *reader, const char *string, size_t len);
 
 /* Various */
 static char * read_file(const char * filename) {
@@ -229,6 +319,65 @@ static char * read_file(const char * filename) {
     return file_contents;
 }
 
+#ifdef PARSON_MMAP
+/* Maps a regular file read-only on a zero-filled reservation one byte longer than the file,
+   so that the mapping is a null terminated string */
+static char * map_file(const char *filename, size_t *map_size) {
+    struct stat file_stat;
+    long page_size = sysconf(_SC_PAGESIZE);
+    char *file_contents = NULL;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (page_size <= 0 || fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    *map_size = ((size_t)file_stat.st_size / (size_t)page_size + 1) * (size_t)page_size;
+    file_contents = (char*)mmap(NULL, *map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (file_contents == (char*)MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if (file_stat.st_size > 0 &&
+        mmap(file_contents, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(file_contents, *map_size);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(file_contents, *map_size, MADV_SEQUENTIAL);
+#endif
+    return file_contents;
+}
+#endif
+
+/* Null terminated file contents: map_size is 0 for a heap copy */
+static char * load_file(const char *filename, size_t *map_size) {
+#ifdef PARSON_MMAP
+    char *file_contents = map_file(filename, map_size);
+    if (file_contents != NULL) {
+        return file_contents;
+    }
+#endif
+    *map_size = 0;
+    return read_file(filename);
+}
+
+static void unload_file(char *file_contents, size_t map_size) {
+#ifdef PARSON_MMAP
+    if (map_size > 0) {
+        munmap(file_contents, map_size);
+        return;
+    }
+#else
+    (void)map_size;
+#endif
+    parson_free(file_contents);
+}
+
 static void remove_comments(char *string, const char *start_token, const char *end_token) {
     parson_bool_t in_string = PARSON_FALSE, escaped = PARSON_FALSE;
     size_t i;
@@ -367,6 +516,10 @@ static int is_valid_utf8(const char *string, size_t string_len) {
     int len = 0;
     const char *string_end =  string + string_len;
     while (string < string_end) {
+        string += ascii_prefix_len(string, (size_t)(string_end - string));
+        if (string == string_end) {
+            break;
+        }
         if (verify_utf8_sequence((const unsigned char*)string, &len) != JSONSuccess) {
             return PARSON_FALSE;
         }
@@ -375,6 +528,72 @@ static int is_valid_utf8(const char *string, size_t string_len) {
     return PARSON_TRUE;
 }
 
+/* Number of leading 7-bit ASCII chars */
+static size_t ascii_prefix_len(const char *string, size_t len) {
+    size_t i = 0;
+    size_t word = 0;
+#ifdef PARSON_SSE2
+    int mask = 0;
+    for (; (i + 16) <= len; i += 16) {
+        mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(string + i)));
+        if (mask) {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+#endif
+    for (; (i + sizeof(word)) <= len; i += sizeof(word)) {
+        memcpy(&word, string + i, sizeof(word));
+        if (word & SWAR_HIGHS) {
+            break;
+        }
+    }
+    while (i < len && ((unsigned char)string[i] & 0x80) == 0) {
+        i++;
+    }
+    return i;
+}
+
+/* Number of leading chars serialized as they are (no control chars, quotes, backslashes or escaped slashes) */
+static size_t plain_prefix_len(const char *string, size_t len) {
+    size_t i = 0;
+    size_t word = 0;
+    unsigned char c = 0;
+#ifdef PARSON_SSE2
+    const __m128i sign = _mm_set1_epi8((char)0x80);
+    const __m128i control = _mm_set1_epi8((char)(0x20 ^ 0x80));
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i slash = _mm_set1_epi8(parson_escape_slashes ? '/' : '\"');
+    __m128i chunk, special;
+    int mask = 0;
+    for (; (i + 16) <= len; i += 16) {
+        chunk = _mm_loadu_si128((const __m128i*)(string + i));
+        special = _mm_cmplt_epi8(_mm_xor_si128(chunk, sign), control); /* unsigned chunk < 0x20 */
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, quote));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, slash));
+        mask = _mm_movemask_epi8(special);
+        if (mask) {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+#endif
+    for (; (i + sizeof(word)) <= len; i += sizeof(word)) {
+        memcpy(&word, string + i, sizeof(word));
+        if (SWAR_HAS_LESS(word, 0x20) || SWAR_HAS_BYTE(word, '\"') || SWAR_HAS_BYTE(word, '\\') ||
+            (parson_escape_slashes && SWAR_HAS_BYTE(word, '/'))) {
+            break;
+        }
+    }
+    for (; i < len; i++) {
+        c = (unsigned char)string[i];
+        if (c < 0x20 || c == '\"' || c == '\\' || (c == '/' && parson_escape_slashes)) {
+            break;
+        }
+    }
+    return i;
+}
+
 static parson_bool_t is_decimal(const char *string, size_t length) {
     if (length > 1 && string[0] == '0' && string[1] != '.') {
         return PARSON_FALSE;
@@ -410,6 +629,343 @@ static unsigned long hash_string(const char *string, size_t n) {
 #endif
 }
 
+/* Numbers */
+#ifdef PARSON_FAST_NUMBERS
+typedef struct parson_diy_fp {
+    uint64_t f;
+    int      e;
+} parson_diy_fp;
+
+/* Normalized 10^k, k = -348, -340, ..., 340 */
+static const uint64_t parson_cached_powers_f[] = {
+    UINT64_C(0xFA8FD5A0081C0288), UINT64_C(0xBAAEE17FA23EBF76), UINT64_C(0x8B16FB203055AC76),
+    UINT64_C(0xCF42894A5DCE35EA), UINT64_C(0x9A6BB0AA55653B2D), UINT64_C(0xE61ACF033D1A45DF),
+    UINT64_C(0xAB70FE17C79AC6CA), UINT64_C(0xFF77B1FCBEBCDC4F), UINT64_C(0xBE5691EF416BD60C),
+    UINT64_C(0x8DD01FAD907FFC3C), UINT64_C(0xD3515C2831559A83), UINT64_C(0x9D71AC8FADA6C9B5),
+    UINT64_C(0xEA9C227723EE8BCB), UINT64_C(0xAECC49914078536D), UINT64_C(0x823C12795DB6CE57),
+    UINT64_C(0xC21094364DFB5637), UINT64_C(0x9096EA6F3848984F), UINT64_C(0xD77485CB25823AC7),
+    UINT64_C(0xA086CFCD97BF97F4), UINT64_C(0xEF340A98172AACE5), UINT64_C(0xB23867FB2A35B28E),
+    UINT64_C(0x84C8D4DFD2C63F3B), UINT64_C(0xC5DD44271AD3CDBA), UINT64_C(0x936B9FCEBB25C996),
+    UINT64_C(0xDBAC6C247D62A584), UINT64_C(0xA3AB66580D5FDAF6), UINT64_C(0xF3E2F893DEC3F126),
+    UINT64_C(0xB5B5ADA8AAFF80B8), UINT64_C(0x87625F056C7C4A8B), UINT64_C(0xC9BCFF6034C13053),
+    UINT64_C(0x964E858C91BA2655), UINT64_C(0xDFF9772470297EBD), UINT64_C(0xA6DFBD9FB8E5B88F),
+    UINT64_C(0xF8A95FCF88747D94), UINT64_C(0xB94470938FA89BCF), UINT64_C(0x8A08F0F8BF0F156B),
+    UINT64_C(0xCDB02555653131B6), UINT64_C(0x993FE2C6D07B7FAC), UINT64_C(0xE45C10C42A2B3B06),
+    UINT64_C(0xAA242499697392D3), UINT64_C(0xFD87B5F28300CA0E), UINT64_C(0xBCE5086492111AEB),
+    UINT64_C(0x8CBCCC096F5088CC), UINT64_C(0xD1B71758E219652C), UINT64_C(0x9C40000000000000),
+    UINT64_C(0xE8D4A51000000000), UINT64_C(0xAD78EBC5AC620000), UINT64_C(0x813F3978F8940984),
+    UINT64_C(0xC097CE7BC90715B3), UINT64_C(0x8F7E32CE7BEA5C70), UINT64_C(0xD5D238A4ABE98068),
+    UINT64_C(0x9F4F2726179A2245), UINT64_C(0xED63A231D4C4FB27), UINT64_C(0xB0DE65388CC8ADA8),
+    UINT64_C(0x83C7088E1AAB65DB), UINT64_C(0xC45D1DF942711D9A), UINT64_C(0x924D692CA61BE758),
+    UINT64_C(0xDA01EE641A708DEA), UINT64_C(0xA26DA3999AEF774A), UINT64_C(0xF209787BB47D6B85),
+    UINT64_C(0xB454E4A179DD1877), UINT64_C(0x865B86925B9BC5C2), UINT64_C(0xC83553C5C8965D3D),
+    UINT64_C(0x952AB45CFA97A0B3), UINT64_C(0xDE469FBD99A05FE3), UINT64_C(0xA59BC234DB398C25),
+    UINT64_C(0xF6C69A72A3989F5C), UINT64_C(0xB7DCBF5354E9BECE), UINT64_C(0x88FCF317F22241E2),
+    UINT64_C(0xCC20CE9BD35C78A5), UINT64_C(0x98165AF37B2153DF), UINT64_C(0xE2A0B5DC971F303A),
+    UINT64_C(0xA8D9D1535CE3B396), UINT64_C(0xFB9B7CD9A4A7443C), UINT64_C(0xBB764C4CA7A44410),
+    UINT64_C(0x8BAB8EEFB6409C1A), UINT64_C(0xD01FEF10A657842C), UINT64_C(0x9B10A4E5E9913129),
+    UINT64_C(0xE7109BFBA19C0C9D), UINT64_C(0xAC2820D9623BF429), UINT64_C(0x80444B5E7AA7CF85),
+    UINT64_C(0xBF21E44003ACDD2D), UINT64_C(0x8E679C2F5E44FF8F), UINT64_C(0xD433179D9C8CB841),
+    UINT64_C(0x9E19DB92B4E31BA9), UINT64_C(0xEB96BF6EBADF77D9), UINT64_C(0xAF87023B9BF0EE6B)
+};
+
+static const short parson_cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static const uint64_t parson_pow10[] = {
+    UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+    UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000),
+    UINT64_C(1000000000), UINT64_C(10000000000), UINT64_C(100000000000),
+    UINT64_C(1000000000000), UINT64_C(10000000000000), UINT64_C(100000000000000),
+    UINT64_C(1000000000000000), UINT64_C(10000000000000000), UINT64_C(100000000000000000),
+    UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+};
+
+/* Exactly representable powers of ten */
+static const double parson_exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static parson_diy_fp diy_fp_multiply(parson_diy_fp x, parson_diy_fp y) {
+    const uint64_t mask32 = UINT64_C(0xFFFFFFFF);
+    uint64_t a = x.f >> 32, b = x.f & mask32, c = y.f >> 32, d = y.f & mask32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    parson_diy_fp result;
+    tmp += UINT64_C(1) << 31; /* round */
+    result.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+static parson_diy_fp diy_fp_normalize(parson_diy_fp x) {
+    while ((x.f & (UINT64_C(1) << 63)) == 0) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static void grisu_round(char *digits, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        digits[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* Generates the shortest digits inside the (Mp - delta, Mp) range, as near as possible to W */
+static int grisu_digit_gen(parson_diy_fp W, parson_diy_fp Mp, uint64_t delta, char *digits, int *K) {
+    parson_diy_fp one;
+    uint64_t wp_w = Mp.f - W.f;
+    uint64_t p2 = 0, tmp = 0;
+    uint32_t p1 = 0, d = 0;
+    int kappa = 1, len = 0;
+    one.f = UINT64_C(1) << -Mp.e;
+    one.e = Mp.e;
+    p1 = (uint32_t)(Mp.f >> -one.e);
+    p2 = Mp.f & (one.f - 1);
+    while (kappa < 10 && p1 >= parson_pow10[kappa]) {
+        kappa++;
+    }
+    while (kappa > 0) {
+        d = p1 / (uint32_t)parson_pow10[kappa - 1];
+        p1 %= (uint32_t)parson_pow10[kappa - 1];
+        if (d || len) {
+            digits[len++] = (char)('0' + d);
+        }
+        kappa--;
+        tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            grisu_round(digits, len, delta, tmp, parson_pow10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        d = (uint32_t)(p2 >> -one.e);
+        if (d || len) {
+            digits[len++] = (char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            grisu_round(digits, len, delta, p2, one.f, -kappa < 20 ? wp_w * parson_pow10[-kappa] : 0);
+            return len;
+        }
+    }
+}
+
+/* Shortest digits (Grisu2, up to 17) of a positive finite value = digits * 10^K */
+static int grisu2(double value, char *digits, int *K) {
+    uint64_t bits = 0;
+    parson_diy_fp v, w_m, w_p, c_mk;
+    double dk = 0;
+    int k = 0, index = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    v.f = bits & UINT64_C(0x000FFFFFFFFFFFFF);
+    if ((bits >> 52) & 0x7FF) {
+        v.f += UINT64_C(1) << 52;
+        v.e = (int)((bits >> 52) & 0x7FF) - 1075;
+    } else {
+        v.e = -1074;
+    }
+    /* boundaries of the rounding range of value */
+    w_p.f = (v.f << 1) + 1;
+    w_p.e = v.e - 1;
+    while ((w_p.f & (UINT64_C(1) << 53)) == 0) {
+        w_p.f <<= 1;
+        w_p.e--;
+    }
+    w_p.f <<= 10;
+    w_p.e -= 10;
+    if (v.f == (UINT64_C(1) << 52)) {
+        w_m.f = (v.f << 2) - 1;
+        w_m.e = v.e - 2;
+    } else {
+        w_m.f = (v.f << 1) - 1;
+        w_m.e = v.e - 1;
+    }
+    w_m.f <<= w_m.e - w_p.e;
+    w_m.e = w_p.e;
+    /* cached power of ten bringing the exponent inside [-60, -32] */
+    dk = (-61 - w_p.e) * 0.30102999566398114 + 347;
+    k = (int)dk;
+    if (dk - k > 0.0) {
+        k++;
+    }
+    index = (k >> 3) + 1;
+    *K = -(-348 + index * 8);
+    c_mk.f = parson_cached_powers_f[index];
+    c_mk.e = parson_cached_powers_e[index];
+    v = diy_fp_multiply(diy_fp_normalize(v), c_mk);
+    w_p = diy_fp_multiply(w_p, c_mk);
+    w_m = diy_fp_multiply(w_m, c_mk);
+    w_m.f++;
+    w_p.f--;
+    return grisu_digit_gen(v, w_p, w_p.f - w_m.f, digits, K);
+}
+
+/* Shortest representation that parses back to the same double, "%1.17g" like layout */
+static int serialize_number_shortest(double num, char *buf) {
+    char digits[20];
+    int len = 0, K = 0, point = 0, exponent = 0, written = 0, i = 0;
+    if (num < 0 || (num == 0.0 && 1.0 / num < 0)) {
+        buf[written++] = '-';
+        num = -num;
+    }
+    if (num == 0.0) {
+        buf[written++] = '0';
+        buf[written] = '\0';
+        return written;
+    }
+    len = grisu2(num, digits, &K);
+    point = len + K; /* decimal point position */
+    if (point >= -3 && point <= 17) {
+        if (point <= 0) {
+            buf[written++] = '0';
+            buf[written++] = '.';
+            for (i = point; i < 0; i++) {
+                buf[written++] = '0';
+            }
+        }
+        for (i = 0; i < len || i < point; i++) {
+            if (i == point && point > 0) {
+                buf[written++] = '.';
+            }
+            buf[written++] = i < len ? digits[i] : '0';
+        }
+    } else {
+        exponent = point - 1;
+        buf[written++] = digits[0];
+        if (len > 1) {
+            buf[written++] = '.';
+            memcpy(buf + written, digits + 1, len - 1);
+            written += len - 1;
+        }
+        written += sprintf(buf + written, "e%c%02d", exponent < 0 ? '-' : '+', exponent < 0 ? -exponent : exponent);
+        return written;
+    }
+    buf[written] = '\0';
+    return written;
+}
+#endif /* PARSON_FAST_NUMBERS */
+
+/* strtod with (PARSON_FAST_NUMBERS) a fast path for numbers that are exactly
+   computed with only one floating point operation */
+static double parson_strtod(const char *string, char **end) {
+#ifdef PARSON_FAST_NUMBERS
+    const char *ptr = string;
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0, exp_value = 0, exp_sign = 1;
+    parson_bool_t negative = PARSON_FALSE;
+    double number = 0;
+    if (*ptr == '-') {
+        negative = PARSON_TRUE;
+        ptr++;
+    }
+    if (!isdigit((unsigned char)*ptr) || (ptr[0] == '0' && isdigit((unsigned char)ptr[1]))) {
+        goto slow_path;
+    }
+    while (isdigit((unsigned char)*ptr)) {
+        if (digits >= 19) {
+            goto slow_path;
+        }
+        mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+        digits += mantissa ? 1 : 0;
+        ptr++;
+    }
+    if (*ptr == '.') {
+        ptr++;
+        if (!isdigit((unsigned char)*ptr)) {
+            goto slow_path;
+        }
+        while (isdigit((unsigned char)*ptr)) {
+            if (digits >= 19) {
+                goto slow_path;
+            }
+            mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+            digits += mantissa ? 1 : 0;
+            exponent--;
+            ptr++;
+        }
+    }
+    if (*ptr == 'e' || *ptr == 'E') {
+        ptr++;
+        if (*ptr == '+' || *ptr == '-') {
+            exp_sign = *ptr == '-' ? -1 : 1;
+            ptr++;
+        }
+        if (!isdigit((unsigned char)*ptr)) {
+            goto slow_path;
+        }
+        while (isdigit((unsigned char)*ptr)) {
+            if (exp_value > 1000) {
+                goto slow_path;
+            }
+            exp_value = exp_value * 10 + (*ptr - '0');
+            ptr++;
+        }
+        exponent += exp_sign * exp_value;
+    }
+    if (isalnum((unsigned char)*ptr) || *ptr == '.'
+        || mantissa > (UINT64_C(1) << 53) || exponent < -22 || exponent > 22) {
+        goto slow_path;
+    }
+    number = (double)mantissa;
+    if (exponent < 0) {
+        number /= parson_exact_pow10[-exponent];
+    } else {
+        number *= parson_exact_pow10[exponent];
+    }
+    *end = (char*)ptr;
+    return negative ? -number : number;
+slow_path:
+#endif /* PARSON_FAST_NUMBERS */
+    return strtod(string, end);
+}
+
+/* Serializes a number with the default format, integral values don't need sprintf */
+static int serialize_number(double num, char *buf) {
+    char digits[16];
+    unsigned long integer = 0;
+    int len = 0, written = 0;
+    if (num == floor(num) && num >= -4294967295.0 && num <= 4294967295.0
+        && (num != 0.0 || 1.0 / num > 0)) { /* -0 keeps its sign */
+        if (num < 0) {
+            buf[written++] = '-';
+            num = -num;
+        }
+        integer = (unsigned long)num;
+        do {
+            digits[len++] = (char)('0' + integer % 10);
+            integer /= 10;
+        } while (integer > 0);
+        while (len > 0) {
+            buf[written++] = digits[--len];
+        }
+        buf[written] = '\0';
+        return written;
+    }
+#ifdef PARSON_FAST_NUMBERS
+    return serialize_number_shortest(num, buf);
+#else
+    return sprintf(buf, PARSON_DEFAULT_FLOAT_FORMAT, num);
+#endif /* PARSON_FAST_NUMBERS */
+}
+
 /* JSON Object */
 static JSON_Object * json_object_make(JSON_Value *wrapping_value) {
     JSON_Status res = JSONFailure;
@@ -418,6 +974,8 @@ static JSON_Object * json_object_make(JSON_Value *wrapping_value) {
         return NULL;
     }
     new_obj->wrapping_value = wrapping_value;
+    new_obj->insitu_start = NULL;
+    new_obj->insitu_end = NULL;
     res = json_object_init(new_obj, 0);
     if (res != JSONSuccess) {
         parson_free(new_obj);
@@ -471,7 +1029,7 @@ error:
 static void json_object_deinit(JSON_Object *object, parson_bool_t free_keys, parson_bool_t free_values) {
     unsigned int i = 0;
     for (i = 0; i < object->count; i++) {
-        if (free_keys) {
+        if (free_keys && !is_insitu_string(object->wrapping_value, object->names[i])) {
             parson_free(object->names[i]);
         }
         if (free_values) {
@@ -510,6 +1068,8 @@ static JSON_Status json_object_grow_and_rehash(JSON_Object *object) {
 
     wrapping_value = json_object_get_wrapping_value(object);
     new_object.wrapping_value = wrapping_value;
+    new_object.insitu_start = object->insitu_start;
+    new_object.insitu_end = object->insitu_end;
 
     for (i = 0; i < object->count; i++) {
         key = object->names[i];
@@ -594,15 +1154,19 @@ static JSON_Status json_object_add(JSON_Object *object, char *name, JSON_Value *
 }
 
 static JSON_Value * json_object_getn_value(const JSON_Object *object, const char *name, size_t name_len) {
-    unsigned long hash = 0;
+    if (!object || !name) {
+        return NULL;
+    }
+    return json_object_getn_value_hashed(object, name, name_len, hash_string(name, name_len));
+}
+
+static JSON_Value * json_object_getn_value_hashed(const JSON_Object *object, const char *name, size_t name_len, unsigned long hash) {
     parson_bool_t found = PARSON_FALSE;
     unsigned long cell_ix = 0;
     size_t item_ix = 0;
-    if (!object || !name) {
+    if (!object) {
         return NULL;
     }
-    hash = hash_string(name, name_len);
-    found = PARSON_FALSE;
     cell_ix = json_object_get_cell_ix(object, name, name_len, hash, &found);
     if (!found) {
         return NULL;
@@ -641,7 +1205,9 @@ static JSON_Status json_object_remove_internal(JSON_Object *object, const char *
         val = NULL;
     }
 
-    parson_free(object->names[item_ix]);
+    if (!is_insitu_string(object->wrapping_value, object->names[item_ix])) {
+        parson_free(object->names[item_ix]);
+    }
     last_item_ix = object->count - 1;
     if (item_ix < last_item_ix) {
         object->names[item_ix] = object->names[last_item_ix];
@@ -701,6 +1267,8 @@ static JSON_Array * json_array_make(JSON_Value *wrapping_value) {
     new_array->items = (JSON_Value**)NULL;
     new_array->capacity = 0;
     new_array->count = 0;
+    new_array->insitu_start = NULL;
+    new_array->insitu_end = NULL;
     return new_array;
 }
 
@@ -757,6 +1325,24 @@ static JSON_Value * json_value_init_string_no_copy(char *string, size_t length)
     return new_value;
 }
 
+/* Checks if string was parsed in place (json_parse_string_insitu) inside the source buffer of its container */
+static parson_bool_t is_insitu_string(const JSON_Value *container, const char *string) {
+    const char *start = NULL, *end = NULL;
+    switch (json_value_get_type(container)) {
+        case JSONObject:
+            start = container->value.object->insitu_start;
+            end = container->value.object->insitu_end;
+            break;
+        case JSONArray:
+            start = container->value.array->insitu_start;
+            end = container->value.array->insitu_end;
+            break;
+        default:
+            return PARSON_FALSE;
+    }
+    return (start != NULL && string >= start && string < end) ? PARSON_TRUE : PARSON_FALSE;
+}
+
 /* Parser */
 static JSON_Status skip_quotes(const char **string) {
     if (**string != '\"') {
@@ -825,18 +1411,12 @@ static JSON_Status parse_utf16(const char **unprocessed, char **processed) {
 }
 
 
-/* Copies and processes passed string up to supplied length.
+/* Processes passed string up to supplied length into output, that can be the input itself
+   because the processed string is never longer than the input one.
 Example: "\u006Corem ipsum" -> lorem ipsum */
-static char* process_string(const char *input, size_t input_len, size_t *output_len) {
+static JSON_Status unescape_string(const char *input, size_t input_len, char *output, size_t *output_len) {
     const char *input_ptr = input;
-    size_t initial_size = (input_len + 1) * sizeof(char);
-    size_t final_size = 0;
-    char *output = NULL, *output_ptr = NULL, *resized_output = NULL;
-    output = (char*)parson_malloc(initial_size);
-    if (output == NULL) {
-        goto error;
-    }
-    output_ptr = output;
+    char *output_ptr = output;
     while ((*input_ptr != '\0') && (size_t)(input_ptr - input) < input_len) {
         if (*input_ptr == '\\') {
             input_ptr++;
@@ -851,14 +1431,14 @@ static char* process_string(const char *input, size_t input_len, size_t *output_
                 case 't':  *output_ptr = '\t'; break;
                 case 'u':
                     if (parse_utf16(&input_ptr, &output_ptr) != JSONSuccess) {
-                        goto error;
+                        return JSONFailure;
                     }
                     break;
                 default:
-                    goto error;
+                    return JSONFailure;
             }
         } else if ((unsigned char)*input_ptr < 0x20) {
-            goto error; /* 0x00-0x19 are invalid characters for json string (http://www.ietf.org/rfc/rfc4627.txt) */
+            return JSONFailure; /* 0x00-0x19 are invalid characters for json string (http://www.ietf.org/rfc/rfc4627.txt) */
         } else {
             *output_ptr = *input_ptr;
         }
@@ -866,15 +1446,30 @@ static char* process_string(const char *input, size_t input_len, size_t *output_
         input_ptr++;
     }
     *output_ptr = '\0';
+    *output_len = (size_t)(output_ptr - output);
+    return JSONSuccess;
+}
+
+/* Copies and processes passed string up to supplied length. */
+static char* process_string(const char *input, size_t input_len, size_t *output_len) {
+    size_t initial_size = (input_len + 1) * sizeof(char);
+    size_t final_size = 0;
+    char *output = NULL, *resized_output = NULL;
+    output = (char*)parson_malloc(initial_size);
+    if (output == NULL) {
+        goto error;
+    }
+    if (unescape_string(input, input_len, output, output_len) != JSONSuccess) {
+        goto error;
+    }
     /* resize to new length */
-    final_size = (size_t)(output_ptr-output) + 1;
+    final_size = *output_len + 1;
     /* todo: don't resize if final_size == initial_size */
     resized_output = (char*)parson_malloc(final_size);
     if (resized_output == NULL) {
         goto error;
     }
     memcpy(resized_output, output, final_size);
-    *output_len = final_size - 1;
     parson_free(output);
     return resized_output;
 error:
@@ -883,30 +1478,46 @@ error:
 }
 
 /* Return processed contents of a string between quotes and
-   skips passed argument to a matching quote. */
-static char * get_quoted_string(const char **string, size_t *output_string_len) {
+   skips passed argument to a matching quote.
+   With insitu the string is processed in place and the returned pointer is inside the input. */
+static char * get_quoted_string(const char **string, size_t *output_string_len, parson_bool_t insitu) {
     const char *string_start = *string;
+    char *insitu_string = NULL;
     size_t input_string_len = 0;
     JSON_Status status = skip_quotes(string);
     if (status != JSONSuccess) {
         return NULL;
     }
     input_string_len = *string - string_start - 2; /* length without quotes */
+    if (insitu) {
+        insitu_string = (char*)string_start + 1; /* json_parse_string_insitu input is mutable */
+        status = unescape_string(insitu_string, input_string_len, insitu_string, output_string_len);
+        return status == JSONSuccess ? insitu_string : NULL;
+    }
     return process_string(string_start + 1, input_string_len, output_string_len);
 }
 
-static JSON_Value * parse_value(const char **string, size_t nesting) {
+/* Frees a value not yet added to its container */
+static void free_parsed_value(JSON_Value *value, parson_bool_t insitu) {
+    if (insitu && json_value_get_type(value) == JSONString) {
+        parson_free(value); /* chars are inside the input */
+        return;
+    }
+    json_value_free(value);
+}
+
+static JSON_Value * parse_value(const char **string, size_t nesting, parson_bool_t insitu) {
     if (nesting > MAX_NESTING) {
         return NULL;
     }
     SKIP_WHITESPACES(string);
     switch (**string) {
         case '{':
-            return parse_object_value(string, nesting + 1);
+            return parse_object_value(string, nesting + 1, insitu);
         case '[':
-            return parse_array_value(string, nesting + 1);
+            return parse_array_value(string, nesting + 1, insitu);
         case '\"':
-            return parse_string_value(string);
+            return parse_string_value(string, insitu);
         case 'f': case 't':
             return parse_boolean_value(string);
         case '-':
@@ -920,7 +1531,7 @@ static JSON_Value * parse_value(const char **string, size_t nesting) {
     }
 }
 
-static JSON_Value * parse_object_value(const char **string, size_t nesting) {
+static JSON_Value * parse_object_value(const char **string, size_t nesting, parson_bool_t insitu) {
     JSON_Status status = JSONFailure;
     JSON_Value *output_value = NULL, *new_value = NULL;
     JSON_Object *output_object = NULL;
@@ -935,6 +1546,10 @@ static JSON_Value * parse_object_value(const char **string, size_t nesting) {
         return NULL;
     }
     output_object = json_value_get_object(output_value);
+    if (insitu) {
+        output_object->insitu_start = *string;
+        output_object->insitu_end = *string;
+    }
     SKIP_CHAR(string);
     SKIP_WHITESPACES(string);
     if (**string == '}') { /* empty object */
@@ -943,37 +1558,48 @@ static JSON_Value * parse_object_value(const char **string, size_t nesting) {
     }
     while (**string != '\0') {
         size_t key_len = 0;
-        new_key = get_quoted_string(string, &key_len);
+        new_key = get_quoted_string(string, &key_len, insitu);
         /* We do not support key names with embedded \0 chars */
         if (!new_key) {
             json_value_free(output_value);
             return NULL;
         }
         if (key_len != strlen(new_key)) {
-            parson_free(new_key);
+            if (!insitu) {
+                parson_free(new_key);
+            }
             json_value_free(output_value);
             return NULL;
         }
         SKIP_WHITESPACES(string);
         if (**string != ':') {
-            parson_free(new_key);
+            if (!insitu) {
+                parson_free(new_key);
+            }
             json_value_free(output_value);
             return NULL;
         }
         SKIP_CHAR(string);
-        new_value = parse_value(string, nesting);
+        new_value = parse_value(string, nesting, insitu);
         if (new_value == NULL) {
-            parson_free(new_key);
+            if (!insitu) {
+                parson_free(new_key);
+            }
             json_value_free(output_value);
             return NULL;
         }
         status = json_object_add(output_object, new_key, new_value);
         if (status != JSONSuccess) {
-            parson_free(new_key);
-            json_value_free(new_value);
+            if (!insitu) {
+                parson_free(new_key);
+            }
+            free_parsed_value(new_value, insitu);
             json_value_free(output_value);
             return NULL;
         }
+        if (insitu) {
+            output_object->insitu_end = *string;
+        }
         SKIP_WHITESPACES(string);
         if (**string != ',') {
             break;
@@ -990,7 +1616,7 @@ static JSON_Value * parse_object_value(const char **string, size_t nesting) {
     return output_value;
 }
 
-static JSON_Value * parse_array_value(const char **string, size_t nesting) {
+static JSON_Value * parse_array_value(const char **string, size_t nesting, parson_bool_t insitu) {
     JSON_Value *output_value = NULL, *new_array_value = NULL;
     JSON_Array *output_array = NULL;
     output_value = json_value_init_array();
@@ -1002,6 +1628,10 @@ static JSON_Value * parse_array_value(const char **string, size_t nesting) {
         return NULL;
     }
     output_array = json_value_get_array(output_value);
+    if (insitu) {
+        output_array->insitu_start = *string;
+        output_array->insitu_end = *string;
+    }
     SKIP_CHAR(string);
     SKIP_WHITESPACES(string);
     if (**string == ']') { /* empty array */
@@ -1009,16 +1639,19 @@ static JSON_Value * parse_array_value(const char **string, size_t nesting) {
         return output_value;
     }
     while (**string != '\0') {
-        new_array_value = parse_value(string, nesting);
+        new_array_value = parse_value(string, nesting, insitu);
         if (new_array_value == NULL) {
             json_value_free(output_value);
             return NULL;
         }
         if (json_array_add(output_array, new_array_value) != JSONSuccess) {
-            json_value_free(new_array_value);
+            free_parsed_value(new_array_value, insitu);
             json_value_free(output_value);
             return NULL;
         }
+        if (insitu) {
+            output_array->insitu_end = *string;
+        }
         SKIP_WHITESPACES(string);
         if (**string != ',') {
             break;
@@ -1036,16 +1669,18 @@ static JSON_Value * parse_array_value(const char **string, size_t nesting) {
     return output_value;
 }
 
-static JSON_Value * parse_string_value(const char **string) {
+static JSON_Value * parse_string_value(const char **string, parson_bool_t insitu) {
     JSON_Value *value = NULL;
     size_t new_string_len = 0;
-    char *new_string = get_quoted_string(string, &new_string_len);
+    char *new_string = get_quoted_string(string, &new_string_len, insitu);
     if (new_string == NULL) {
         return NULL;
     }
     value = json_value_init_string_no_copy(new_string, new_string_len);
     if (value == NULL) {
-        parson_free(new_string);
+        if (!insitu) {
+            parson_free(new_string);
+        }
         return NULL;
     }
     return value;
@@ -1068,7 +1703,7 @@ static JSON_Value * parse_number_value(const char **string) {
     char *end;
     double number = 0;
     errno = 0;
-    number = strtod(*string, &end);
+    number = parson_strtod(*string, &end);
     if (errno == ERANGE && (number <= -HUGE_VAL || number >= HUGE_VAL)) {
         return NULL;
     }
@@ -1222,7 +1857,7 @@ static int json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int le
             if (parson_float_format) {
                 written = sprintf(num_buf, parson_float_format, num);
             } else {
-                written = sprintf(num_buf, PARSON_DEFAULT_FLOAT_FORMAT, num);
+                written = serialize_number(num, num_buf);
             }
             if (written < 0) {
                 return -1;
@@ -1243,11 +1878,23 @@ static int json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int le
 }
 
 static int json_serialize_string(const char *string, size_t len, char *buf) {
-    size_t i = 0;
+    size_t i = 0, run = 0;
     char c = '\0';
     int written = -1, written_total = 0;
     APPEND_STRING("\"");
     for (i = 0; i < len; i++) {
+        run = plain_prefix_len(string + i, len - i);
+        if (run > 0) {
+            if (buf != NULL) {
+                memcpy(buf, string + i, run);
+                buf += run;
+            }
+            written_total += (int)run;
+            i += run;
+            if (i == len) {
+                break;
+            }
+        }
         c = string[i];
         switch (c) {
             case '\"': APPEND_STRING("\\\""); break;
@@ -1327,24 +1974,26 @@ static int append_string(char *buf, const char *string) {
 
 /* Parser API */
 JSON_Value * json_parse_file(const char *filename) {
-    char *file_contents = read_file(filename);
+    size_t map_size = 0;
+    char *file_contents = load_file(filename, &map_size);
     JSON_Value *output_value = NULL;
     if (file_contents == NULL) {
         return NULL;
     }
     output_value = json_parse_string(file_contents);
-    parson_free(file_contents);
+    unload_file(file_contents, map_size);
     return output_value;
 }
 
 JSON_Value * json_parse_file_with_comments(const char *filename) {
-    char *file_contents = read_file(filename);
+    size_t map_size = 0;
+    char *file_contents = load_file(filename, &map_size);
     JSON_Value *output_value = NULL;
     if (file_contents == NULL) {
         return NULL;
     }
     output_value = json_parse_string_with_comments(file_contents);
-    parson_free(file_contents);
+    unload_file(file_contents, map_size);
     return output_value;
 }
 
@@ -1355,7 +2004,29 @@ JSON_Value * json_parse_string(const char *string) {
     if (string[0] == '\xEF' && string[1] == '\xBB' && string[2] == '\xBF') {
         string = string + 3; /* Support for UTF-8 BOM */
     }
-    return parse_value((const char**)&string, 0);
+    return parse_value((const char**)&string, 0, PARSON_FALSE);
+}
+
+JSON_Value * json_parse_string_insitu(char *string) {
+    JSON_Value *result = NULL;
+    char *string_copy = NULL;
+    if (string == NULL) {
+        return NULL;
+    }
+    if (string[0] == '\xEF' && string[1] == '\xBB' && string[2] == '\xBF') {
+        string = string + 3; /* Support for UTF-8 BOM */
+    }
+    result = parse_value((const char**)&string, 0, PARSON_TRUE);
+    if (json_value_get_type(result) == JSONString) {
+        /* a string without container can't borrow its chars */
+        string_copy = parson_strndup(result->value.string.chars, result->value.string.length);
+        if (string_copy == NULL) {
+            parson_free(result);
+            return NULL;
+        }
+        result->value.string.chars = string_copy;
+    }
+    return result;
 }
 
 JSON_Value * json_parse_string_with_comments(const char *string) {
@@ -1368,7 +2039,7 @@ JSON_Value * json_parse_string_with_comments(const char *string) {
     remove_comments(string_mutable_copy, "/*", "*/");
     remove_comments(string_mutable_copy, "//", "\n");
     string_mutable_copy_ptr = string_mutable_copy;
-    result = parse_value((const char**)&string_mutable_copy_ptr, 0);
+    result = parse_value((const char**)&string_mutable_copy_ptr, 0, PARSON_FALSE);
     parson_free(string_mutable_copy);
     return result;
 }
@@ -1570,7 +2241,9 @@ void json_value_free(JSON_Value *value) {
             json_object_free(value->value.object);
             break;
         case JSONString:
-            parson_free(value->value.string.chars);
+            if (!is_insitu_string(value->parent, value->value.string.chars)) {
+                parson_free(value->value.string.chars);
+            }
             break;
         case JSONArray:
             json_array_free(value->value.array);
@@ -1771,16 +2444,15 @@ size_t json_serialization_size(const JSON_Value *value) {
 }
 
 JSON_Status json_serialize_to_buffer(const JSON_Value *value, char *buf, size_t buf_size_in_bytes) {
-    int written = -1;
-    size_t needed_size_in_bytes = json_serialization_size(value);
-    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
-        return JSONFailure;
-    }
-    written = json_serialize_to_buffer_r(value, buf, 0, PARSON_FALSE, NULL);
-    if (written < 0) {
+    JSON_Fixed_Buffer buffer;
+    if (buf == NULL || buf_size_in_bytes == 0) {
         return JSONFailure;
     }
-    return JSONSuccess;
+    buffer.buf = buf;
+    buffer.size = buf_size_in_bytes;
+    buffer.used = 0;
+    buf[0] = '\0';
+    return json_serialize_to_writer(value, fixed_buffer_output, &buffer, PARSON_FALSE, NULL);
 }
 
 JSON_Status json_serialize_to_file(const JSON_Value *value, const char *filename) {
@@ -1806,22 +2478,12 @@ JSON_Status json_serialize_to_file(const JSON_Value *value, const char *filename
 }
 
 char * json_serialize_to_string(const JSON_Value *value) {
-    JSON_Status serialization_result = JSONFailure;
-    size_t buf_size_bytes = json_serialization_size(value);
-    char *buf = NULL;
-    if (buf_size_bytes == 0) {
-        return NULL;
-    }
-    buf = (char*)parson_malloc(buf_size_bytes);
-    if (buf == NULL) {
-        return NULL;
-    }
-    serialization_result = json_serialize_to_buffer(value, buf, buf_size_bytes);
-    if (serialization_result != JSONSuccess) {
-        json_free_serialized_string(buf);
+    JSON_Growable_Buffer buffer = { NULL, 0, 0 };
+    if (json_serialize_to_growable_buffer(value, &buffer) != JSONSuccess) {
+        json_free_serialized_string(buffer.data);
         return NULL;
     }
-    return buf;
+    return buffer.data;
 }
 
 size_t json_serialization_size_pretty(const JSON_Value *value) {
@@ -1831,16 +2493,15 @@ size_t json_serialization_size_pretty(const JSON_Value *value) {
 }
 
 JSON_Status json_serialize_to_buffer_pretty(const JSON_Value *value, char *buf, size_t buf_size_in_bytes) {
-    int written = -1;
-    size_t needed_size_in_bytes = json_serialization_size_pretty(value);
-    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
-        return JSONFailure;
-    }
-    written = json_serialize_to_buffer_r(value, buf, 0, PARSON_TRUE, NULL);
-    if (written < 0) {
+    JSON_Fixed_Buffer buffer;
+    if (buf == NULL || buf_size_in_bytes == 0) {
         return JSONFailure;
     }
-    return JSONSuccess;
+    buffer.buf = buf;
+    buffer.size = buf_size_in_bytes;
+    buffer.used = 0;
+    buf[0] = '\0';
+    return json_serialize_to_writer(value, fixed_buffer_output, &buffer, PARSON_TRUE, NULL);
 }
 
 JSON_Status json_serialize_to_file_pretty(const JSON_Value *value, const char *filename) {
@@ -1866,22 +2527,12 @@ JSON_Status json_serialize_to_file_pretty(const JSON_Value *value, const char *f
 }
 
 char * json_serialize_to_string_pretty(const JSON_Value *value) {
-    JSON_Status serialization_result = JSONFailure;
-    size_t buf_size_bytes = json_serialization_size_pretty(value);
-    char *buf = NULL;
-    if (buf_size_bytes == 0) {
-        return NULL;
-    }
-    buf = (char*)parson_malloc(buf_size_bytes);
-    if (buf == NULL) {
+    JSON_Growable_Buffer buffer = { NULL, 0, 0 };
+    if (json_serialize_to_growable_buffer_pretty(value, &buffer) != JSONSuccess) {
+        json_free_serialized_string(buffer.data);
         return NULL;
     }
-    serialization_result = json_serialize_to_buffer_pretty(value, buf, buf_size_bytes);
-    if (serialization_result != JSONSuccess) {
-        json_free_serialized_string(buf);
-        return NULL;
-    }
-    return buf;
+    return buffer.data;
 }
 
 void json_free_serialized_string(char *string) {
@@ -2262,7 +2913,9 @@ JSON_Status json_object_clear(JSON_Object *object) {
         return JSONFailure;
     }
     for (i = 0; i < json_object_get_count(object); i++) {
-        parson_free(object->names[i]);
+        if (!is_insitu_string(object->wrapping_value, object->names[i])) {
+            parson_free(object->names[i]);
+        }
         json_value_free(object->values[i]);
     }
     object->count = 0;
@@ -2593,14 +3246,707 @@ size_t json_serialization_size_format(const JSON_Value *value, char *float_forma
 }
 
 JSON_Status json_serialize_to_buffer_format(const JSON_Value *value, char *buf, size_t buf_size_in_bytes, char *float_format) {
-    int written = -1;
-    size_t needed_size_in_bytes = json_serialization_size_format(value, float_format );
-    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
+    JSON_Fixed_Buffer buffer;
+    if (buf == NULL || buf_size_in_bytes == 0) {
         return JSONFailure;
     }
-    written = json_serialize_to_buffer_r_float_format(value, buf, 0, 0, NULL, float_format);
+    buffer.buf = buf;
+    buffer.size = buf_size_in_bytes;
+    buffer.used = 0;
+    buf[0] = '\0';
+    return json_serialize_to_writer(value, fixed_buffer_output, &buffer, PARSON_FALSE, float_format);
+}
+
+/* Single-pass serialization */
+static JSON_Status json_writer_flush(JSON_Writer *writer) {
+    JSON_Status status = JSONSuccess;
+    if (writer->used > 0) {
+        status = writer->output(writer->context, writer->chunk, writer->used);
+        writer->used = 0;
+    }
+    return status;
+}
+
+static JSON_Status json_writer_put(JSON_Writer *writer, const char *data, size_t len) {
+    if (len > (PARSON_WRITER_CHUNK_SIZE - writer->used)) {
+        if (json_writer_flush(writer) != JSONSuccess) {
+            return JSONFailure;
+        }
+        if (len > PARSON_WRITER_CHUNK_SIZE) {
+            return writer->output(writer->context, data, len);
+        }
+    }
+    memcpy(writer->chunk + writer->used, data, len);
+    writer->used += len;
+    return JSONSuccess;
+}
+
+static JSON_Status json_writer_string(JSON_Writer *writer, const char *string, size_t len) {
+    static const char hex_chars[] = "0123456789abcdef";
+    char escaped[6] = { '\\', 'u', '0', '0', '0', '0' };
+    size_t i = 0, run = 0, escaped_len = 0;
+    unsigned char c = 0;
+    if (json_writer_put(writer, "\"", 1) != JSONSuccess) {
+        return JSONFailure;
+    }
+    while (i < len) {
+        run = plain_prefix_len(string + i, len - i);
+        if (json_writer_put(writer, string + i, run) != JSONSuccess) {
+            return JSONFailure;
+        }
+        i += run;
+        if (i == len) {
+            break;
+        }
+        c = (unsigned char)string[i];
+        escaped_len = 2;
+        switch (c) {
+            case '\"': escaped[1] = '\"'; break;
+            case '\\': escaped[1] = '\\'; break;
+            case '/':  escaped[1] = '/';  break;
+            case '\b': escaped[1] = 'b';  break;
+            case '\f': escaped[1] = 'f';  break;
+            case '\n': escaped[1] = 'n';  break;
+            case '\r': escaped[1] = 'r';  break;
+            case '\t': escaped[1] = 't';  break;
+            default:
+                escaped[1] = 'u';
+                escaped[4] = hex_chars[c >> 4];
+                escaped[5] = hex_chars[c & 0x0F];
+                escaped_len = 6;
+                break;
+        }
+        if (json_writer_put(writer, escaped, escaped_len) != JSONSuccess) {
+            return JSONFailure;
+        }
+        i++;
+    }
+    return json_writer_put(writer, "\"", 1);
+}
+
+static JSON_Status json_writer_number(JSON_Writer *writer, double num) {
+    char num_buf[PARSON_NUM_BUF_SIZE];
+    int written = -1;
+    if (writer->float_format) {
+        written = sprintf(num_buf, writer->float_format, num);
+    } else if (parson_float_format) {
+        written = sprintf(num_buf, parson_float_format, num);
+    } else {
+        written = serialize_number(num, num_buf);
+    }
     if (written < 0) {
-        return JSONFailure;	
-	}
+        return JSONFailure;
+    }
+    return json_writer_put(writer, num_buf, (size_t)written);
+}
+
+static JSON_Status json_writer_indent(JSON_Writer *writer, int level) {
+    int i;
+    for (i = 0; i < level; i++) {
+        if (json_writer_put(writer, "    ", 4) != JSONSuccess) {
+            return JSONFailure;
+        }
+    }
+    return JSONSuccess;
+}
+
+#define WRITER_PUT(str) do { if (json_writer_put(writer, (str), SIZEOF_TOKEN(str)) != JSONSuccess) {\
+                                 return JSONFailure; } } while(0)
+
+static JSON_Status json_serialize_to_writer_r(const JSON_Value *value, JSON_Writer *writer, int level) {
+    const char *key = NULL, *string = NULL;
+    JSON_Array *array = NULL;
+    JSON_Object *object = NULL;
+    size_t i = 0, count = 0;
+    switch (json_value_get_type(value)) {
+        case JSONArray:
+            array = json_value_get_array(value);
+            count = json_array_get_count(array);
+            WRITER_PUT("[");
+            if (count > 0 && writer->is_pretty) {
+                WRITER_PUT("\n");
+            }
+            for (i = 0; i < count; i++) {
+                if (writer->is_pretty && json_writer_indent(writer, level + 1) != JSONSuccess) {
+                    return JSONFailure;
+                }
+                if (json_serialize_to_writer_r(json_array_get_value(array, i), writer, level + 1) != JSONSuccess) {
+                    return JSONFailure;
+                }
+                if (i < (count - 1)) {
+                    WRITER_PUT(",");
+                }
+                if (writer->is_pretty) {
+                    WRITER_PUT("\n");
+                }
+            }
+            if (count > 0 && writer->is_pretty && json_writer_indent(writer, level) != JSONSuccess) {
+                return JSONFailure;
+            }
+            WRITER_PUT("]");
+            return JSONSuccess;
+        case JSONObject:
+            object = json_value_get_object(value);
+            count  = json_object_get_count(object);
+            WRITER_PUT("{");
+            if (count > 0 && writer->is_pretty) {
+                WRITER_PUT("\n");
+            }
+            for (i = 0; i < count; i++) {
+                key = json_object_get_name(object, i);
+                if (key == NULL) {
+                    return JSONFailure;
+                }
+                if (writer->is_pretty && json_writer_indent(writer, level + 1) != JSONSuccess) {
+                    return JSONFailure;
+                }
+                /* We do not support key names with embedded \0 chars */
+                if (json_writer_string(writer, key, strlen(key)) != JSONSuccess) {
+                    return JSONFailure;
+                }
+                WRITER_PUT(":");
+                if (writer->is_pretty) {
+                    WRITER_PUT(" ");
+                }
+                if (json_serialize_to_writer_r(json_object_get_value_at(object, i), writer, level + 1) != JSONSuccess) {
+                    return JSONFailure;
+                }
+                if (i < (count - 1)) {
+                    WRITER_PUT(",");
+                }
+                if (writer->is_pretty) {
+                    WRITER_PUT("\n");
+                }
+            }
+            if (count > 0 && writer->is_pretty && json_writer_indent(writer, level) != JSONSuccess) {
+                return JSONFailure;
+            }
+            WRITER_PUT("}");
+            return JSONSuccess;
+        case JSONString:
+            string = json_value_get_string(value);
+            if (string == NULL) {
+                return JSONFailure;
+            }
+            return json_writer_string(writer, string, json_value_get_string_len(value));
+        case JSONBoolean:
+            if (json_value_get_boolean(value)) {
+                WRITER_PUT("true");
+            } else {
+                WRITER_PUT("false");
+            }
+            return JSONSuccess;
+        case JSONNumber:
+            return json_writer_number(writer, json_value_get_number(value));
+        case JSONNull:
+            WRITER_PUT("null");
+            return JSONSuccess;
+        case JSONError:
+            return JSONFailure;
+        default:
+            return JSONFailure;
+    }
+}
+
+#undef WRITER_PUT
+
+static JSON_Status json_serialize_to_writer(const JSON_Value *value, JSON_Output_Function output, void *context,
+                                            int is_pretty, const char *float_format) {
+    JSON_Writer writer;
+    if (value == NULL || output == NULL) {
+        return JSONFailure;
+    }
+    writer.output = output;
+    writer.context = context;
+    writer.is_pretty = is_pretty ? PARSON_TRUE : PARSON_FALSE;
+    writer.float_format = float_format;
+    writer.used = 0;
+    if (json_serialize_to_writer_r(value, &writer, 0) != JSONSuccess) {
+        return JSONFailure;
+    }
+    return json_writer_flush(&writer);
+}
+
+static JSON_Status growable_buffer_output(void *context, const char *data, size_t len) {
+    JSON_Growable_Buffer *buffer = (JSON_Growable_Buffer*)context;
+    size_t new_capacity = 0;
+    char *new_data = NULL;
+    if (len >= (buffer->capacity - buffer->length) || buffer->data == NULL) {
+        new_capacity = MAX(buffer->capacity * 2, GROWABLE_BUFFER_STARTING_CAPACITY);
+        while (new_capacity <= (buffer->length + len)) {
+            new_capacity *= 2;
+        }
+        new_data = (char*)parson_malloc(new_capacity);
+        if (new_data == NULL) {
+            return JSONFailure;
+        }
+        if (buffer->data != NULL) {
+            memcpy(new_data, buffer->data, buffer->length);
+            parson_free(buffer->data);
+        }
+        buffer->data = new_data;
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, len);
+    buffer->length += len;
+    buffer->data[buffer->length] = '\0';
+    return JSONSuccess;
+}
+
+static JSON_Status fixed_buffer_output(void *context, const char *data, size_t len) {
+    JSON_Fixed_Buffer *buffer = (JSON_Fixed_Buffer*)context;
+    if (len >= (buffer->size - buffer->used)) {
+        return JSONFailure;
+    }
+    memcpy(buffer->buf + buffer->used, data, len);
+    buffer->used += len;
+    buffer->buf[buffer->used] = '\0';
     return JSONSuccess;
 }
+
+JSON_Status json_serialize_to_callback(const JSON_Value *value, JSON_Output_Function output, void *context) {
+    return json_serialize_to_writer(value, output, context, PARSON_FALSE, NULL);
+}
+
+JSON_Status json_serialize_to_callback_pretty(const JSON_Value *value, JSON_Output_Function output, void *context) {
+    return json_serialize_to_writer(value, output, context, PARSON_TRUE, NULL);
+}
+
+JSON_Status json_serialize_to_growable_buffer(const JSON_Value *value, JSON_Growable_Buffer *buffer) {
+    size_t start_length = 0;
+    if (buffer == NULL) {
+        return JSONFailure;
+    }
+    start_length = buffer->length;
+    if (json_serialize_to_writer(value, growable_buffer_output, buffer, PARSON_FALSE, NULL) != JSONSuccess) {
+        buffer->length = start_length;
+        if (buffer->data != NULL) {
+            buffer->data[start_length] = '\0';
+        }
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_serialize_to_growable_buffer_pretty(const JSON_Value *value, JSON_Growable_Buffer *buffer) {
+    size_t start_length = 0;
+    if (buffer == NULL) {
+        return JSONFailure;
+    }
+    start_length = buffer->length;
+    if (json_serialize_to_writer(value, growable_buffer_output, buffer, PARSON_TRUE, NULL) != JSONSuccess) {
+        buffer->length = start_length;
+        if (buffer->data != NULL) {
+            buffer->data[start_length] = '\0';
+        }
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_growable_buffer_append(JSON_Growable_Buffer *buffer, const char *data, size_t len) {
+    if (buffer == NULL || data == NULL) {
+        return JSONFailure;
+    }
+    return growable_buffer_output(buffer, data, len);
+}
+
+/* Pull parser */
+#define READER_STATE_VALUE       0
+#define READER_STATE_FIRST_VALUE 1 /* after '[' */
+#define READER_STATE_NAME        2
+#define READER_STATE_FIRST_NAME  3 /* after '{' */
+#define READER_STATE_AFTER_VALUE 4
+#define READER_STATE_DONE        5
+#define READER_STATE_ERROR       6
+
+static JSON_Token_Type reader_error(JSON_Reader *reader) {
+    reader->state = READER_STATE_ERROR;
+    reader->type = JSONTokenError;
+    return JSONTokenError;
+}
+
+static JSON_Token_Type reader_push(JSON_Reader *reader, parson_bool_t is_object, JSON_Token_Type type) {
+    unsigned char mask = (unsigned char)(1U << (reader->depth & 7U));
+    if (reader->depth >= PARSON_READER_MAX_NESTING) {
+        return reader_error(reader);
+    }
+    if (is_object) {
+        reader->in_object[reader->depth >> 3] |= mask;
+    } else {
+        reader->in_object[reader->depth >> 3] &= (unsigned char)~mask;
+    }
+    reader->depth++;
+    SKIP_CHAR(&reader->string);
+    reader->state = is_object ? READER_STATE_FIRST_NAME : READER_STATE_FIRST_VALUE;
+    reader->type = type;
+    return type;
+}
+
+static JSON_Token_Type reader_pop(JSON_Reader *reader, parson_bool_t is_object, JSON_Token_Type type) {
+    if (reader->depth == 0 || reader_in_object(reader) != is_object) {
+        return reader_error(reader);
+    }
+    reader->depth--;
+    SKIP_CHAR(&reader->string);
+    reader->state = READER_STATE_AFTER_VALUE;
+    reader->type = type;
+    return type;
+}
+
+static parson_bool_t reader_in_object(const JSON_Reader *reader) {
+    size_t top = reader->depth - 1;
+    return (reader->in_object[top >> 3] >> (top & 7U)) & 1U;
+}
+
+static JSON_Token_Type reader_scan_string(JSON_Reader *reader, JSON_Token_Type type) {
+    const char *string_start = reader->string;
+    const char *token_ptr = NULL;
+    char decoded[4];
+    if (skip_quotes(&reader->string) != JSONSuccess) {
+        return reader_error(reader);
+    }
+    reader->token = string_start + 1;
+    reader->token_len = reader->string - string_start - 2; /* length without quotes */
+    /* accepts the same strings of process_string */
+    token_ptr = reader->token;
+    while (token_ptr < reader->token + reader->token_len) {
+        if (reader_decode_char(&token_ptr, decoded) == 0) {
+            return reader_error(reader);
+        }
+    }
+    reader->type = type;
+    return type;
+}
+
+static JSON_Token_Type reader_scan_value(JSON_Reader *reader) {
+    char *end = NULL;
+    reader->token = reader->string;
+    reader->state = READER_STATE_AFTER_VALUE;
+    switch (*reader->string) {
+        case '{':
+            return reader_push(reader, PARSON_TRUE, JSONTokenObjectStart);
+        case '[':
+            return reader_push(reader, PARSON_FALSE, JSONTokenArrayStart);
+        case '\"':
+            return reader_scan_string(reader, JSONTokenString);
+        case 't':
+            if (strncmp("true", reader->string, SIZEOF_TOKEN("true")) != 0) {
+                return reader_error(reader);
+            }
+            reader->token_len = SIZEOF_TOKEN("true");
+            reader->type = JSONTokenBoolean;
+            break;
+        case 'f':
+            if (strncmp("false", reader->string, SIZEOF_TOKEN("false")) != 0) {
+                return reader_error(reader);
+            }
+            reader->token_len = SIZEOF_TOKEN("false");
+            reader->type = JSONTokenBoolean;
+            break;
+        case 'n':
+            if (strncmp("null", reader->string, SIZEOF_TOKEN("null")) != 0) {
+                return reader_error(reader);
+            }
+            reader->token_len = SIZEOF_TOKEN("null");
+            reader->type = JSONTokenNull;
+            break;
+        case '-':
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            errno = 0;
+            reader->number = parson_strtod(reader->string, &end);
+            if (errno == ERANGE && (reader->number <= -HUGE_VAL || reader->number >= HUGE_VAL)) {
+                return reader_error(reader);
+            }
+            if ((errno && errno != ERANGE) || !is_decimal(reader->string, end - reader->string)) {
+                return reader_error(reader);
+            }
+            reader->token_len = end - reader->string;
+            reader->type = JSONTokenNumber;
+            break;
+        default:
+            return reader_error(reader);
+    }
+    reader->string += reader->token_len;
+    return reader->type;
+}
+
+/* Decodes one char (or escape sequence) of a string token and moves after it.
+   Returns the number of decoded bytes, 0 on error */
+static size_t reader_decode_char(const char **token_ptr, char *decoded) {
+    char *decoded_ptr = decoded;
+    size_t decoded_len = 0;
+    if (**token_ptr != '\\') {
+        if ((unsigned char)**token_ptr < 0x20) {
+            return 0; /* 0x00-0x19 are invalid characters for json string */
+        }
+        decoded[0] = **token_ptr;
+        (*token_ptr)++;
+        return 1;
+    }
+    if ((*token_ptr)[1] == 'u') {
+        (*token_ptr)++;
+        if (parse_utf16(token_ptr, &decoded_ptr) != JSONSuccess) {
+            return 0;
+        }
+    } else if (unescape_string(*token_ptr, 2, decoded, &decoded_len) != JSONSuccess) {
+        return 0;
+    } else {
+        (*token_ptr)++;
+    }
+    (*token_ptr)++;
+    return (size_t)(decoded_ptr - decoded) + 1;
+}
+
+/* Compares the unescaped token with the first len chars of string */
+static parson_bool_t reader_token_equals_n(const JSON_Reader *reader, const char *string, size_t len) {
+    const char *token_ptr = reader->token;
+    const char *token_end = reader->token + reader->token_len;
+    char decoded[4];
+    size_t decoded_len = 0;
+    if (reader->type != JSONTokenName && reader->type != JSONTokenString) {
+        return PARSON_FALSE;
+    }
+    while (token_ptr < token_end) {
+        decoded_len = reader_decode_char(&token_ptr, decoded);
+        if (decoded_len == 0 || len < decoded_len || memcmp(decoded, string, decoded_len) != 0) {
+            return PARSON_FALSE;
+        }
+        string += decoded_len;
+        len -= decoded_len;
+    }
+    return len == 0 ? PARSON_TRUE : PARSON_FALSE;
+}
+
+void json_reader_init(JSON_Reader *reader, const char *string) {
+    memset(reader, 0, sizeof(JSON_Reader));
+    reader->string = string;
+    reader->state = READER_STATE_VALUE;
+    reader->type = JSONTokenEnd;
+    if (string == NULL) {
+        reader_error(reader);
+    } else if (string[0] == '\xEF' && string[1] == '\xBB' && string[2] == '\xBF') {
+        reader->string = string + 3; /* Support for UTF-8 BOM */
+    }
+}
+
+JSON_Token_Type json_reader_next(JSON_Reader *reader) {
+    SKIP_WHITESPACES(&reader->string);
+    switch (reader->state) {
+        case READER_STATE_FIRST_NAME:
+            if (*reader->string == '}') {
+                return reader_pop(reader, PARSON_TRUE, JSONTokenObjectEnd);
+            }
+            /* fall through */
+        case READER_STATE_NAME:
+            if (*reader->string != '\"' || reader_scan_string(reader, JSONTokenName) != JSONTokenName) {
+                return reader_error(reader);
+            }
+            SKIP_WHITESPACES(&reader->string);
+            if (*reader->string != ':') {
+                return reader_error(reader);
+            }
+            SKIP_CHAR(&reader->string);
+            reader->state = READER_STATE_VALUE;
+            return JSONTokenName;
+        case READER_STATE_FIRST_VALUE:
+            if (*reader->string == ']') {
+                return reader_pop(reader, PARSON_FALSE, JSONTokenArrayEnd);
+            }
+            /* fall through */
+        case READER_STATE_VALUE:
+            return reader_scan_value(reader);
+        case READER_STATE_AFTER_VALUE:
+            if (reader->depth == 0) {
+                break;
+            }
+            if (*reader->string == ',') {
+                SKIP_CHAR(&reader->string);
+                reader->state = reader_in_object(reader) ? READER_STATE_NAME : READER_STATE_VALUE;
+                return json_reader_next(reader);
+            } else if (*reader->string == '}') {
+                return reader_pop(reader, PARSON_TRUE, JSONTokenObjectEnd);
+            } else if (*reader->string == ']') {
+                return reader_pop(reader, PARSON_FALSE, JSONTokenArrayEnd);
+            }
+            return reader_error(reader);
+        case READER_STATE_DONE:
+            break;
+        default:
+            return JSONTokenError;
+    }
+    reader->state = READER_STATE_DONE;
+    reader->type = JSONTokenEnd;
+    return JSONTokenEnd;
+}
+
+size_t json_reader_get_depth(const JSON_Reader *reader) {
+    return reader->depth;
+}
+
+int json_reader_token_equals(const JSON_Reader *reader, const char *string) {
+    if (string == NULL) {
+        return 0;
+    }
+    return reader_token_equals_n(reader, string, strlen(string));
+}
+
+JSON_Status json_reader_get_string(const JSON_Reader *reader, char *buf, size_t buf_size) {
+    size_t len = 0;
+    if ((reader->type != JSONTokenName && reader->type != JSONTokenString)
+        || buf == NULL || buf_size <= reader->token_len) {
+        return JSONFailure;
+    }
+    return unescape_string(reader->token, reader->token_len, buf, &len);
+}
+
+double json_reader_get_number(const JSON_Reader *reader) {
+    return reader->type == JSONTokenNumber ? reader->number : 0;
+}
+
+int json_reader_get_boolean(const JSON_Reader *reader) {
+    if (reader->type != JSONTokenBoolean) {
+        return -1;
+    }
+    return reader->token[0] == 't' ? 1 : 0;
+}
+
+JSON_Status json_reader_skip(JSON_Reader *reader) {
+    size_t depth = reader->depth;
+    if (reader->type != JSONTokenObjectStart && reader->type != JSONTokenArrayStart) {
+        return reader->type == JSONTokenError ? JSONFailure : JSONSuccess;
+    }
+    while (reader->depth >= depth) {
+        if (json_reader_next(reader) == JSONTokenError) {
+            return JSONFailure;
+        }
+    }
+    return JSONSuccess;
+}
+
+JSON_Token_Type json_reader_find(JSON_Reader *reader, const char *path) {
+    const char *dot_pos = NULL;
+    size_t segment_len = 0;
+    size_t depth = 0;
+    JSON_Token_Type type = reader->type;
+    if (path == NULL) {
+        return JSONTokenEnd;
+    }
+    if (type != JSONTokenObjectStart) {
+        type = json_reader_next(reader);
+        if (type != JSONTokenObjectStart) {
+            return type == JSONTokenError ? JSONTokenError : JSONTokenEnd;
+        }
+    }
+    depth = reader->depth;
+    dot_pos = strchr(path, '.');
+    segment_len = dot_pos ? (size_t)(dot_pos - path) : strlen(path);
+    while (reader->depth >= depth) {
+        type = json_reader_next(reader);
+        if (type == JSONTokenError) {
+            return JSONTokenError;
+        }
+        if (type != JSONTokenName || reader->depth != depth) {
+            continue;
+        }
+        if (!reader_token_equals_n(reader, path, segment_len)) {
+            /* not interesting value */
+            json_reader_next(reader);
+            if (json_reader_skip(reader) != JSONSuccess) {
+                return JSONTokenError;
+            }
+            continue;
+        }
+        type = json_reader_next(reader);
+        if (dot_pos == NULL) {
+            return type;
+        }
+        if (type != JSONTokenObjectStart) {
+            return type == JSONTokenError ? JSONTokenError : JSONTokenEnd;
+        }
+        /* go down on the next path segment */
+        depth = reader->depth;
+        path = dot_pos + 1;
+        dot_pos = strchr(path, '.');
+        segment_len = dot_pos ? (size_t)(dot_pos - path) : strlen(path);
+    }
+    return JSONTokenEnd;
+}
+
+#undef READER_STATE_VALUE
+#undef READER_STATE_FIRST_VALUE
+#undef READER_STATE_NAME
+#undef READER_STATE_FIRST_NAME
+#undef READER_STATE_AFTER_VALUE
+#undef READER_STATE_DONE
+#undef READER_STATE_ERROR
+
+/* Precompiled dotted paths */
+JSON_Status json_path_compile(JSON_Path *path, const char *name) {
+    const char *dot_position = NULL;
+    size_t len = 0;
+    if (path == NULL || name == NULL) {
+        return JSONFailure;
+    }
+    path->count = 0;
+    for (;;) {
+        if (path->count >= PARSON_PATH_MAX_SEGMENTS) {
+            path->count = 0;
+            return JSONFailure;
+        }
+        dot_position = strchr(name, '.');
+        len = dot_position ? (size_t)(dot_position - name) : strlen(name);
+        path->segments[path->count].name = name;
+        path->segments[path->count].len = len;
+        path->segments[path->count].hash = hash_string(name, len);
+        path->count++;
+        if (dot_position == NULL) {
+            return JSONSuccess;
+        }
+        name = dot_position + 1;
+    }
+}
+
+JSON_Value * json_object_pathget_value(const JSON_Object *object, const JSON_Path *path) {
+    JSON_Value *value = NULL;
+    size_t i = 0;
+    if (path == NULL || path->count == 0) {
+        return NULL;
+    }
+    for (i = 0; i < path->count; i++) {
+        if (i > 0) {
+            object = json_value_get_object(value);
+        }
+        value = json_object_getn_value_hashed(object, path->segments[i].name, path->segments[i].len, path->segments[i].hash);
+    }
+    return value;
+}
+
+const char * json_object_pathget_string(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_string(json_object_pathget_value(object, path));
+}
+
+size_t json_object_pathget_string_len(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_string_len(json_object_pathget_value(object, path));
+}
+
+double json_object_pathget_number(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_number(json_object_pathget_value(object, path));
+}
+
+JSON_Object * json_object_pathget_object(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_object(json_object_pathget_value(object, path));
+}
+
+JSON_Array * json_object_pathget_array(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_array(json_object_pathget_value(object, path));
+}
+
+int json_object_pathget_boolean(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_boolean(json_object_pathget_value(object, path));
+}
+
+int json_object_pathhas_value(const JSON_Object *object, const JSON_Path *path) {
+    return json_object_pathget_value(object, path) != NULL;
+}
@@ -75,6 +75,10 @@ void json_set_allocation_functions(JSON_Malloc_Function malloc_fun, JSON_Free_Fu
  This function sets a global setting and is not thread safe. */
 void json_set_escape_slashes(int escape_slashes);
 
+/* Numbers are parsed with strtod and serialized with sprintf ("%1.17g"), apart from integral
+   values that don't need sprintf. Build with PARSON_FAST_NUMBERS for a fast exact parser
+   (strtod is used only as fallback) and for the shortest round-trip serialization (Grisu2). */
+
 /* Sets float format used for serialization of numbers.
    Make sure it can't serialize to a string longer than PARSON_NUM_BUF_SIZE.
    If format is null then the default format is used. */
@@ -90,6 +94,11 @@ JSON_Value * json_parse_file_with_comments(const char *filename);
 /*  Parses first JSON value in a string, returns NULL in case of error */
 JSON_Value * json_parse_string(const char *string);
 
+/*  Parses first JSON value in a mutable string without copying strings and names:
+    they are processed in place and point inside the string, that must outlive the
+    returned value. Returns NULL in case of error */
+JSON_Value * json_parse_string_insitu(char *string);
+
 /*  Parses first JSON value in a string and ignores comments (/ * * / and //),
     returns NULL in case of error */
 JSON_Value * json_parse_string_with_comments(const char *string);
@@ -264,6 +273,104 @@ int             json_boolean(const JSON_Value *value);
 size_t json_serialization_size_format(const JSON_Value *value, char *float_format);
 JSON_Status json_serialize_to_buffer_format(const JSON_Value *value, char *buf, size_t buf_size_in_bytes, char *float_format);
 
+/* Single-pass serialization: the value is walked once, without the json_serialization_size()
+   pre-pass. json_serialize_to_string and json_serialize_to_buffer use it as well */
+/* Called with consecutive chunks of the serialized value (not null terminated),
+   serialization stops as soon as it returns JSONFailure */
+typedef JSON_Status (*JSON_Output_Function)(void *context, const char *data, size_t len);
+JSON_Status json_serialize_to_callback(const JSON_Value *value, JSON_Output_Function output, void *context);
+JSON_Status json_serialize_to_callback_pretty(const JSON_Value *value, JSON_Output_Function output, void *context);
+
+/* Start from { NULL, 0, 0 } or reuse a previous buffer: the serialized value is appended and
+   data is kept null terminated. Free data with json_free_serialized_string */
+typedef struct json_growable_buffer_t {
+    char   *data;
+    size_t  length;   /* doesn't account for last null character */
+    size_t  capacity;
+} JSON_Growable_Buffer;
+JSON_Status json_serialize_to_growable_buffer(const JSON_Value *value, JSON_Growable_Buffer *buffer);
+JSON_Status json_serialize_to_growable_buffer_pretty(const JSON_Value *value, JSON_Growable_Buffer *buffer);
+/* Appends already serialized text */
+JSON_Status json_growable_buffer_append(JSON_Growable_Buffer *buffer, const char *data, size_t len);
+
+/* Pull parser: scans the first JSON value in a string one token at a time, without building
+   a tree and without any memory allocation */
+#ifndef PARSON_READER_MAX_NESTING
+#define PARSON_READER_MAX_NESTING 32 /* max nesting level of objects and arrays */
+#endif
+
+enum json_token_type {
+    JSONTokenError       = -1,
+    JSONTokenEnd         = 0,
+    JSONTokenObjectStart = 1,
+    JSONTokenObjectEnd   = 2,
+    JSONTokenArrayStart  = 3,
+    JSONTokenArrayEnd    = 4,
+    JSONTokenName        = 5,
+    JSONTokenString      = 6,
+    JSONTokenNumber      = 7,
+    JSONTokenBoolean     = 8,
+    JSONTokenNull        = 9
+};
+typedef int JSON_Token_Type;
+
+/* Fields are private, use the json_reader functions */
+typedef struct json_reader_t {
+    const char     *string;    /* next char to scan */
+    const char     *token;     /* current token (strings without quotes and still escaped) */
+    size_t          token_len;
+    double          number;
+    JSON_Token_Type type;
+    int             state;
+    size_t          depth;
+    unsigned char   in_object[(PARSON_READER_MAX_NESTING + 7) / 8];
+} JSON_Reader;
+
+void            json_reader_init(JSON_Reader *reader, const char *string);
+/* Returns the type of the next token, JSONTokenEnd after the end of the first value */
+JSON_Token_Type json_reader_next(JSON_Reader *reader);
+/* Nesting level of the current token (1 for names and values of the root object) */
+size_t          json_reader_get_depth(const JSON_Reader *reader);
+/* Compares the current name or string token with a string */
+int             json_reader_token_equals(const JSON_Reader *reader, const char *string);
+/* Copies the unescaped name or string token: buf_size must be greater than
+   the escaped token length. Returns JSONFailure on error */
+JSON_Status     json_reader_get_string(const JSON_Reader *reader, char *buf, size_t buf_size);
+double          json_reader_get_number(const JSON_Reader *reader); /* returns 0 on fail */
+int             json_reader_get_boolean(const JSON_Reader *reader); /* returns -1 on fail */
+/* If the current token is an object or array start, moves to its matching end */
+JSON_Status     json_reader_skip(JSON_Reader *reader);
+/* Moves to the value with a dotted path (like json_object_dotget_value) inside the next
+   (or current) object. Returns its token type, JSONTokenEnd if not found */
+JSON_Token_Type json_reader_find(JSON_Reader *reader, const char *path);
+
+/* Precompiled dotted paths: json_path_compile splits and hashes the path segments once, then
+   the json_object_pathget functions work like json_object_dotget without scanning the path again */
+#ifndef PARSON_PATH_MAX_SEGMENTS
+#define PARSON_PATH_MAX_SEGMENTS 4
+#endif
+
+/* Fields are private, use json_path_compile */
+typedef struct json_path_t {
+    size_t count;
+    struct json_path_segment_t {
+        const char    *name;  /* points inside the compiled string, that must outlive the path */
+        size_t         len;
+        unsigned long  hash;
+    } segments[PARSON_PATH_MAX_SEGMENTS];
+} JSON_Path;
+
+/* Fails if the path has more than PARSON_PATH_MAX_SEGMENTS segments */
+JSON_Status   json_path_compile(JSON_Path *path, const char *name);
+JSON_Value  * json_object_pathget_value  (const JSON_Object *object, const JSON_Path *path);
+const char  * json_object_pathget_string (const JSON_Object *object, const JSON_Path *path);
+size_t        json_object_pathget_string_len(const JSON_Object *object, const JSON_Path *path); /* doesn't account for last null character */
+JSON_Object * json_object_pathget_object (const JSON_Object *object, const JSON_Path *path);
+JSON_Array  * json_object_pathget_array  (const JSON_Object *object, const JSON_Path *path);
+double        json_object_pathget_number (const JSON_Object *object, const JSON_Path *path); /* returns 0 on fail */
+int           json_object_pathget_boolean(const JSON_Object *object, const JSON_Path *path); /* returns -1 on fail */
+int           json_object_pathhas_value  (const JSON_Object *object, const JSON_Path *path);
+
 
 #ifdef __cplusplus
 }
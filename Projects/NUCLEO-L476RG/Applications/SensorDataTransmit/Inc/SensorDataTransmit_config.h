@@ -43,6 +43,10 @@ The Sensors fusion runs at 100Hz so like MAXIMUM it possible to send:
 if QUAT_UPDATE_MUL_10MS!=3, then SEND_N_QUATERNIONS must be ==1
 */
 
+/* For entering STOP2 between the features deadlines (woken up by LPTIM1, BlueNRG-2 IRQ and user button).
+ * NOTE: the debugger connection is lost while the core is in STOP2 */
+//#define SENSOR_DT_LOW_POWER
+
 /*************** Debug Defines ******************/
 #define SENSOR_DT_ENABLE_PRINTF
 
@@ -44,6 +44,10 @@
 
 /* Exported Variables --------------------------------------------------------*/
 /* USER CODE BEGIN EV */
+#ifdef SENSOR_DT_LOW_POWER
+/* Set by the BlueNRG-2 IRQ for not entering STOP2 with HCI events to process */
+extern volatile uint8_t HciEventReceived;
+#endif /* SENSOR_DT_LOW_POWER */
 
 /* USER CODE END EV */
 
@@ -31,6 +31,17 @@
 /* Private macro ------------------------------------------------------------*/
 
 /* Private defines -----------------------------------------------------------*/
+/* Features periods (ms) */
+#define LED_BLINK_PERIOD      1000U
+#define ENV_UPDATE_PERIOD     1000U
+#define FUSION_UPDATE_PERIOD  100U
+
+#ifdef SENSOR_DT_LOW_POWER
+/* Below this time (ms) it's not worth to enter STOP2 */
+#define LP_MIN_SLEEP_TIME     3U
+/* Max sleep time (ms) allowed by the 16 bits LPTIM1 counter */
+#define LP_MAX_SLEEP_TIME     0xFFFFU
+#endif /* SENSOR_DT_LOW_POWER */
 
 /* Imported Variables --------------------------------------------------------*/
 
@@ -52,6 +63,15 @@ static uint8_t LedStatus                        = 0;
 
 static volatile uint32_t FeatureMask;
 
+/* Next deadlines (HAL_GetTick) of the periodic features */
+static uint32_t LedNextTick;
+static uint32_t EnvNextTick;
+static uint32_t FusionNextTick;
+
+#ifdef SENSOR_DT_LOW_POWER
+volatile uint8_t HciEventReceived = 0;
+#endif /* SENSOR_DT_LOW_POWER */
+
 /* USER CODE BEGIN PV */
 
 /* USER CODE END PV */
@@ -60,6 +80,16 @@ static volatile uint32_t FeatureMask;
 static void User_Init(void);
 static void User_Process(void);
 static void ComputeRandomQuaternions(void);
+static uint8_t IsDeadlineReached(uint32_t *NextTick, uint32_t Period, uint32_t Now);
+static void UpdateNextDeadline(uint32_t NextTick, uint8_t *HasDeadline, uint32_t *Deadline);
+static void WaitNextEvent(uint8_t HasDeadline, uint32_t Deadline);
+#ifdef SENSOR_DT_LOW_POWER
+static void LowPower_Init(void);
+static void LowPower_TimerStart(uint32_t SleepTime);
+static uint32_t LowPower_TimerStop(void);
+
+extern void SystemClock_Config(void);
+#endif /* SENSOR_DT_LOW_POWER */
 
 /* USER CODE BEGIN PFP */
 
@@ -123,7 +153,6 @@ static void User_Init(void)
   if(BSP_COM_Init(COM1) != BSP_ERROR_NONE) {
     Error_Handler();
   } else {
-    HAL_Delay(20);
     SENSOR_DT_PRINTF("\033[2J\033[1;1f");
     SENSOR_DT_PRINTF("UART Initialized\r\n");
   }
@@ -161,6 +190,11 @@ static void User_Init(void)
 #ifdef SENSOR_DT_NOTIFY_TRAMISSION
   SENSOR_DT_PRINTF("Debug Notify Trasmission Enabled\r\n\n");
 #endif /* SENSOR_DT_NOTIFY_TRAMISSION */
+
+#ifdef SENSOR_DT_LOW_POWER
+  LowPower_Init();
+  SENSOR_DT_PRINTF("Low Power (STOP2)        Enabled\r\n\n");
+#endif /* SENSOR_DT_LOW_POWER */
 }
 
 /**
@@ -172,51 +206,292 @@ static void User_Init(void)
  */
 static void User_Process(void)
 {
+  uint32_t Now;
+  uint32_t Deadline = 0;
+  uint8_t HasDeadline = 0;
+
   if(set_connectable) {
     set_connectable =0;
     setConnectable();
     BlinkLed= 1;
+    LedNextTick = HAL_GetTick();
   }
 
+#ifdef SENSOR_DT_LOW_POWER
+  HciEventReceived = 0;
+#endif /* SENSOR_DT_LOW_POWER */
+
   /* handle BLE event */
   hci_user_evt_proc();
 
-  /* Blinking the Led */
-  if(BlinkLed) {
-    BSP_LED_Toggle(LED_GREEN);
-    LedStatus = !LedStatus;
+#ifdef BLE_MANAGER_STACK_RECOVERY
+  /* Rebuild the BLE stack after one BlueNRG fault */
+  BLE_StackRecoveryProcess();
+#endif /* BLE_MANAGER_STACK_RECOVERY */
 
-    /* wait 1 sec before Led Status changes */
-    HAL_Delay(1000);
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+  /* Advertising back-off */
+  BLE_AdvertisingProcess();
+  if(BLE_AdvertisingGetDeadline(&Deadline)) {
+    HasDeadline = 1;
   }
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
 
-  /* Environmental Data */
-  if(RandomEnvEnabled) {
-    int32_t PressToSend;
-    uint16_t HumToSend;
-    int16_t TempToSend;
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+  /* Write requests posted by the BLE events */
+  if(BLE_DeferredProcess(BLE_DEFERRED_BUDGET)) {
+    /* Don't sleep with write requests still queued */
+    UpdateNextDeadline(HAL_GetTick(),&HasDeadline,&Deadline);
+  }
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
 
-    /* Read all the Environmental Sensors */
-    SetRandomEnvironmentalValues(&PressToSend,&HumToSend, &TempToSend);
+#if (defined(BLE_MANAGER_SAMPLE_QUEUE) && !defined(BLE_MANAGER_RTOS))
+  /* Samples pushed by the sensor interrupts (with BLE_MANAGER_RTOS the BLE task is the consumer) */
+  if(BLE_SampleProcess(BLE_SAMPLE_BUDGET)) {
+    /* Don't sleep with samples still queued */
+    UpdateNextDeadline(HAL_GetTick(),&HasDeadline,&Deadline);
+  }
+#endif /* (defined(BLE_MANAGER_SAMPLE_QUEUE) && !defined(BLE_MANAGER_RTOS)) */
 
-    /* Send the Data with BLE */
-    BLE_EnvironmentalUpdate(PressToSend,HumToSend,TempToSend,0);
+  Now = HAL_GetTick();
 
-    /* wait 1 sec before sending new data */
-    HAL_Delay(1000);
+  /* Blinking the Led */
+  if(BlinkLed) {
+    if(IsDeadlineReached(&LedNextTick,LED_BLINK_PERIOD,Now)) {
+      BSP_LED_Toggle(LED_GREEN);
+      LedStatus = !LedStatus;
+    }
+    UpdateNextDeadline(LedNextTick,&HasDeadline,&Deadline);
+  }
+
+  /* Environmental Data */
+  if(RandomEnvEnabled) {
+    if(IsDeadlineReached(&EnvNextTick,ENV_UPDATE_PERIOD,Now)) {
+      int32_t PressToSend;
+      uint16_t HumToSend;
+      int16_t TempToSend;
+
+      /* Read all the Environmental Sensors */
+      SetRandomEnvironmentalValues(&PressToSend,&HumToSend, &TempToSend);
+
+      /* Send the Data with BLE */
+      BLE_EnvironmentalUpdate(PressToSend,HumToSend,TempToSend,0);
+    }
+    UpdateNextDeadline(EnvNextTick,&HasDeadline,&Deadline);
   }
 
   /* MotionFX */
   if(RandomSensorFusionEnabled) {
-    ComputeRandomQuaternions();
+    if(IsDeadlineReached(&FusionNextTick,FUSION_UPDATE_PERIOD,Now)) {
+      ComputeRandomQuaternions();
+    }
+    UpdateNextDeadline(FusionNextTick,&HasDeadline,&Deadline);
+  }
+
+#ifdef BLE_MANAGER_CONN_TUNER
+  /* Connection parameters that fit the notifications sent */
+  {
+    uint32_t TunerDeadline;
 
-    /* wait 100 ms before sending new data */
-    HAL_Delay(100);
+    BLE_ConnTunerProcess();
+    if(BLE_ConnTunerGetDeadline(&TunerDeadline)) {
+      UpdateNextDeadline(TunerDeadline,&HasDeadline,&Deadline);
+    }
   }
+#endif /* BLE_MANAGER_CONN_TUNER */
 
   /* Wait next event */
+  WaitNextEvent(HasDeadline,Deadline);
+}
+
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+/**
+ * @brief  User button callback: restart the fast advertising
+ * @param  Button_TypeDef Button pressed button
+ * @retval None
+ */
+void BSP_PB_Callback(Button_TypeDef Button)
+{
+  UNUSED(Button);
+
+  BLE_AdvertisingRestartFast();
+}
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+
+/**
+ * @brief  Check if the deadline of one periodic feature is reached and compute the next one
+ * @param  uint32_t *NextTick deadline of the feature
+ * @param  uint32_t Period period of the feature (ms)
+ * @param  uint32_t Now current tick
+ * @retval uint8_t 1 if the feature must be executed now
+ */
+static uint8_t IsDeadlineReached(uint32_t *NextTick, uint32_t Period, uint32_t Now)
+{
+  if(((int32_t)(Now - *NextTick)) < 0) {
+    return 0;
+  }
+
+  *NextTick += Period;
+  /* Don't try to recover the missed periods */
+  if(((int32_t)(Now - *NextTick)) >= 0) {
+    *NextTick = Now + Period;
+  }
+  return 1;
+}
+
+/**
+ * @brief  Keep the earliest deadline between the periodic features
+ * @param  uint32_t NextTick deadline of one feature
+ * @param  uint8_t *HasDeadline set to 1 when there is at least one deadline
+ * @param  uint32_t *Deadline earliest deadline
+ * @retval None
+ */
+static void UpdateNextDeadline(uint32_t NextTick, uint8_t *HasDeadline, uint32_t *Deadline)
+{
+  if((*HasDeadline == 0U) || (((int32_t)(NextTick - *Deadline)) < 0)) {
+    *Deadline = NextTick;
+    *HasDeadline = 1;
+  }
+}
+
+/**
+ * @brief  Wait the next interrupt or the next deadline.
+ *         With SENSOR_DT_LOW_POWER the core is in STOP2 until the deadline (LPTIM1),
+ *         the BlueNRG-2 IRQ or the user button and the HAL tick is compensated with the sleep time
+ * @param  uint8_t HasDeadline 0 if there are not periodic features running
+ * @param  uint32_t Deadline earliest deadline (HAL_GetTick)
+ * @retval None
+ */
+static void WaitNextEvent(uint8_t HasDeadline, uint32_t Deadline)
+{
+#ifdef SENSOR_DT_LOW_POWER
+  uint32_t SleepTime = LP_MAX_SLEEP_TIME;
+
+  /* Interrupts are served only after the clocks restore (a pending one wakes up the core anyway) */
+  __disable_irq();
+
+  /* Something to do before sleeping */
+  if((set_connectable) || (HciEventReceived)) {
+    __enable_irq();
+    return;
+  }
+
+  /* BlueNRG-2 has still events to send (the HCI read packets pool was full) */
+  if(HAL_GPIO_ReadPin(HCI_TL_SPI_EXTI_PORT, HCI_TL_SPI_EXTI_PIN) == GPIO_PIN_SET) {
+    __enable_irq();
+    HAL_EXTI_GenerateSWI(&H_EXTI_0);
+    return;
+  }
+
+  if(HasDeadline) {
+    int32_t Remaining = (int32_t)(Deadline - HAL_GetTick());
+
+    if(Remaining < (int32_t)LP_MIN_SLEEP_TIME) {
+      /* Wait the next SysTick */
+      __enable_irq();
+      __WFI();
+      return;
+    }
+
+    if(Remaining < (int32_t)LP_MAX_SLEEP_TIME) {
+      SleepTime = (uint32_t)Remaining;
+    }
+  }
+
+  /* Without deadlines LPTIM1 is used only for measuring the sleep time */
+  LowPower_TimerStart(SleepTime);
+  HAL_SuspendTick();
+
+  HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+
+  /* Woken up by LPTIM1 or one EXTI line: compensate the HAL tick and restore the PLL
+   * (the SPI registers are retained in STOP2) */
+  uwTick += LowPower_TimerStop();
+  SystemClock_Config();
+  HAL_ResumeTick();
+
+  __enable_irq();
+#else /* SENSOR_DT_LOW_POWER */
+  UNUSED(HasDeadline);
+  UNUSED(Deadline);
+
+  /* Wait next event (SysTick wakes up the core every 1ms) */
   __WFI();
+#endif /* SENSOR_DT_LOW_POWER */
+}
+
+#ifdef SENSOR_DT_LOW_POWER
+/**
+ * @brief  Configure LPTIM1 for the STOP2 wake up (LSI/32 -> 1ms resolution)
+ * @param  None
+ * @retval None
+ */
+static void LowPower_Init(void)
+{
+  /* LSI keeps running in STOP2 */
+  __HAL_RCC_LSI_ENABLE();
+  while(__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) == 0U) {
+  }
+
+  __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSI);
+  __HAL_RCC_LPTIM1_CLK_ENABLE();
+
+  /* The configuration registers could be written only with LPTIM1 disabled */
+  LPTIM1->CR = 0;
+  LPTIM1->CFGR = LPTIM_CFGR_PRESC_2 | LPTIM_CFGR_PRESC_0;
+  LPTIM1->IER = LPTIM_IER_ARRMIE;
+
+  /* EXTI line 32 is the LPTIM1 wake up line */
+  EXTI->IMR2 |= EXTI_IMR2_IM32;
+  HAL_NVIC_SetPriority(LPTIM1_IRQn, 0x0F, 0);
+  HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+
+  /* Wake up with MSI (the same range used as PLL source by SystemClock_Config) */
+  __HAL_RCC_WAKEUPSTOP_CLK_CONFIG(RCC_STOP_WAKEUPCLOCK_MSI);
+}
+
+/**
+ * @brief  Start LPTIM1 in one shot mode
+ * @param  uint32_t SleepTime time before the wake up (ms)
+ * @retval None
+ */
+static void LowPower_TimerStart(uint32_t SleepTime)
+{
+  LPTIM1->CR = LPTIM_CR_ENABLE;
+  LPTIM1->ICR = LPTIM_ICR_ARROKCF | LPTIM_ICR_ARRMCF;
+  LPTIM1->ARR = SleepTime;
+  while((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0U) {
+  }
+  LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+  LPTIM1->CR |= LPTIM_CR_SNGSTRT;
+}
+
+/**
+ * @brief  Stop LPTIM1
+ * @param  None
+ * @retval uint32_t time spent from LowPower_TimerStart (ms)
+ */
+static uint32_t LowPower_TimerStop(void)
+{
+  uint32_t Elapsed;
+
+  if((LPTIM1->ISR & LPTIM_ISR_ARRM) != 0U) {
+    Elapsed = LPTIM1->ARR;
+  } else {
+    /* The counter is asynchronous: two consecutive equal reads are needed */
+    do {
+      Elapsed = LPTIM1->CNT;
+    } while(Elapsed != LPTIM1->CNT);
+  }
+
+  /* Disabling LPTIM1 resets also the counter */
+  LPTIM1->CR = 0;
+  LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+  HAL_NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+
+  return Elapsed;
 }
+#endif /* SENSOR_DT_LOW_POWER */
 
 /**
   * @brief  Compute Random Quaternions
@@ -325,6 +600,23 @@ void DisconnectionCompletedFunction(void)
   HAL_Delay(100);
 }
 
+/**
+ * @brief  This function is called when the device is put in connectable mode.
+ * @param  uint8_t *ManufData Filling Manufacter Advertise data
+ * @retval None
+ */
+void SetConnectableFunction(uint8_t *ManufData)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(ManufData);
+
+  /* USER CODE BEGIN */
+
+  /* USER CODE END */
+
+  /* Without the delay of the weak version: this is on the path from the boot to the first advertising */
+}
+
 /**
 * @brief  This function makes the parsing of the Debug Console
 * @param  uint8_t *att_data attribute data
@@ -344,6 +636,42 @@ uint32_t DebugConsoleParsing(uint8_t * att_data, uint8_t data_length)
     BytesToWrite =sprintf((char *)BufferToWrite,"Command:\r\n"
       "info-> System Info\r\n"
       "versionBle-> Ble Version\r\n"
+#ifdef BLE_MANAGER_STATS
+      "stats-> BLE counters (stats reset)\r\n"
+#endif /* BLE_MANAGER_STATS */
+#ifdef BLE_MANAGER_PROFILING
+      "prof-> BLE profiling (prof reset)\r\n"
+#endif /* BLE_MANAGER_PROFILING */
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+      "mem-> Stack/heap high-water marks (mem reset)\r\n"
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
+#ifdef BLE_MANAGER_ADAPTIVE_ADVERTISING
+      "adv-> Advertising metrics (adv reset)\r\n"
+#endif /* BLE_MANAGER_ADAPTIVE_ADVERTISING */
+#ifdef BLE_MANAGER_CONN_TUNER
+      "conn-> Connection parameters tuner\r\n"
+#endif /* BLE_MANAGER_CONN_TUNER */
+#ifdef BLE_MANAGER_RADIO_SYNC
+      "radio-> Notifications queue metrics\r\n"
+#endif /* BLE_MANAGER_RADIO_SYNC */
+#ifdef BLE_MANAGER_TX_CREDITS
+      "credits-> Controller buffer accounting\r\n"
+#endif /* BLE_MANAGER_TX_CREDITS */
+#ifdef BLE_MANAGER_DEFERRED_WRITES
+      "jobs-> Deferred write requests metrics\r\n"
+#endif /* BLE_MANAGER_DEFERRED_WRITES */
+#ifdef BLE_MANAGER_STACK_RECOVERY
+      "recovery-> BLE stack recovery metrics\r\n"
+#endif /* BLE_MANAGER_STACK_RECOVERY */
+#ifdef BLE_MANAGER_RTOS
+      "rtos-> BLE task metrics\r\n"
+#endif /* BLE_MANAGER_RTOS */
+#ifdef BLE_MANAGER_SAMPLE_QUEUE
+      "samples-> Sample queue metrics\r\n"
+#endif /* BLE_MANAGER_SAMPLE_QUEUE */
+#ifdef BLE_MANAGER_FAST_BOOT
+      "boot-> Boot report\r\n"
+#endif /* BLE_MANAGER_FAST_BOOT */
       "uid-> STM32 UID value\r\n");
     Term_Update(BufferToWrite,BytesToWrite);
   }
@@ -464,7 +792,10 @@ void NotifyEventEnv(BLE_NotifyEvent_t Event)
 {
   /* Enviromental Features */
   if(Event == BLE_NOTIFY_SUB)
-	RandomEnvEnabled= 1;
+  {
+    RandomEnvEnabled= 1;
+    EnvNextTick = HAL_GetTick();
+  }
 
   if(Event == BLE_NOTIFY_UNSUB)
 	RandomEnvEnabled= 0;
@@ -505,7 +836,10 @@ void NotifyEventSensorFusion(BLE_NotifyEvent_t Event)
 {
   /* Sensor Fusion Features */
   if(Event == BLE_NOTIFY_SUB)
+  {
     RandomSensorFusionEnabled= 1;
+    FusionNextTick = HAL_GetTick();
+  }
 
   if(Event == BLE_NOTIFY_UNSUB)
     RandomSensorFusionEnabled= 0;
@@ -21,6 +21,8 @@
 #include "RTE_Components.h"
 
 #include "hci_tl.h"
+#include "BLE_Manager.h"
+#include "app_blemgr.h"
 
 /* Defines -------------------------------------------------------------------*/
 
@@ -145,6 +147,7 @@ int32_t HCI_TL_SPI_Receive(uint8_t* buffer, uint16_t size)
 
   uint8_t header_master[HEADER_SIZE] = {0x0b, 0x00, 0x00, 0x00, 0x00};
   uint8_t header_slave[HEADER_SIZE];
+  BLE_PROFILE_START(ProfileStart);
 
   HCI_TL_SPI_Disable_IRQ();
 
@@ -189,6 +192,7 @@ int32_t HCI_TL_SPI_Receive(uint8_t* buffer, uint16_t size)
   /* Release CS line */
   HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
 
+  BLE_PROFILE_STOP(BLE_PROFILE_HCI_SPI_RECEIVE, ProfileStart);
   return len;
 }
 
@@ -346,11 +350,21 @@ void hci_tl_lowlevel_isr(void)
   {
     if (hci_notify_asynch_evt(NULL))
     {
+#ifdef BLE_MANAGER_STATS
+      BLE_StatsHciRxPoolExhausted();
+#endif /* BLE_MANAGER_STATS */
       return;
     }
   }
 
   /* USER CODE BEGIN hci_tl_lowlevel_isr */
+#ifdef SENSOR_DT_LOW_POWER
+  HciEventReceived = 1U;
+#endif /* SENSOR_DT_LOW_POWER */
+#ifdef BLE_MANAGER_RTOS
+  /* Wake up the BLE task */
+  BLE_RtosHciNotify();
+#endif /* BLE_MANAGER_RTOS */
 
   /* USER CODE END hci_tl_lowlevel_isr */
 }
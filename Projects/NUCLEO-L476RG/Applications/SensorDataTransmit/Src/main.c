@@ -25,6 +25,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "BLE_Manager.h"
 
 /* USER CODE END Includes */
 
@@ -45,6 +46,17 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+#if defined (__IAR_SYSTEMS_ICC__)
+#pragma section="CSTACK"
+#pragma section="HEAP"
+#elif defined (__GNUC__) && !defined (__ARMCC_VERSION)
+/* Symbols of the linker script */
+extern uint8_t _end;
+extern uint8_t _estack;
+extern uint8_t _Min_Stack_Size;
+#endif
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
 
 /* USER CODE END PV */
 
@@ -67,6 +79,17 @@ static void MX_GPIO_Init(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
+#ifdef BLE_MANAGER_MEMORY_WATERMARK
+  /* Paint stack and heap before any allocation for the "mem" high-water marks */
+#if defined (__IAR_SYSTEMS_ICC__)
+  BLE_MemPaint(__section_begin("HEAP"),__section_end("HEAP"),
+               __section_begin("CSTACK"),__section_end("CSTACK"));
+#elif defined (__GNUC__) && !defined (__ARMCC_VERSION)
+  /* The heap can grow up to the reserved stack */
+  BLE_MemPaint(&_end,&_estack - (uintptr_t)&_Min_Stack_Size,
+               &_estack - (uintptr_t)&_Min_Stack_Size,&_estack);
+#endif
+#endif /* BLE_MANAGER_MEMORY_WATERMARK */
 
   /* USER CODE END 1 */
 
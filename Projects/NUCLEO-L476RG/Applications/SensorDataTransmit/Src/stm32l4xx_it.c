@@ -25,6 +25,7 @@
 #include "stm32l4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "SensorDataTransmit_config.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -230,5 +231,14 @@ void EXTI15_10_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+#ifdef SENSOR_DT_LOW_POWER
+/**
+  * @brief This function handles LPTIM1 global interrupt (only used for waking up from STOP2).
+  */
+void LPTIM1_IRQHandler(void)
+{
+  LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+}
+#endif /* SENSOR_DT_LOW_POWER */
 
 /* USER CODE END 1 */